@@ -41,9 +41,17 @@ int docmd_clx(arg_struct *arg) {
 }
 
 int docmd_enter(arg_struct *arg) {
-    vartype *v = dup_vartype(stack[sp]);
-    if (v == NULL)
-        return ERR_INSUFFICIENT_MEMORY;
+    vartype *v;
+    if (!flags.f.big_stack && scalar_reusable(stack[REG_T], stack[REG_X])) {
+        /* T is about to be pushed off the stack anyway */
+        v = stack[REG_T];
+        copy_scalar(v, stack[REG_X]);
+        stack[REG_T] = NULL;
+    } else {
+        v = dup_vartype(stack[sp]);
+        if (v == NULL)
+            return ERR_INSUFFICIENT_MEMORY;
+    }
     char prev_stack_lift = flags.f.stack_lift_disable;
     flags.f.stack_lift_disable = 0;
     if (recall_result_silently(v) != ERR_NONE) {
@@ -106,6 +114,15 @@ int docmd_chs(arg_struct *arg) {
                 cm->array->data[i] = -(cm->array->data[i]);
             break;
         }
+        case TYPE_SPARSEMATRIX: {
+            vartype_sparsematrix *sm = (vartype_sparsematrix *) stack[sp];
+            if (!disentangle((vartype *) sm))
+                return ERR_INSUFFICIENT_MEMORY;
+            int4 nnz = sm->nnz();
+            for (int4 i = 0; i < nnz; i++)
+                sm->array->values[i] = -(sm->array->values[i]);
+            break;
+        }
         default:
             return ERR_INTERNAL_ERROR;
     }
@@ -646,7 +663,7 @@ int docmd_rdxcomma(arg_struct *arg) {
 }
 
 int docmd_clsigma(arg_struct *arg) {
-    vartype *regs = recall_var("REGS", 4);
+    vartype *regs = recall_regs();
     vartype_realmatrix *r;
     int4 first = mode_sigma_reg;
     int4 last = first + (flags.f.all_sigma ? 13 : 6);
@@ -659,11 +676,10 @@ int docmd_clsigma(arg_struct *arg) {
     size = r->rows * r->columns;
     if (last > size)
         return ERR_SIZE_ERROR;
+    if (!disentangle(regs))
+        return ERR_INSUFFICIENT_MEMORY;
     for (i = first; i < last; i++) {
-        if (r->array->is_string[i] == 2)
-            free(*(void **) &r->array->data[i]);
-        r->array->is_string[i] = 0;
-        r->array->data[i] = 0;
+        put_matrix_number(r, i, 0);
     }
     flags.f.log_fit_invalid = 0;
     flags.f.exp_fit_invalid = 0;
@@ -723,7 +739,7 @@ int docmd_clst(arg_struct *arg) {
 }
 
 int docmd_clrg(arg_struct *arg) {
-    vartype *regs = recall_var("REGS", 4);
+    vartype *regs = recall_regs();
     if (regs == NULL)
         return ERR_NONEXISTENT;
     if (regs->type == TYPE_REALMATRIX) {
@@ -733,11 +749,14 @@ int docmd_clrg(arg_struct *arg) {
             return ERR_INSUFFICIENT_MEMORY;
         rm = (vartype_realmatrix *) regs;
         sz = rm->rows * rm->columns;
-        free_long_strings(rm->array->is_string, rm->array->data, sz);
+        if (rm->array->is_string != NULL) {
+            free_long_strings(rm->array->is_string, rm->array->data, sz);
+            free(rm->array->is_string);
+            rm->array->is_string = NULL;
+            rm->array->nstrings = 0;
+        }
         for (i = 0; i < sz; i++)
             rm->array->data[i] = 0;
-        for (i = 0; i < sz; i++)
-            rm->array->is_string[i] = 0;
         return ERR_NONE;
     } else if (regs->type == TYPE_COMPLEXMATRIX) {
         vartype_complexmatrix *cm;
@@ -1267,7 +1286,7 @@ int docmd_sign(arg_struct *arg) {
                 return ERR_INSUFFICIENT_MEMORY;
             size = src->rows * src->columns;
             for (i = 0; i < size; i++) {
-                if (src->array->is_string[i] != 0)
+                if (src->array->str(i) != 0)
                     dst->array->data[i] = 0;
                 else
                     dst->array->data[i] = src->array->data[i] < 0 ? -1 : 1;
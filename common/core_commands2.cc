@@ -683,7 +683,7 @@ static int generic_loop(arg_struct *arg, bool isg) {
     }
     switch (arg->type) {
         case ARGTYPE_NUM: {
-            vartype *regs = recall_var("REGS", 4);
+            vartype *regs = recall_regs();
             if (regs == NULL)
                 return ERR_SIZE_ERROR;
             else if (regs->type == TYPE_REALMATRIX) {
@@ -692,7 +692,7 @@ static int generic_loop(arg_struct *arg, bool isg) {
                 int4 index = arg->val.num;
                 if (index >= size)
                     return ERR_SIZE_ERROR;
-                if (rm->array->is_string[index] != 0)
+                if (rm->array->str(index) != 0)
                     return ERR_ALPHA_DATA_IS_INVALID;
                 else {
                     if (!disentangle(regs))
@@ -784,7 +784,7 @@ int docmd_xtoa(arg_struct *arg) {
         char buf[44];
         int buflen = 0;
         for (i = size - 1; i >= 0; i--) {
-            if (m->array->is_string[i] != 0) {
+            if (m->array->str(i) != 0) {
                 int4 len;
                 char *text;
                 get_matrix_string(m, i, &text, &len);
@@ -1067,7 +1067,7 @@ static const sigma_label_spec sigma_labels[] = {
 };
 
 int docmd_prsigma(arg_struct *arg) {
-    vartype *regs = recall_var("REGS", 4);
+    vartype *regs = recall_regs();
     vartype_realmatrix *rm;
     int nr;
     int4 size, max, i;
@@ -1093,7 +1093,7 @@ int docmd_prsigma(arg_struct *arg) {
     print_text(NULL, 0, true);
     for (i = 0; i < nr; i++) {
         int4 j = i + mode_sigma_reg;
-        if (rm->array->is_string[j] != 0) {
+        if (rm->array->str(j) != 0) {
             char *text;
             int4 len;
             get_matrix_string(rm, j, &text, &len);
@@ -1182,6 +1182,8 @@ int docmd_prv(arg_struct *arg) {
 
         if (v->type == TYPE_REALMATRIX
                 || v->type == TYPE_COMPLEXMATRIX
+                || v->type == TYPE_SPARSEMATRIX
+                && ((vartype_sparsematrix *) v)->nnz() > 0
                 || v->type == TYPE_LIST
                 && ((vartype_list *) v)->size > 0) {
             prv_var = v;
@@ -1224,7 +1226,7 @@ static int prv_worker(bool interrupted) {
             llen += int2string(j + 1, lbuf + llen, 32 - llen);
             char2buf(lbuf, 32, &llen, '=');
         }
-        if (rm->array->is_string[prv_index] != 0) {
+        if (rm->array->str(prv_index) != 0) {
             char *text;
             int4 len;
             get_matrix_string(rm, prv_index, &text, &len);
@@ -1266,6 +1268,28 @@ static int prv_worker(bool interrupted) {
         cpx.im = cm->array->data[2 * prv_index + 1];
         rlen = vartype2string((vartype *) &cpx, rbuf, 100);
         print_wide(lbuf, llen, rbuf, rlen);
+    } else if (prv_var->type == TYPE_SPARSEMATRIX) {
+        /* Only the nonzero elements are printed */
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) prv_var;
+        const int4 *rowptr = sm->array->rowptr;
+        sz = sm->nnz();
+        int4 lo = 0, hi = sm->rows - 1;
+        while (lo < hi) {
+            int4 mid = (lo + hi + 1) / 2;
+            if (rowptr[mid] <= prv_index)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        i = lo;
+        j = sm->array->colidx[prv_index];
+        llen = int2string(i + 1, lbuf, 32);
+        char2buf(lbuf, 32, &llen, ':');
+        llen += int2string(j + 1, lbuf + llen, 32 - llen);
+        char2buf(lbuf, 32, &llen, '=');
+        rlen = easy_phloat2string(sm->array->values[prv_index],
+                                    rbuf, 100, 0);
+        print_wide(lbuf, llen, rbuf, rlen);
     } else /* prv_var->type == TYPE_LIST */ {
         vartype_list *list = (vartype_list *) prv_var;
         i = prv_index;
@@ -1300,7 +1324,7 @@ static int prv_worker(bool interrupted) {
 }
 
 int docmd_prreg(arg_struct *arg) {
-    vartype *regs = recall_var("REGS", 4);
+    vartype *regs = recall_regs();
     if (regs == NULL)
         return ERR_NONEXISTENT;
     if (!flags.f.printer_enable && program_running())
@@ -1466,6 +1490,8 @@ int docmd_prx(arg_struct *arg) {
 
         if (arg != NULL && (stack[sp]->type == TYPE_REALMATRIX
                             || stack[sp]->type == TYPE_COMPLEXMATRIX
+                            || stack[sp]->type == TYPE_SPARSEMATRIX
+                            && ((vartype_sparsematrix *) stack[sp])->nnz() > 0
                             || stack[sp]->type == TYPE_LIST
                             && ((vartype_list *) stack[sp])->size > 0)) {
             prv_var = stack[sp];
@@ -1817,7 +1843,8 @@ int docmd_str_t(arg_struct *arg) {
 
 int docmd_mat_t(arg_struct *arg) {
     return stack[sp]->type == TYPE_REALMATRIX
-            || stack[sp]->type == TYPE_COMPLEXMATRIX ? ERR_YES : ERR_NO;
+            || stack[sp]->type == TYPE_COMPLEXMATRIX
+            || stack[sp]->type == TYPE_SPARSEMATRIX ? ERR_YES : ERR_NO;
 }
 
 int docmd_dim_t(arg_struct *arg) {
@@ -1825,6 +1852,9 @@ int docmd_dim_t(arg_struct *arg) {
     if (stack[sp]->type == TYPE_REALMATRIX) {
         rows = ((vartype_realmatrix *) stack[sp])->rows;
         columns = ((vartype_realmatrix *) stack[sp])->columns;
+    } else if (stack[sp]->type == TYPE_SPARSEMATRIX) {
+        rows = ((vartype_sparsematrix *) stack[sp])->rows;
+        columns = ((vartype_sparsematrix *) stack[sp])->columns;
     } else {
         rows = ((vartype_complexmatrix *) stack[sp])->rows;
         columns = ((vartype_complexmatrix *) stack[sp])->columns;
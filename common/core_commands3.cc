@@ -292,10 +292,10 @@ int docmd_cross(arg_struct *arg) {
         if (ls > 3 || rs > 3)
             return ERR_DIMENSION_ERROR;
         for (i = 0; i < ls; i++)
-            if (left->array->is_string[i] != 0)
+            if (left->array->str(i) != 0)
                 return ERR_ALPHA_DATA_IS_INVALID;
         for (i = 0; i < rs; i++)
-            if (right->array->is_string[i] != 0)
+            if (right->array->str(i) != 0)
                 return ERR_ALPHA_DATA_IS_INVALID;
         switch (ls) {
             case 3: zl = left->array->data[2];
@@ -359,6 +359,8 @@ int docmd_delr(arg_struct *arg) {
     err = matedit_get(&m);
     if (err != ERR_NONE)
         return err;
+    if (m->type == TYPE_SPARSEMATRIX)
+        return ERR_INVALID_TYPE;
 
     if (m->type == TYPE_REALMATRIX) {
         rm = (vartype_realmatrix *) m;
@@ -401,7 +403,7 @@ int docmd_delr(arg_struct *arg) {
     interactive = matedit_mode == 2 || matedit_mode == 3;
     if (interactive) {
         if (m->type == TYPE_REALMATRIX) {
-            if (rm->array->is_string[n] != 0) {
+            if (rm->array->str(n) != 0) {
                 char *text;
                 int4 len;
                 get_matrix_string(rm, n, &text, &len);
@@ -430,17 +432,20 @@ int docmd_delr(arg_struct *arg) {
          * of all, no temporary memory allocations needed!
          */
         if (m->type == TYPE_REALMATRIX) {
+            char *is_string = rm->array->is_string;
             for (j = 0; j < columns; j++) {
                 phloat tempd = rm->array->data[matedit_i * columns + j];
-                char tempc = rm->array->is_string[matedit_i * columns + j];
-                for (i = matedit_i; i < rows - 1; i++) {
+                for (i = matedit_i; i < rows - 1; i++)
                     rm->array->data[i * columns + j] =
                                 rm->array->data[(i + 1) * columns + j];
-                    rm->array->is_string[i * columns + j] =
-                                rm->array->is_string[(i + 1) * columns + j];
-                }
                 rm->array->data[(rows - 1) * columns + j] = tempd;
-                rm->array->is_string[(rows - 1) * columns + j] = tempc;
+                if (is_string != NULL) {
+                    char tempc = is_string[matedit_i * columns + j];
+                    for (i = matedit_i; i < rows - 1; i++)
+                        is_string[i * columns + j] =
+                                is_string[(i + 1) * columns + j];
+                    is_string[(rows - 1) * columns + j] = tempc;
+                }
             }
             err = dimension_array_ref(m, rows - 1, columns);
             if (err != ERR_NONE) {
@@ -448,15 +453,17 @@ int docmd_delr(arg_struct *arg) {
                  * it was before. */
                 for (j = 0; j < columns; j++) {
                     phloat tempd = rm->array->data[(rows - 1) * columns + j];
-                    char tempc = rm->array->is_string[(rows - 1) * columns + j];
-                    for (i = rows - 1; i > matedit_i; i--) {
+                    for (i = rows - 1; i > matedit_i; i--)
                         rm->array->data[i * columns + j] =
                                     rm->array->data[(i - 1) * columns + j];
-                        rm->array->is_string[i * columns + j] =
-                                    rm->array->is_string[(i - 1) * columns + j];
-                    }
                     rm->array->data[matedit_i * columns + j] = tempd;
-                    rm->array->is_string[matedit_i * columns + j] = tempc;
+                    if (is_string != NULL) {
+                        char tempc = is_string[(rows - 1) * columns + j];
+                        for (i = rows - 1; i > matedit_i; i--)
+                            is_string[i * columns + j] =
+                                    is_string[(i - 1) * columns + j];
+                        is_string[matedit_i * columns + j] = tempc;
+                    }
                 }
                 if (interactive)
                     free_vartype(newx);
@@ -498,40 +505,39 @@ int docmd_delr(arg_struct *arg) {
          * does not deal with resizing. */
         int4 newsize = (rows - 1) * columns;
         if (m->type == TYPE_REALMATRIX) {
-            realmatrix_data *array = (realmatrix_data *)
-                                malloc(sizeof(realmatrix_data));
-            if (array == NULL) {
-                if (interactive)
-                    free_vartype(newx);
-                return ERR_INSUFFICIENT_MEMORY;
-            }
-            array->data = (phloat *) malloc(newsize * sizeof(phloat));
-            if (array->data == NULL) {
-                if (interactive)
-                    free_vartype(newx);
-                free(array);
-                return ERR_INSUFFICIENT_MEMORY;
-            }
-            array->is_string = (char *) malloc(newsize);
-            if (array->is_string == NULL) {
+            realmatrix_data *array = new_realmatrix_data(newsize);
+            if (array == NULL
+                    || (rm->array->is_string != NULL && !alloc_string_map(array))) {
                 if (interactive)
                     free_vartype(newx);
-                free(array->data);
                 free(array);
                 return ERR_INSUFFICIENT_MEMORY;
             }
-            for (i = 0; i < matedit_i * columns; i++) {
-                array->is_string[i] = rm->array->is_string[i];
-                array->data[i] = rm->array->data[i];
-            }
-            for (i = matedit_i * columns; i < (matedit_i + 1) * columns; i++)
-                if (array->is_string[i] == 2)
-                    free(*(void **) &array->data[i]);
-            for (i = matedit_i * columns; i < newsize; i++) {
-                array->is_string[i] = rm->array->is_string[i + columns];
-                array->data[i] = rm->array->data[i + columns];
+            /* The long strings are shared with the other references, so
+             * they have to be copied, not moved.
+             */
+            for (i = 0; i < newsize; i++) {
+                int4 k = i < matedit_i * columns ? i : i + columns;
+                char c = rm->array->str(k);
+                if (c == 2) {
+                    int4 *sp = *(int4 **) &rm->array->data[k];
+                    int4 *dp = (int4 *) malloc(*sp + 4);
+                    if (dp == NULL) {
+                        array->size = i;
+                        free_realmatrix_data(array);
+                        if (interactive)
+                            free_vartype(newx);
+                        return ERR_INSUFFICIENT_MEMORY;
+                    }
+                    memcpy(dp, sp, *sp + 4);
+                    *(int4 **) &array->data[i] = dp;
+                } else
+                    array->data[i] = rm->array->data[k];
+                if (c != 0) {
+                    array->is_string[i] = c;
+                    array->nstrings++;
+                }
             }
-            array->refcount = 1;
             rm->array->refcount--;
             rm->array = array;
             rm->rows--;
@@ -585,6 +591,8 @@ int docmd_delr(arg_struct *arg) {
                 }
             }
             array->refcount = 1;
+            array->capacity = newsize;
+            array->hash = 0;
             list->array->refcount--;
             list->array = array;
             list->size--;
@@ -664,7 +672,7 @@ int docmd_dot(arg_struct *arg) {
         if (contains_strings(rm1) || contains_strings(rm2))
             return ERR_ALPHA_DATA_IS_INVALID;
         for (i = 0; i < size; i++)
-            dot += rm1->array->data[i] * rm2->array->data[i];
+            dot += rm1->array->data[rm1->index(i)] * rm2->array->data[rm2->index(i)];
         if ((inf = p_isinf(dot)) != 0) {
             if (flags.f.range_error_ignore)
                 dot = inf < 0 ? NEG_HUGE_PHLOAT : POS_HUGE_PHLOAT;
@@ -695,8 +703,10 @@ int docmd_dot(arg_struct *arg) {
         if (contains_strings(rm))
             return ERR_ALPHA_DATA_IS_INVALID;
         for (i = 0; i < size; i++) {
-            dot_re += rm->array->data[i] * cm->array->data[2 * i];
-            dot_im += rm->array->data[i] * cm->array->data[2 * i + 1];
+            phloat r = rm->array->data[rm->index(i)];
+            int4 c = 2 * cm->index(i);
+            dot_re += r * cm->array->data[c];
+            dot_im += r * cm->array->data[c + 1];
         }
         if ((inf = p_isinf(dot_re)) != 0) {
             if (flags.f.range_error_ignore)
@@ -721,12 +731,13 @@ int docmd_dot(arg_struct *arg) {
         size = cm1->rows * cm1->columns;
         if (size != cm2->rows * cm2->columns)
             return ERR_DIMENSION_ERROR;
-        size *= 2;
-        for (i = 0; i < size; i += 2) {
-            phloat re1 = cm1->array->data[i];
-            phloat im1 = cm1->array->data[i + 1];
-            phloat re2 = cm2->array->data[i];
-            phloat im2 = cm2->array->data[i + 1];
+        for (i = 0; i < size; i++) {
+            int4 c1 = 2 * cm1->index(i);
+            int4 c2 = 2 * cm2->index(i);
+            phloat re1 = cm1->array->data[c1];
+            phloat im1 = cm1->array->data[c1 + 1];
+            phloat re2 = cm2->array->data[c2];
+            phloat im2 = cm2->array->data[c2 + 1];
             dot_re += re1 * re2 - im1 * im2;
             dot_im += re1 * im2 + re2 * im1;
         }
@@ -755,6 +766,55 @@ int docmd_dot(arg_struct *arg) {
                 return ERR_OUT_OF_RANGE;
         }
         v = new_real(d);
+    } else if ((stack[sp]->type == TYPE_SPARSEMATRIX
+                    && (stack[sp - 1]->type == TYPE_SPARSEMATRIX
+                        || stack[sp - 1]->type == TYPE_REALMATRIX))
+                ||
+               (stack[sp]->type == TYPE_REALMATRIX
+                    && stack[sp - 1]->type == TYPE_SPARSEMATRIX)) {
+        /* Only the nonzero elements of the sparse operand contribute;
+         * the other operand is looked up at the same position, taking
+         * both matrices in row-major order, like the dense case.
+         */
+        vartype_sparsematrix *sm;
+        vartype *other;
+        if (stack[sp]->type == TYPE_SPARSEMATRIX) {
+            sm = (vartype_sparsematrix *) stack[sp];
+            other = stack[sp - 1];
+        } else {
+            sm = (vartype_sparsematrix *) stack[sp - 1];
+            other = stack[sp];
+        }
+        sparsematrix_data *sd = sm->array;
+        phloat dot = 0;
+        int inf;
+        if (other->type == TYPE_REALMATRIX) {
+            vartype_realmatrix *rm = (vartype_realmatrix *) other;
+            if (sm->rows * sm->columns != rm->rows * rm->columns)
+                return ERR_DIMENSION_ERROR;
+            if (contains_strings(rm))
+                return ERR_ALPHA_DATA_IS_INVALID;
+            for (int4 i = 0; i < sm->rows; i++)
+                for (int4 k = sd->rowptr[i]; k < sd->rowptr[i + 1]; k++)
+                    dot += sd->values[k]
+                        * rm->array->data[rm->index(i * sm->columns + sd->colidx[k])];
+        } else {
+            vartype_sparsematrix *sm2 = (vartype_sparsematrix *) other;
+            if (sm->rows * sm->columns != sm2->rows * sm2->columns)
+                return ERR_DIMENSION_ERROR;
+            for (int4 i = 0; i < sm->rows; i++)
+                for (int4 k = sd->rowptr[i]; k < sd->rowptr[i + 1]; k++) {
+                    int4 p = i * sm->columns + sd->colidx[k];
+                    dot += sd->values[k] * sparse_get(sm2, p / sm2->columns, p % sm2->columns);
+                }
+        }
+        if ((inf = p_isinf(dot)) != 0) {
+            if (flags.f.range_error_ignore)
+                dot = inf < 0 ? NEG_HUGE_PHLOAT : POS_HUGE_PHLOAT;
+            else
+                return ERR_OUT_OF_RANGE;
+        }
+        v = new_real(dot);
     } else
         return ERR_INVALID_TYPE;
     if (v == NULL)
@@ -777,6 +837,10 @@ int matedit_get_dim(int4 *rows, int4 *columns, vartype **res) {
         vartype_complexmatrix *cm = (vartype_complexmatrix *) m;
         *rows = cm->rows;
         *columns = cm->columns;
+    } else if (m->type == TYPE_SPARSEMATRIX) {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) m;
+        *rows = sm->rows;
+        *columns = sm->columns;
     } else { // TYPE_LIST
         vartype_list *list = (vartype_list *) m;
         *rows = list->size;
@@ -876,13 +940,14 @@ int docmd_edit(arg_struct *arg) {
         return err;
     if (stack[sp]->type != TYPE_REALMATRIX
             && stack[sp]->type != TYPE_COMPLEXMATRIX
+            && stack[sp]->type != TYPE_SPARSEMATRIX
             && stack[sp]->type != TYPE_LIST)
         return ERR_INVALID_TYPE;
 
     vartype *v;
     if (stack[sp]->type == TYPE_REALMATRIX) {
         vartype_realmatrix *rm = (vartype_realmatrix *) stack[sp];
-        if (rm->array->is_string[0] != 0) {
+        if (rm->array->str(0) != 0) {
             char *text;
             int4 len;
             get_matrix_string(rm, 0, &text, &len);
@@ -892,6 +957,8 @@ int docmd_edit(arg_struct *arg) {
     } else if (stack[sp]->type == TYPE_COMPLEXMATRIX) {
         vartype_complexmatrix *cm = (vartype_complexmatrix *) stack[sp];
         v = new_complex(cm->array->data[0], cm->array->data[1]);
+    } else if (stack[sp]->type == TYPE_SPARSEMATRIX) {
+        v = new_real(sparse_get((vartype_sparsematrix *) stack[sp], 0, 0));
     } else {
         vartype_list *list = (vartype_list *) stack[sp];
         if (list->size == 0)
@@ -949,13 +1016,14 @@ int docmd_editn(arg_struct *arg) {
     m = vars[mi].value;
     if (m->type != TYPE_REALMATRIX
             && m->type != TYPE_COMPLEXMATRIX
+            && m->type != TYPE_SPARSEMATRIX
             && m->type != TYPE_LIST)
         return ERR_INVALID_TYPE;
 
     vartype *v;
     if (m->type == TYPE_REALMATRIX) {
         vartype_realmatrix *rm = (vartype_realmatrix *) m;
-        if (rm->array->is_string[0] != 0) {
+        if (rm->array->str(0) != 0) {
             char *text;
             int4 len;
             get_matrix_string(rm , 0, &text, &len);
@@ -965,6 +1033,8 @@ int docmd_editn(arg_struct *arg) {
     } else if (m->type == TYPE_COMPLEXMATRIX) {
         vartype_complexmatrix *cm = (vartype_complexmatrix *) m;
         v = new_complex(cm->array->data[0], cm->array->data[1]);
+    } else if (m->type == TYPE_SPARSEMATRIX) {
+        v = new_real(sparse_get((vartype_sparsematrix *) m, 0, 0));
     } else {
         vartype_list *list = (vartype_list *) m;
         if (list->size == 0)
@@ -1125,7 +1195,7 @@ int docmd_getm(arg_struct *arg) {
     int err = matedit_get(&m);
     if (err != ERR_NONE)
         return err;
-    if (m->type == TYPE_LIST)
+    if (m->type == TYPE_LIST || m->type == TYPE_SPARSEMATRIX)
         return ERR_INVALID_TYPE;
 
     if (stack[sp]->type == TYPE_STRING)
@@ -1144,52 +1214,22 @@ int docmd_getm(arg_struct *arg) {
         return ERR_DIMENSION_ERROR;
     y++;
 
+    int4 rows, columns;
     if (m->type == TYPE_REALMATRIX) {
-        vartype_realmatrix *src, *dst;
-        int4 i, j;
-        src = (vartype_realmatrix *) m;
-        if (src->rows < matedit_i + y || src->columns < matedit_j + x)
-            return ERR_DIMENSION_ERROR;
-        dst = (vartype_realmatrix *) new_realmatrix(y, x);
-        if (dst == NULL)
-            return ERR_INSUFFICIENT_MEMORY;
-        for (i = 0; i < y; i++)
-            for (j = 0; j < x; j++) {
-                int4 n1 = (i + matedit_i) * src->columns + j + matedit_j;
-                int4 n2 = i * dst->columns + j;
-                if (src->array->is_string[n1] == 2) {
-                    int4 *sp = *(int4 **) &src->array->data[n1];
-                    int4 *dp = (int4 *) malloc(*sp + 4);
-                    if (dp == NULL) {
-                        free_vartype((vartype *) dst);
-                        return ERR_INSUFFICIENT_MEMORY;
-                    }
-                    memcpy(dp, sp, *sp + 4);
-                    *(int4 **) &dst->array->data[n2] = dp;
-                } else {
-                    dst->array->data[n2] = src->array->data[n1];
-                }
-                dst->array->is_string[n2] = src->array->is_string[n1];
-            }
-        return binary_result((vartype *) dst);
+        vartype_realmatrix *rm = (vartype_realmatrix *) m;
+        rows = rm->rows;
+        columns = rm->columns;
     } else /* m->type == TYPE_COMPLEXMATRIX */ {
-        vartype_complexmatrix *src, *dst;
-        int4 i, j;
-        src = (vartype_complexmatrix *) m;
-        if (src->rows < matedit_i + y || src->columns < matedit_j + x)
-            return ERR_DIMENSION_ERROR;
-        dst = (vartype_complexmatrix *) new_complexmatrix(y, x);
-        if (dst == NULL)
-            return ERR_INSUFFICIENT_MEMORY;
-        for (i = 0; i < y; i++)
-            for (j = 0; j < x; j++) {
-                int4 n1 = (i + matedit_i) * src->columns + j + matedit_j;
-                int4 n2 = i * dst->columns + j;
-                dst->array->data[n2 * 2] = src->array->data[n1 * 2];
-                dst->array->data[n2 * 2 + 1] = src->array->data[n1 * 2 + 1];
-            }
-        return binary_result((vartype *) dst);
+        vartype_complexmatrix *cm = (vartype_complexmatrix *) m;
+        rows = cm->rows;
+        columns = cm->columns;
     }
+    if (rows < matedit_i + y || columns < matedit_j + x)
+        return ERR_DIMENSION_ERROR;
+    vartype *v = new_matrix_view(m, matedit_i, matedit_j, y, x);
+    if (v == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    return binary_result(v);
 }
 
 int docmd_grow(arg_struct *arg) {
@@ -1447,6 +1487,7 @@ int docmd_index(arg_struct *arg) {
     m = vars[mi].value;
     if (m->type != TYPE_REALMATRIX
             && m->type != TYPE_COMPLEXMATRIX
+            && m->type != TYPE_SPARSEMATRIX
             && m->type != TYPE_LIST)
         return ERR_INVALID_TYPE;
 
@@ -45,6 +45,8 @@ int docmd_insr(arg_struct *arg) {
     err = matedit_get(&m);
     if (err != ERR_NONE)
         return err;
+    if (m->type == TYPE_SPARSEMATRIX)
+        return ERR_INVALID_TYPE;
 
     interactive = matedit_mode == 2 || matedit_mode == 3;
     if (interactive && sp != -1) {
@@ -101,12 +103,15 @@ int docmd_insr(arg_struct *arg) {
         }
         rows++;
         if (m->type == TYPE_REALMATRIX) {
+            char *is_string = rm->array->is_string;
             for (i = rows * columns - 1; i >= (matedit_i + 1) * columns; i--) {
-                rm->array->is_string[i] = rm->array->is_string[i - columns];
+                if (is_string != NULL)
+                    is_string[i] = is_string[i - columns];
                 rm->array->data[i] = rm->array->data[i - columns];
             }
             for (i = matedit_i * columns; i < (matedit_i + 1) * columns; i++) {
-                rm->array->is_string[i] = 0;
+                if (is_string != NULL)
+                    is_string[i] = 0;
                 rm->array->data[i] = 0;
             }
         } else if (m->type == TYPE_COMPLEXMATRIX) {
@@ -142,41 +147,43 @@ int docmd_insr(arg_struct *arg) {
          * does not deal with resizing. */
         int4 newsize = (rows + 1) * columns;
         if (m->type == TYPE_REALMATRIX) {
-            realmatrix_data *array = (realmatrix_data *)
-                                malloc(sizeof(realmatrix_data));
-            if (array == NULL) {
-                if (interactive)
-                    free_vartype(newx);
-                return ERR_INSUFFICIENT_MEMORY;
-            }
-            array->data = (phloat *) malloc(newsize * sizeof(phloat));
-            if (array->data == NULL) {
+            realmatrix_data *array = new_realmatrix_data(newsize);
+            if (array == NULL
+                    || (rm->array->is_string != NULL && !alloc_string_map(array))) {
                 if (interactive)
                     free_vartype(newx);
                 free(array);
                 return ERR_INSUFFICIENT_MEMORY;
             }
-            array->is_string = (char *) malloc(newsize);
-            if (array->is_string == NULL) {
-                if (interactive)
-                    free_vartype(newx);
-                free(array->data);
-                free(array);
-                return ERR_INSUFFICIENT_MEMORY;
-            }
-            for (i = 0; i < matedit_i * columns; i++) {
-                array->is_string[i] = rm->array->is_string[i];
-                array->data[i] = rm->array->data[i];
-            }
-            for (i = matedit_i * columns; i < (matedit_i + 1) * columns; i++) {
-                array->is_string[i] = 0;
-                array->data[i] = 0;
-            }
-            for (i = (matedit_i + 1) * columns; i < newsize; i++) {
-                array->is_string[i] = rm->array->is_string[i - columns];
-                array->data[i] = rm->array->data[i - columns];
+            /* The long strings are shared with the other references, so
+             * they have to be copied, not moved.
+             */
+            for (i = 0; i < newsize; i++) {
+                if (i >= matedit_i * columns && i < (matedit_i + 1) * columns) {
+                    array->data[i] = 0;
+                    continue;
+                }
+                int4 k = i < matedit_i * columns ? i : i - columns;
+                char c = rm->array->str(k);
+                if (c == 2) {
+                    int4 *sp = *(int4 **) &rm->array->data[k];
+                    int4 *dp = (int4 *) malloc(*sp + 4);
+                    if (dp == NULL) {
+                        array->size = i;
+                        free_realmatrix_data(array);
+                        if (interactive)
+                            free_vartype(newx);
+                        return ERR_INSUFFICIENT_MEMORY;
+                    }
+                    memcpy(dp, sp, *sp + 4);
+                    *(int4 **) &array->data[i] = dp;
+                } else
+                    array->data[i] = rm->array->data[k];
+                if (c != 0) {
+                    array->is_string[i] = c;
+                    array->nstrings++;
+                }
             }
-            array->refcount = 1;
             rm->array->refcount--;
             rm->array = array;
             rm->rows++;
@@ -235,6 +242,8 @@ int docmd_insr(arg_struct *arg) {
                 }
             }
             array->refcount = 1;
+            array->capacity = newsize;
+            array->hash = 0;
             list->array->refcount--;
             list->array = array;
             list->size++;
@@ -278,11 +287,8 @@ int docmd_j_add(arg_struct *arg) {
             if (matedit_i == list->size - 1 && flags.f.grow) {
                 if (!disentangle((vartype *) list))
                     return ERR_INSUFFICIENT_MEMORY;
-                int4 newsize = list->size + 1;
-                vartype **newdata = (vartype **) realloc(list->array->data, newsize * sizeof(vartype *));
-                if (newdata == NULL)
+                if (!reserve_list(list, list->size + 1))
                     return ERR_INSUFFICIENT_MEMORY;
-                list->array->data = newdata;
                 vartype *zero = new_real(0);
                 if (zero == NULL)
                     return ERR_INSUFFICIENT_MEMORY;
@@ -452,12 +458,13 @@ int docmd_putm(arg_struct *arg) {
     int err = matedit_get(&m);
     if (err != ERR_NONE)
         return err;
-    if (m->type == TYPE_LIST)
+    if (m->type == TYPE_LIST || m->type == TYPE_SPARSEMATRIX)
         return ERR_INVALID_TYPE;
 
     if (stack[sp]->type == TYPE_STRING)
         return ERR_ALPHA_DATA_IS_INVALID;
-    else if (stack[sp]->type == TYPE_REAL || stack[sp]->type == TYPE_COMPLEX)
+    else if (stack[sp]->type == TYPE_REAL || stack[sp]->type == TYPE_COMPLEX
+            || stack[sp]->type == TYPE_SPARSEMATRIX)
         return ERR_INVALID_TYPE;
 
     if (m->type == TYPE_REALMATRIX) {
@@ -483,13 +490,24 @@ int docmd_putm(arg_struct *arg) {
             return ERR_INSUFFICIENT_MEMORY;
         }
         src = (vartype_realmatrix *) v;
+        if ((src->array->is_string != NULL || dst->array->is_string != NULL)
+                && (!alloc_string_map(src->array)
+                    || !alloc_string_map(dst->array))) {
+            free_vartype(v);
+            return ERR_INSUFFICIENT_MEMORY;
+        }
         for (i = 0; i < src->rows; i++)
             for (j = 0; j < src->columns; j++) {
                 int4 n1 = i * src->columns + j;
                 int4 n2 = (i + matedit_i) * dst->columns + j + matedit_j;
-                char tc = dst->array->is_string[n2];
-                dst->array->is_string[n2] = src->array->is_string[n1];
-                src->array->is_string[n1] = tc;
+                if (dst->array->is_string != NULL) {
+                    char tc = dst->array->is_string[n2];
+                    char sc = src->array->is_string[n1];
+                    dst->array->is_string[n2] = sc;
+                    src->array->is_string[n1] = tc;
+                    dst->array->nstrings += (sc != 0) - (tc != 0);
+                    src->array->nstrings += (tc != 0) - (sc != 0);
+                }
                 phloat tp = dst->array->data[n2];
                 dst->array->data[n2] = src->array->data[n1];
                 src->array->data[n1] = tp;
@@ -542,7 +560,7 @@ int docmd_rclel(arg_struct *arg) {
     if (m->type == TYPE_REALMATRIX) {
         vartype_realmatrix *rm = (vartype_realmatrix *) m;
         int4 n = matedit_i * rm->columns + matedit_j;
-        if (rm->array->is_string[n] != 0) {
+        if (rm->array->str(n) != 0) {
             char *text;
             int4 length;
             get_matrix_string(rm, n, &text, &length);
@@ -554,6 +572,9 @@ int docmd_rclel(arg_struct *arg) {
         int4 n = matedit_i * cm->columns + matedit_j;
         v = new_complex(cm->array->data[2 * n],
                         cm->array->data[2 * n + 1]);
+    } else if (m->type == TYPE_SPARSEMATRIX) {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) m;
+        v = new_real(sparse_get(sm, matedit_i, matedit_j));
     } else {
         vartype_list *list = (vartype_list *) m;
         if (list->size == 0)
@@ -588,7 +609,7 @@ int docmd_rnrm(arg_struct *arg) {
         for (int4 i = 0; i < rm->rows; i++) {
             phloat nrm = 0;
             for (int4 j = 0; j < rm->columns; j++) {
-                phloat x = rm->array->data[i * rm->columns + j];
+                phloat x = rm->array->data[rm->index(i, j)];
                 if (x >= 0)
                     nrm += x;
                 else
@@ -617,8 +638,8 @@ int docmd_rnrm(arg_struct *arg) {
         for (i = 0; i < cm->rows; i++) {
             phloat nrm = 0;
             for (j = 0; j < cm->columns; j++) {
-                phloat re = cm->array->data[2 * (i * cm->columns + j)];
-                phloat im = cm->array->data[2 * (i * cm->columns + j) + 1];
+                phloat re = cm->array->data[2 * cm->index(i, j)];
+                phloat im = cm->array->data[2 * cm->index(i, j) + 1];
                 nrm += hypot(re, im);
             }
             if (p_isinf(nrm)) {
@@ -652,7 +673,7 @@ int docmd_rsum(arg_struct *arg) {
             phloat sum = 0;
             int inf;
             for (int4 j = 0; j < rm->columns; j++)
-                sum += rm->array->data[i * rm->columns + j];
+                sum += rm->array->data[rm->index(i, j)];
             if ((inf = p_isinf(sum)) != 0) {
                 if (flags.f.range_error_ignore)
                     sum = inf < 0 ? NEG_HUGE_PHLOAT : POS_HUGE_PHLOAT;
@@ -676,8 +697,8 @@ int docmd_rsum(arg_struct *arg) {
             phloat sum_re = 0, sum_im = 0;
             int inf;
             for (j = 0; j < cm->columns; j++) {
-                sum_re += cm->array->data[2 * (i * cm->columns + j)];
-                sum_im += cm->array->data[2 * (i * cm->columns + j) + 1];
+                sum_re += cm->array->data[2 * cm->index(i, j)];
+                sum_im += cm->array->data[2 * cm->index(i, j) + 1];
             }
             if ((inf = p_isinf(sum_re)) != 0) {
                 if (flags.f.range_error_ignore)
@@ -700,6 +721,30 @@ int docmd_rsum(arg_struct *arg) {
         }
         unary_result((vartype *) res);
         return ERR_NONE;
+    } else if (stack[sp]->type == TYPE_SPARSEMATRIX) {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) stack[sp];
+        sparsematrix_data *sd = sm->array;
+        vartype_realmatrix *res;
+        res = (vartype_realmatrix *) new_realmatrix(sm->rows, 1);
+        if (res == NULL)
+            return ERR_INSUFFICIENT_MEMORY;
+        for (int4 i = 0; i < sm->rows; i++) {
+            phloat sum = 0;
+            int inf;
+            for (int4 k = sd->rowptr[i]; k < sd->rowptr[i + 1]; k++)
+                sum += sd->values[k];
+            if ((inf = p_isinf(sum)) != 0) {
+                if (flags.f.range_error_ignore)
+                    sum = inf < 0 ? NEG_HUGE_PHLOAT : POS_HUGE_PHLOAT;
+                else {
+                    free_vartype((vartype *) res);
+                    return ERR_OUT_OF_RANGE;
+                }
+            }
+            res->array->data[i] = sum;
+        }
+        unary_result((vartype *) res);
+        return ERR_NONE;
     } else if (stack[sp]->type == TYPE_STRING)
         return ERR_ALPHA_DATA_IS_INVALID;
     else
@@ -713,7 +758,7 @@ int docmd_swap_r(arg_struct *arg) {
     int err = matedit_get(&m);
     if (err != ERR_NONE)
         return err;
-    if (m->type == TYPE_LIST)
+    if (m->type == TYPE_LIST || m->type == TYPE_SPARSEMATRIX)
         return ERR_INVALID_TYPE;
 
     if (stack[sp]->type == TYPE_STRING)
@@ -741,12 +786,14 @@ int docmd_swap_r(arg_struct *arg) {
         for (i = 0; i < rm->columns; i++) {
             int4 n1 = x * rm->columns + i;
             int4 n2 = y * rm->columns + i;
-            char tempc = rm->array->is_string[n1];
             phloat tempds = rm->array->data[n1];
-            rm->array->is_string[n1] = rm->array->is_string[n2];
             rm->array->data[n1] = rm->array->data[n2];
-            rm->array->is_string[n2] = tempc;
             rm->array->data[n2] = tempds;
+            if (rm->array->is_string != NULL) {
+                char tempc = rm->array->is_string[n1];
+                rm->array->is_string[n1] = rm->array->is_string[n2];
+                rm->array->is_string[n2] = tempc;
+            }
         }
         return ERR_NONE;
     } else /* m->type == TYPE_COMPLEXMATRIX */ {
@@ -834,10 +881,7 @@ int docmd_stoel(arg_struct *arg) {
         vartype_realmatrix *rm = (vartype_realmatrix *) m;
         int4 n = matedit_i * rm->columns + matedit_j;
         if (stack[sp]->type == TYPE_REAL) {
-            if (rm->array->is_string[n] == 2)
-                free(*(void **) &rm->array->data[n]);
-            rm->array->is_string[n] = 0;
-            rm->array->data[n] = ((vartype_real *) stack[sp])->x;
+            put_matrix_number(rm, n, ((vartype_real *) stack[sp])->x);
             return ERR_NONE;
         } else if (stack[sp]->type == TYPE_STRING) {
             vartype_string *s = (vartype_string *) stack[sp];
@@ -862,6 +906,16 @@ int docmd_stoel(arg_struct *arg) {
             return ERR_ALPHA_DATA_IS_INVALID;
         else
             return ERR_INVALID_TYPE;
+    } else if (m->type == TYPE_SPARSEMATRIX) {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) m;
+        if (stack[sp]->type == TYPE_REAL) {
+            if (!sparse_put(sm, matedit_i, matedit_j, ((vartype_real *) stack[sp])->x))
+                return ERR_INSUFFICIENT_MEMORY;
+            return ERR_NONE;
+        } else if (stack[sp]->type == TYPE_STRING)
+            return ERR_ALPHA_DATA_IS_INVALID;
+        else
+            return ERR_INVALID_TYPE;
     } else /* m->type == TYPE_LIST */ {
         vartype_list *list = (vartype_list *) m;
         if (list->size == 0)
@@ -869,6 +923,10 @@ int docmd_stoel(arg_struct *arg) {
         vartype *v = dup_vartype(stack[sp]);
         if (v == NULL)
             return ERR_INSUFFICIENT_MEMORY;
+        if (is_matrix_view(v) && !disentangle(v)) {
+            free_vartype(v);
+            return ERR_INSUFFICIENT_MEMORY;
+        }
         free_vartype(list->array->data[matedit_i]);
         list->array->data[matedit_i] = v;
         return ERR_NONE;
@@ -905,6 +963,10 @@ int docmd_stoij(arg_struct *arg) {
         vartype_complexmatrix *cm = (vartype_complexmatrix *) m;
         if (i >= cm->rows || j >= cm->columns)
             return ERR_DIMENSION_ERROR;
+    } else if (m->type == TYPE_SPARSEMATRIX) {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) m;
+        if (i >= sm->rows || j >= sm->columns)
+            return ERR_DIMENSION_ERROR;
     } else if (m->type == TYPE_LIST) {
         vartype_list *list = (vartype_list *) m;
         if (i >= list->size || j != 0)
@@ -970,53 +1032,14 @@ int docmd_tanh(arg_struct *arg) {
 }
 
 int docmd_trans(arg_struct *arg) {
-    if (stack[sp]->type == TYPE_REALMATRIX) {
-        vartype_realmatrix *src = (vartype_realmatrix *) stack[sp];
-        vartype_realmatrix *dst;
-        int4 rows = src->rows;
-        int4 columns = src->columns;
-        int4 i, j;
-        dst = (vartype_realmatrix *) new_realmatrix(columns, rows);
-        if (dst == NULL)
-            return ERR_INSUFFICIENT_MEMORY;
-        for (i = 0; i < rows; i++)
-            for (j = 0; j < columns; j++) {
-                int4 n1 = i * columns + j;
-                int4 n2 = j * rows + i;
-                dst->array->is_string[n2] = src->array->is_string[n1];
-                if (dst->array->is_string[n2] == 2) {
-                    int4 *sp = *(int4 **) &src->array->data[n1];
-                    int4 *dp = (int4 *) malloc(*sp + 4);
-                    if (dp == NULL) {
-                        free_vartype((vartype *) dst);
-                        return ERR_INSUFFICIENT_MEMORY;
-                    }
-                    memcpy(dp, sp, *sp + 4);
-                    *(int4 **) &dst->array->data[n2] = dp;
-                } else
-                    dst->array->data[n2] = src->array->data[n1];
-            }
-        unary_result((vartype *) dst);
-        return ERR_NONE;
-    } else {
-        vartype_complexmatrix *src = (vartype_complexmatrix *) stack[sp];
-        vartype_complexmatrix *dst;
-        int4 rows = src->rows;
-        int4 columns = src->columns;
-        int4 i, j;
-        dst = (vartype_complexmatrix *) new_complexmatrix(columns, rows);
-        if (dst == NULL)
-            return ERR_INSUFFICIENT_MEMORY;
-        for (i = 0; i < rows; i++)
-            for (j = 0; j < columns; j++) {
-                int4 n1 = 2 * (i * columns + j);
-                int4 n2 = 2 * (j * rows + i);
-                dst->array->data[n2] = src->array->data[n1];
-                dst->array->data[n2 + 1] = src->array->data[n1 + 1];
-            }
-        unary_result((vartype *) dst);
-        return ERR_NONE;
-    }
+    /* The transpose shares its data with the original; it only gets
+     * copied if some function that doesn't know about views needs it.
+     */
+    vartype *v = new_transpose_view(stack[sp]);
+    if (v == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    unary_result(v);
+    return ERR_NONE;
 }
 
 int docmd_wrap(arg_struct *arg) {
@@ -1123,7 +1146,7 @@ static int matedit_move_list(vartype_list *list, int direction) {
             new_i = 0;
             if (m->type == TYPE_REALMATRIX) {
                 vartype_realmatrix *rm = (vartype_realmatrix *) m;
-                if (rm->array->is_string[0] != 0) {
+                if (rm->array->str(0) != 0) {
                     char *text;
                     int4 len;
                     get_matrix_string(rm, 0, &text, &len);
@@ -1161,12 +1184,9 @@ static int matedit_move_list(vartype_list *list, int direction) {
             }
             if (!disentangle((vartype *) list))
                 goto nomem2;
-            int4 newsize = list->size + 1;
-            vartype **newdata = (vartype **) realloc(list->array->data, newsize * sizeof(vartype *));
-            if (newdata == NULL)
+            if (!reserve_list(list, list->size + 1))
                 goto nomem2;
-            newdata[list->size] = zero1;
-            list->array->data = newdata;
+            list->array->data[list->size] = zero1;
             new_i = list->size++;
             new_x = zero2;
         } else {
@@ -1202,6 +1222,7 @@ static int matedit_move(int direction) {
     vartype *m, *v;
     vartype_realmatrix *rm;
     vartype_complexmatrix *cm;
+    vartype_sparsematrix *sm = NULL;
     int4 rows, columns, new_i, new_j, old_n, new_n;
     int edge_flag = 0;
     int end_flag = 0;
@@ -1228,12 +1249,12 @@ static int matedit_move(int direction) {
         if (reg_x == NULL) {
             changed = false;
         } else if (reg_x->type == TYPE_REAL) {
-            if (rm->array->is_string[old_n] != 0)
+            if (rm->array->str(old_n) != 0)
                 changed = true;
             else
                 changed = rm->array->data[old_n] != ((vartype_real *) reg_x)->x;
         } else if (reg_x->type == TYPE_STRING) {
-            if (rm->array->is_string[old_n] == 0)
+            if (rm->array->str(old_n) == 0)
                 changed = true;
             else {
                 char *text;
@@ -1245,6 +1266,18 @@ static int matedit_move(int direction) {
         } else {
             return ERR_INVALID_TYPE;
         }
+    } else if (m->type == TYPE_SPARSEMATRIX) {
+        sm = (vartype_sparsematrix *) m;
+        rows = sm->rows;
+        columns = sm->columns;
+        old_n = matedit_i * columns + matedit_j;
+        if (reg_x == NULL) {
+            changed = false;
+        } else if (reg_x->type == TYPE_REAL) {
+            changed = sparse_get(sm, matedit_i, matedit_j) != ((vartype_real *) reg_x)->x;
+        } else {
+            return reg_x->type == TYPE_STRING ? ERR_ALPHA_DATA_IS_INVALID : ERR_INVALID_TYPE;
+        }
     } else { // TYPE_COMPLEXMATRIX
         cm = (vartype_complexmatrix *) m;
         rows = cm->rows;
@@ -1322,7 +1355,7 @@ static int matedit_move(int direction) {
 
     if (m->type == TYPE_REALMATRIX) {
         if (old_n != new_n) {
-            if (rm->array->is_string[new_n] != 0) {
+            if (rm->array->str(new_n) != 0) {
                 char *text;
                 int4 len;
                 get_matrix_string(rm, new_n, &text, &len);
@@ -1335,10 +1368,7 @@ static int matedit_move(int direction) {
         if (!changed) {
             /* There's nothing to store, so leave cell unchanged */
         } else if (stack[sp]->type == TYPE_REAL) {
-            if (rm->array->is_string[old_n] == 2)
-                free(*(void **) &rm->array->data[old_n]);
-            rm->array->is_string[old_n] = 0;
-            rm->array->data[old_n] = ((vartype_real *) stack[sp])->x;
+            put_matrix_number(rm, old_n, ((vartype_real *) stack[sp])->x);
         } else {
             vartype_string *s = (vartype_string *) stack[sp];
             if (!put_matrix_string(rm, old_n, s->txt(), s->length)) {
@@ -1346,6 +1376,17 @@ static int matedit_move(int direction) {
                 return ERR_INSUFFICIENT_MEMORY;
             }
         }
+    } else if (m->type == TYPE_SPARSEMATRIX) {
+        if (old_n != new_n) {
+            v = new_real(sparse_get(sm, new_i, new_j));
+            if (v == NULL)
+                return ERR_INSUFFICIENT_MEMORY;
+        }
+        if (changed && !sparse_put(sm, matedit_i, matedit_j, ((vartype_real *) stack[sp])->x)) {
+            if (old_n != new_n)
+                free_vartype(v);
+            return ERR_INSUFFICIENT_MEMORY;
+        }
     } else { // m->type == TYPE_COMPLEXMATRIX
         if (old_n != new_n) {
             v = new_complex(cm->array->data[2 * new_n],
@@ -1516,7 +1557,7 @@ static int matabx(int which) {
 
     if (mat->type == TYPE_REALMATRIX) {
         vartype_realmatrix *rm = (vartype_realmatrix *) mat;
-        if (rm->array->is_string[0] != 0) {
+        if (rm->array->str(0) != 0) {
             char *text;
             int4 length;
             get_matrix_string(rm, 0, &text, &length);
@@ -1685,7 +1726,7 @@ static int max_min_helper(int do_max) {
     for (i = matedit_i; i < rm->rows; i++) {
         int4 index = i * rm->columns + matedit_j;
         phloat e;
-        if (rm->array->is_string[index] != 0)
+        if (rm->array->str(index) != 0)
             return ERR_ALPHA_DATA_IS_INVALID;
         e = rm->array->data[index];
         if (do_max ? e >= max_or_min_value : e <= max_or_min_value) {
@@ -1719,7 +1760,7 @@ int docmd_find(arg_struct *arg) {
     int err = matedit_get(&m);
     if (err != ERR_NONE)
         return err;
-    if (m->type == TYPE_LIST)
+    if (m->type == TYPE_LIST || m->type == TYPE_SPARSEMATRIX)
         return ERR_INVALID_TYPE;
     if (m->type == TYPE_REALMATRIX) {
         vartype_realmatrix *rm;
@@ -1731,7 +1772,7 @@ int docmd_find(arg_struct *arg) {
             phloat d = ((vartype_real *) stack[sp])->x;
             for (i = 0; i < rm->rows; i++)
                 for (j = 0; j < rm->columns; j++)
-                    if (rm->array->is_string[p] == 0 && rm->array->data[p] == d) {
+                    if (rm->array->str(p) == 0 && rm->array->data[p] == d) {
                         matedit_i = i;
                         matedit_j = j;
                         return ERR_YES;
@@ -1743,7 +1784,7 @@ int docmd_find(arg_struct *arg) {
             int4 len = s->length;
             for (i = 0; i < rm->rows; i++)
                 for (j = 0; j < rm->columns; j++) {
-                    if (rm->array->is_string[p] != 0) {
+                    if (rm->array->str(p) != 0) {
                         char *mtext;
                         int4 mlen;
                         get_matrix_string(rm, p, &mtext, &mlen);
@@ -91,7 +91,7 @@ static int get_summation() {
     int4 first = mode_sigma_reg;
     int4 last = first + (flags.f.all_sigma ? 13 : 6);
     int4 size, i;
-    vartype *regs = recall_var("REGS", 4);
+    vartype *regs = recall_regs();
     vartype_realmatrix *r;
     phloat *sigmaregs;
     if (regs == NULL)
@@ -103,7 +103,7 @@ static int get_summation() {
     if (last > size)
         return ERR_SIZE_ERROR;
     for (i = first; i < last; i++)
-        if (r->array->is_string[i] != 0)
+        if (r->array->str(i) != 0)
             return ERR_ALPHA_DATA_IS_INVALID;
     sigmaregs = r->array->data + first;
     sum.x = sigmaregs[0];
@@ -1998,91 +1998,145 @@ static void accum(phloat *sum, phloat term, int weight) {
     *sum = s;
 }
 
-static phloat sigma_helper_2(phloat *sigmaregs,
-                             phloat x, phloat y, int weight) {
-
-    accum(&sigmaregs[0], x, weight);
-    accum(&sigmaregs[1], x * x, weight);
-    accum(&sigmaregs[2], y, weight);
-    accum(&sigmaregs[3], y * y, weight);
-    accum(&sigmaregs[4], x * y, weight);
-    accum(&sigmaregs[5], 1, weight);
-
-    if (flags.f.all_sigma) {
-        if (x > 0) {
-            phloat lnx = log(x);
-            if (y > 0) {
-                phloat lny = log(y);
-                accum(&sigmaregs[8], lny, weight);
-                accum(&sigmaregs[9], lny * lny, weight);
-                accum(&sigmaregs[10], lnx * lny, weight);
-                accum(&sigmaregs[11], x * lny, weight);
-            } else {
-                flags.f.exp_fit_invalid = 1;
-                flags.f.pwr_fit_invalid = 1;
-            }
-            accum(&sigmaregs[6], lnx, weight);
-            accum(&sigmaregs[7], lnx * lnx, weight);
-            accum(&sigmaregs[12], lnx * y, weight);
-        } else {
-            if (y > 0) {
-                phloat lny = log(y);
-                accum(&sigmaregs[8], lny, weight);
-                accum(&sigmaregs[9], lny * lny, weight);
-                accum(&sigmaregs[11], x * lny, weight);
-            } else
-                flags.f.exp_fit_invalid = 1;
-            flags.f.log_fit_invalid = 1;
-            flags.f.pwr_fit_invalid = 1;
-        }
-    } else {
-        flags.f.log_fit_invalid = 1;
-        flags.f.exp_fit_invalid = 1;
-        flags.f.pwr_fit_invalid = 1;
-    }
-
-    return sigmaregs[5];
-}
-
-static int sigma_helper_1(int weight) {
+int get_sigma_regs(phloat **sigmaregs) {
     /* Check if summation registers are OK */
     int4 first = mode_sigma_reg;
     int4 last = first + (flags.f.all_sigma ? 13 : 6);
     int4 size, i;
-    vartype *regs = recall_var("REGS", 4);
+    vartype *regs = recall_regs();
     vartype_realmatrix *r;
-    phloat *sigmaregs;
     if (regs == NULL)
         return ERR_SIZE_ERROR;
     if (regs->type != TYPE_REALMATRIX)
         return ERR_INVALID_TYPE;
+    /* The caller updates the registers in place */
+    if (!disentangle(regs))
+        return ERR_INSUFFICIENT_MEMORY;
     r = (vartype_realmatrix *) regs;
     size = r->rows * r->columns;
     if (last > size)
         return ERR_SIZE_ERROR;
-    for (i = first; i < last; i++)
-        if (r->array->is_string[i] != 0)
-            return ERR_ALPHA_DATA_IS_INVALID;
-    sigmaregs = r->array->data + first;
+    if (r->array->nstrings > 0)
+        for (i = first; i < last; i++)
+            if (r->array->str(i) != 0)
+                return ERR_ALPHA_DATA_IS_INVALID;
+    *sigmaregs = r->array->data + first;
+    return ERR_NONE;
+}
+
+/* Adds (weight = 1) or subtracts (weight = -1) n (x, y) pairs, stored one
+ * after the other in xy, to or from the summation registers, and returns the
+ * new value of the count register. The sums are kept in locals and the fit
+ * validity flags are only written once at the end, so large batches don't
+ * pay for a round trip through memory per term, but each sum still takes
+ * its terms one at a time, in the same order, so the results are identical
+ * to adding the pairs one by one.
+ */
+phloat sigma_accumulate(phloat *sigmaregs, const phloat *xy, int4 n, int weight) {
+    phloat s0 = sigmaregs[0], s1 = sigmaregs[1], s2 = sigmaregs[2];
+    phloat s3 = sigmaregs[3], s4 = sigmaregs[4], s5 = sigmaregs[5];
+    int4 i;
+
+    if (!flags.f.all_sigma) {
+        for (i = 0; i < n; i++) {
+            phloat x = xy[2 * i];
+            phloat y = xy[2 * i + 1];
+            accum(&s0, x, weight);
+            accum(&s1, x * x, weight);
+            accum(&s2, y, weight);
+            accum(&s3, y * y, weight);
+            accum(&s4, x * y, weight);
+            accum(&s5, 1, weight);
+        }
+        if (n > 0) {
+            flags.f.log_fit_invalid = 1;
+            flags.f.exp_fit_invalid = 1;
+            flags.f.pwr_fit_invalid = 1;
+        }
+    } else {
+        phloat s6 = sigmaregs[6], s7 = sigmaregs[7], s8 = sigmaregs[8];
+        phloat s9 = sigmaregs[9], s10 = sigmaregs[10], s11 = sigmaregs[11];
+        phloat s12 = sigmaregs[12];
+        bool log_invalid = false, exp_invalid = false;
+        for (i = 0; i < n; i++) {
+            phloat x = xy[2 * i];
+            phloat y = xy[2 * i + 1];
+            accum(&s0, x, weight);
+            accum(&s1, x * x, weight);
+            accum(&s2, y, weight);
+            accum(&s3, y * y, weight);
+            accum(&s4, x * y, weight);
+            accum(&s5, 1, weight);
+            if (x > 0) {
+                phloat lnx = log(x);
+                if (y > 0) {
+                    phloat lny = log(y);
+                    accum(&s8, lny, weight);
+                    accum(&s9, lny * lny, weight);
+                    accum(&s10, lnx * lny, weight);
+                    accum(&s11, x * lny, weight);
+                } else
+                    exp_invalid = true;
+                accum(&s6, lnx, weight);
+                accum(&s7, lnx * lnx, weight);
+                accum(&s12, lnx * y, weight);
+            } else {
+                if (y > 0) {
+                    phloat lny = log(y);
+                    accum(&s8, lny, weight);
+                    accum(&s9, lny * lny, weight);
+                    accum(&s11, x * lny, weight);
+                } else
+                    exp_invalid = true;
+                log_invalid = true;
+            }
+        }
+        sigmaregs[6] = s6;
+        sigmaregs[7] = s7;
+        sigmaregs[8] = s8;
+        sigmaregs[9] = s9;
+        sigmaregs[10] = s10;
+        sigmaregs[11] = s11;
+        sigmaregs[12] = s12;
+        // The power fit needs both logarithms, so it goes with either
+        if (exp_invalid) {
+            flags.f.exp_fit_invalid = 1;
+            flags.f.pwr_fit_invalid = 1;
+        }
+        if (log_invalid) {
+            flags.f.log_fit_invalid = 1;
+            flags.f.pwr_fit_invalid = 1;
+        }
+    }
+    sigmaregs[0] = s0;
+    sigmaregs[1] = s1;
+    sigmaregs[2] = s2;
+    sigmaregs[3] = s3;
+    sigmaregs[4] = s4;
+    sigmaregs[5] = s5;
+    return s5;
+}
+
+static int sigma_helper_1(int weight) {
+    phloat *sigmaregs;
+    int err = get_sigma_regs(&sigmaregs);
+    if (err != ERR_NONE)
+        return err;
 
     /* All summation registers present, real-valued, non-string. */
     if (stack[sp]->type == TYPE_REALMATRIX) {
         vartype_realmatrix *rm = (vartype_realmatrix *) stack[sp];
         vartype_real *x;
-        int4 i;
         if (rm->columns != 2)
             return ERR_DIMENSION_ERROR;
-        for (i = 0; i < rm->rows * 2; i++)
-            if (rm->array->is_string[i] != 0)
-                return ERR_ALPHA_DATA_IS_INVALID;
+        if (rm->array->nstrings > 0)
+            for (int4 i = 0; i < rm->rows * 2; i++)
+                if (rm->array->str(i) != 0)
+                    return ERR_ALPHA_DATA_IS_INVALID;
         x = (vartype_real *) new_real(0);
         if (x == NULL)
             return ERR_INSUFFICIENT_MEMORY;
-        for (i = 0; i < rm->rows; i++)
-            x->x = sigma_helper_2(sigmaregs,
-                                    rm->array->data[i * 2],
-                                    rm->array->data[i * 2 + 1],
-                                    weight);
+        x->x = sigma_accumulate(sigmaregs, rm->array->data, rm->rows, weight);
         free_vartype(lastx);
         lastx = stack[sp];
         stack[sp] = (vartype *) x;
@@ -2094,11 +2148,10 @@ static int sigma_helper_1(int weight) {
             vartype_real *x = (vartype_real *) new_real(0);
             if (x == NULL)
                 return ERR_INSUFFICIENT_MEMORY;
-            phloat y = sp == 0 ? 0 : ((vartype_real *) stack[sp - 1])->x;
-            x->x = sigma_helper_2(sigmaregs,
-                                    ((vartype_real *) stack[sp])->x,
-                                    y,
-                                    weight);
+            phloat xy[2];
+            xy[0] = ((vartype_real *) stack[sp])->x;
+            xy[1] = sp == 0 ? 0 : ((vartype_real *) stack[sp - 1])->x;
+            x->x = sigma_accumulate(sigmaregs, xy, 1, weight);
             free_vartype(lastx);
             lastx = stack[sp];
             stack[sp] = (vartype *) x;
@@ -116,4 +116,7 @@ int docmd_to_oct(arg_struct *arg);
 int docmd_sigmaadd(arg_struct *arg);
 int docmd_sigmasub(arg_struct *arg);
 
+int get_sigma_regs(phloat **sigmaregs);
+phloat sigma_accumulate(phloat *sigmaregs, const phloat *xy, int4 n, int weight);
+
 #endif
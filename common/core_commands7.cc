@@ -26,7 +26,9 @@
 #include "core_display.h"
 #include "core_globals.h"
 #include "core_helpers.h"
+#include "core_linalg1.h"
 #include "core_main.h"
+#include "core_math1.h"
 #include "core_sto_rcl.h"
 #include "core_variables.h"
 #include "shell.h"
@@ -1047,7 +1049,7 @@ int docmd_csld_t(arg_struct *arg) {
     return is_csld() ? ERR_YES : ERR_NO;
 }
 
-static int get_mat_or_list(arg_struct *arg, bool matrix, vartype **res, int4 *rows, int4 *cols) {
+static int get_arg_object(arg_struct *arg, vartype **res) {
     if (arg->type == ARGTYPE_IND_NUM
             || arg->type == ARGTYPE_IND_STK
             || arg->type == ARGTYPE_IND_STR) {
@@ -1068,6 +1070,8 @@ static int get_mat_or_list(arg_struct *arg, bool matrix, vartype **res, int4 *ro
             return ERR_STACK_DEPTH_ERROR;
         *res = stack[sp - idx];
         skip:;
+        if (is_matrix_view(*res) && !disentangle(*res))
+            return ERR_INSUFFICIENT_MEMORY;
     } else if (arg->type == ARGTYPE_STR) {
         *res = recall_var(arg->val.text, arg->length);
         if (*res == NULL)
@@ -1075,6 +1079,13 @@ static int get_mat_or_list(arg_struct *arg, bool matrix, vartype **res, int4 *ro
     } else {
         return ERR_INTERNAL_ERROR;
     }
+    return ERR_NONE;
+}
+
+static int get_mat_or_list(arg_struct *arg, bool matrix, vartype **res, int4 *rows, int4 *cols) {
+    int err = get_arg_object(arg, res);
+    if (err != ERR_NONE)
+        return err;
     int type = (*res)->type;
     if (matrix) {
         if (type == TYPE_REALMATRIX) {
@@ -1114,7 +1125,7 @@ int docmd_getmi(arg_struct *arg) {
     int4 n = row * cols + col;
     if (v->type == TYPE_REALMATRIX) {
         vartype_realmatrix *rm = (vartype_realmatrix *) v;
-        if (rm->array->is_string[n] != 0) {
+        if (rm->array->str(n) != 0) {
             char *text;
             int4 length;
             get_matrix_string(rm, n, &text, &length);
@@ -1160,10 +1171,7 @@ int docmd_putmi(arg_struct *arg) {
     if (v->type == TYPE_REALMATRIX) {
         vartype_realmatrix *rm = (vartype_realmatrix *) v;
         if (stack[sp]->type == TYPE_REAL) {
-            if (rm->array->is_string[n] == 2)
-                free(*(void **) &rm->array->data[n]);
-            rm->array->is_string[n] = 0;
-            rm->array->data[n] = ((vartype_real *) stack[sp])->x;
+            put_matrix_number(rm, n, ((vartype_real *) stack[sp])->x);
         } else if (stack[sp]->type == TYPE_STRING) {
             vartype_string *s = (vartype_string *) stack[sp];
             if (!put_matrix_string(rm, n, s->txt(), s->length))
@@ -1233,22 +1241,18 @@ int docmd_putli(arg_struct *arg) {
         free_vartype(list->array->data[item]);
         list->array->data[item] = v;
     } else {
-        vartype **new_data = (vartype **) realloc(list->array->data, (item + 1) * sizeof(vartype *));
-        if (new_data == NULL)
+        if (!reserve_list(list, item + 1))
             goto fail;
+        vartype **data = list->array->data;
         for (int i = list->size; i < item; i++) {
-            new_data[i] = new_real(0);
-            if (new_data[i] == NULL) {
+            data[i] = new_real(0);
+            if (data[i] == NULL) {
                 while (--i >= list->size)
-                    free_vartype(new_data[i]);
-                new_data = (vartype **) realloc(new_data, list->size * sizeof(vartype *));
-                if (new_data != NULL || list->size == 0)
-                    list->array->data = new_data;
+                    free_vartype(data[i]);
                 goto fail;
             }
         }
-        new_data[item] = v;
-        list->array->data = new_data;
+        data[item] = v;
         list->size = item + 1;
     }
 
@@ -1726,19 +1730,38 @@ static int concat(bool extend) {
             len = reg_alpha_length;
         }
         vartype_string *s = (vartype_string *) stack[sp - 1];
-        vartype *v = new_string(NULL, s->length + len);
-        if (v != NULL) {
-            vartype_string *s2 = (vartype_string *) v;
-            memcpy(s2->txt(), s->txt(), s->length);
-            memcpy(s2->txt() + s->length, text, len);
+        int err;
+        if (s->length > SSLENV) {
+            // Long string: grow it in place, so that building a string
+            // one piece at a time doesn't copy the whole thing every time.
+            // Y stays where it is, so the stack only has to drop X, and
+            // unary_no_result() leaves everything intact if that fails.
+            if (!reserve_string(s, s->length + len)) {
+                err = ERR_INSUFFICIENT_MEMORY;
+            } else {
+                err = unary_no_result();
+                if (err == ERR_NONE) {
+                    memcpy(s->t.ptr + s->length, text, len);
+                    s->length += len;
+                    print_trace();
+                }
+            }
+        } else {
+            vartype *v = new_string(NULL, s->length + len);
+            if (v == NULL) {
+                err = ERR_INSUFFICIENT_MEMORY;
+            } else {
+                vartype_string *s2 = (vartype_string *) v;
+                memcpy(s2->txt(), s->txt(), s->length);
+                memcpy(s2->txt() + s->length, text, len);
+                err = binary_result(v);
+            }
         }
         if (text == reg_alpha) {
             memcpy(reg_alpha, buf, templen);
             reg_alpha_length = templen;
         }
-        if (v == NULL)
-            return ERR_INSUFFICIENT_MEMORY;
-        return binary_result(v);
+        return err;
     } else if (stack[sp - 1]->type == TYPE_LIST) {
         vartype *v = dup_vartype(stack[sp]);
         if (v == NULL)
@@ -1753,66 +1776,36 @@ static int concat(bool extend) {
             if (!disentangle(v))
                 goto nomem;
             vartype_list *list2 = (vartype_list *) v;
+            if (!reserve_list(list, list->size + list2->size))
+                goto nomem;
+            // The list in Y stays where it is, so all the stack has to do
+            // is drop X. Do that before the actual data transfer, since it
+            // can fail, because of the T duplication, and we don't want to
+            // have to roll back the transfer; unary_no_result() leaves the
+            // stack intact when it fails.
+            if (unary_no_result() != ERR_NONE)
+                goto nomem;
             if (list2->size > 0) {
-                vartype **new_data = (vartype **) realloc(list->array->data, (list->size + list2->size) * sizeof(vartype *));
-                if (new_data == NULL)
-                    goto nomem;
-                list->array->data = new_data;
-                // Call binary_result() before doing the actual data transfer.
-                // The reason is that binary_result() can fail, because of the
-                // T duplication, and we don't want to have to roll back all this.
-                stack[sp - 1] = NULL;
-                int err = binary_result((vartype *) list);
-                if (err != ERR_NONE) {
-                    // Try to shrink the data array back down. No worries if this
-                    // fails, we just hold on to the resized one in that case.
-                    new_data = (vartype **) realloc(list->array->data, list->size * sizeof(vartype *));
-                    if (new_data != NULL || list->size == 0)
-                        list->array->data = new_data;
-                    stack[sp - 1] = (vartype *) list;
-                    goto nomem;
-                }
                 memcpy(list->array->data + list->size, list2->array->data, list2->size * sizeof(vartype *));
                 list->size += list2->size;
-                // At this point we're done with list2. Since it's a disentangled
-                // copy, the refcount is 1 and it is going to be completely deleted.
-                // We're doing it manually rather than through free_vartype(), so
-                // we don't have to zero out the data array first.
-                free(list2->array->data);
-                free(list2->array);
-                free(list2);
-            } else {
-                // Joining an empty list to the list in Y. This is not quite a
-                // no-op, since the binary_result() causes T duplication, which
-                // can fail.
-                stack[sp - 1] = NULL;
-                int err = binary_result((vartype *) list);
-                if (err != ERR_NONE) {
-                    stack[sp - 1] = (vartype *) list;
-                    goto nomem;
-                }
-                free_vartype(v);
             }
+            // At this point we're done with list2. Since it's a disentangled
+            // copy, the refcount is 1 and it is going to be completely deleted.
+            // Its elements now belong to the target list, so clear its size
+            // to keep free_vartype() from freeing them.
+            list2->size = 0;
+            free_vartype(v);
+            print_trace();
             return ERR_NONE;
         }
-        vartype **new_data = (vartype **) realloc(list->array->data, (list->size + 1) * sizeof(vartype *));
-        if (new_data == NULL)
+        if (!reserve_list(list, list->size + 1))
             goto nomem;
-        list->array->data = new_data;
-        // Call binary_result() before doing the actual data transfer.
-        // The reason is that binary_result() can fail, because of the
-        // T duplication, and we don't want to have to roll back all this.
-        stack[sp - 1] = NULL;
-        int err = binary_result((vartype *) list);
-        if (err != ERR_NONE) {
-            // Unlike the 'extend' case, we don't try to shrink the data array
-            // back down here. We're only wasting the space of one pointer,
-            // so, *shrug*.
-            stack[sp - 1] = (vartype *) list;
+        // See above.
+        if (unary_no_result() != ERR_NONE)
             goto nomem;
-        }
         list->array->data[list->size++] = v;
         // Not freeing v because it is now owned by the target list.
+        print_trace();
         return ERR_NONE;
     } else {
         return ERR_INVALID_TYPE;
@@ -1914,10 +1907,13 @@ int docmd_substr(arg_struct *arg) {
 }
 
 int docmd_length(arg_struct *arg) {
-    // LENGTH: returns the length of the string or list in X.
+    // LENGTH: returns the length of the string or list, or the number of
+    // entries in the map, in X.
     int4 len;
     if (stack[sp]->type == TYPE_STRING)
         len = ((vartype_string *) stack[sp])->length;
+    else if (stack[sp]->type == TYPE_MAP)
+        len = ((vartype_map *) stack[sp])->array->size;
     else
         len = ((vartype_list *) stack[sp])->size;
     vartype *v = new_real(len);
@@ -1944,7 +1940,7 @@ int docmd_head(arg_struct *arg) {
     vartype *s, *v;
     switch (arg->type) {
         case ARGTYPE_NUM: {
-            vartype *regs = recall_var("REGS", 4);
+            vartype *regs = recall_regs();
             if (regs == NULL)
                 return ERR_SIZE_ERROR;
             if (regs->type != TYPE_REALMATRIX)
@@ -1954,7 +1950,7 @@ int docmd_head(arg_struct *arg) {
             int4 n = arg->val.num;
             if (n >= sz)
                 return ERR_SIZE_ERROR;
-            if (rm->array->is_string[n] == 0)
+            if (rm->array->str(n) == 0)
                 return ERR_INVALID_TYPE;
             char *text;
             int len;
@@ -1998,6 +1994,10 @@ int docmd_head(arg_struct *arg) {
                 v = new_string(str->txt(), 1);
                 if (v == NULL)
                     return ERR_INSUFFICIENT_MEMORY;
+                if (!disentangle(s)) {
+                    free_vartype(v);
+                    return ERR_INSUFFICIENT_MEMORY;
+                }
                 str->trim1();
                 err = recall_result(v);
                 return err == ERR_NONE ? ERR_YES : err;
@@ -2099,10 +2099,37 @@ int docmd_pos(arg_struct *arg) {
             return ERR_INVALID_DATA;
         vartype_list *list = (vartype_list *) stack[list_sp];
         pos = -1;
-        for (int4 i = startpos; i < list->size; i++) {
-            if (vartype_equals(list->array->data[i], stack[sp])) {
-                pos = i;
-                break;
+        vartype **data = list->array->data;
+        vartype *x = stack[sp];
+        // Reals and strings, by far the most common things to look for, are
+        // matched inline; anything else goes through vartype_equals().
+        if (x->type == TYPE_REAL) {
+            phloat xx = ((vartype_real *) x)->x;
+            for (int4 i = startpos; i < list->size; i++)
+                if (data[i]->type == TYPE_REAL
+                        && ((vartype_real *) data[i])->x == xx) {
+                    pos = i;
+                    break;
+                }
+        } else if (x->type == TYPE_STRING) {
+            vartype_string *xs = (vartype_string *) x;
+            const char *xtext = xs->txt();
+            int4 xlen = xs->length;
+            for (int4 i = startpos; i < list->size; i++) {
+                if (data[i]->type != TYPE_STRING)
+                    continue;
+                vartype_string *s = (vartype_string *) data[i];
+                if (s->length == xlen && memcmp(s->txt(), xtext, xlen) == 0) {
+                    pos = i;
+                    break;
+                }
+            }
+        } else {
+            for (int4 i = startpos; i < list->size; i++) {
+                if (vartype_equals(data[i], x)) {
+                    pos = i;
+                    break;
+                }
             }
         }
     } else {
@@ -2210,6 +2237,9 @@ int docmd_to_list(arg_struct *arg) {
     int4 n = to_int4(x);
     if (n > sp)
         return ERR_STACK_DEPTH_ERROR;
+    for (int i = 1; i <= n; i++)
+        if (is_matrix_view(stack[sp - i]) && !disentangle(stack[sp - i]))
+            return ERR_INSUFFICIENT_MEMORY;
     vartype_list *list = (vartype_list *) new_list(n);
     if (list == NULL)
         return ERR_INSUFFICIENT_MEMORY;
@@ -2287,9 +2317,8 @@ int docmd_from_list(arg_struct *arg) {
         }
         stack[3] = size;
     }
-    free(list->array->data);
-    free(list->array);
-    free(list);
+    list->size = 0;
+    free_vartype((vartype *) list);
     print_trace();
     return ERR_NONE;
 }
@@ -2307,3 +2336,889 @@ int docmd_height(arg_struct *arg) {
         return ERR_INSUFFICIENT_MEMORY;
     return recall_result(v);
 }
+
+int docmd_newspm(arg_struct *arg) {
+    int4 rows, columns;
+    if (!dim_to_int4(stack[sp - 1], &rows))
+        return ERR_DIMENSION_ERROR;
+    if (!dim_to_int4(stack[sp], &columns))
+        return ERR_DIMENSION_ERROR;
+    vartype *m = new_sparsematrix(rows + 1, columns + 1, 0);
+    if (m == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    return binary_result(m);
+}
+
+int docmd_sparse(arg_struct *arg) {
+    vartype_realmatrix *rm = (vartype_realmatrix *) stack[sp];
+    if (contains_strings(rm))
+        return ERR_ALPHA_DATA_IS_INVALID;
+    vartype *m = dense_to_sparse(rm);
+    if (m == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    unary_result(m);
+    return ERR_NONE;
+}
+
+int docmd_dense(arg_struct *arg) {
+    vartype *m = sparse_to_dense((vartype_sparsematrix *) stack[sp]);
+    if (m == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    unary_result(m);
+    return ERR_NONE;
+}
+
+static int iter_solve_completion(int error, vartype *res, int4 iterations) {
+    if (error != ERR_NONE)
+        return error;
+    vartype *it = new_real(iterations);
+    if (it == NULL) {
+        free_vartype(res);
+        return ERR_INSUFFICIENT_MEMORY;
+    }
+    return quaternary_two_results(res, it);
+}
+
+static int iter_solve(bool cg) {
+    /* T: right-hand side, Z: coefficient matrix, Y: tolerance,
+     * X: maximum number of iterations.
+     * Returns the solution in X and the number of iterations in Y.
+     */
+    if (stack[sp]->type != TYPE_REAL || stack[sp - 1]->type != TYPE_REAL)
+        return ERR_INVALID_TYPE;
+    phloat maxiter = ((vartype_real *) stack[sp])->x;
+    if (maxiter < 1 || maxiter >= 2147483648.0)
+        return ERR_INVALID_DATA;
+    phloat tol = ((vartype_real *) stack[sp - 1])->x;
+    return linalg_iter_solve(stack[sp - 2], stack[sp - 3], tol,
+                             to_int4(maxiter), cg, iter_solve_completion);
+}
+
+int docmd_cg(arg_struct *arg) {
+    return iter_solve(true);
+}
+
+int docmd_bicgstb(arg_struct *arg) {
+    return iter_solve(false);
+}
+
+static int lsq_completion(int error, vartype *coeffs, vartype *stats) {
+    if (error != ERR_NONE)
+        return error;
+    binary_two_results(coeffs, stats);
+    return ERR_NONE;
+}
+
+int docmd_lsq(arg_struct *arg) {
+    /* Y: design matrix, X: response vector(s).
+     * Returns the coefficients in X and the residual statistics in Y.
+     */
+    return linalg_lsq(stack[sp - 1], stack[sp], lsq_completion);
+}
+
+static int fft_completion(int error, vartype *res) {
+    if (error == ERR_NONE)
+        unary_result(res);
+    return error;
+}
+
+int docmd_fft(arg_struct *arg) {
+    return linalg_fft(stack[sp], false, fft_completion);
+}
+
+int docmd_ifft(arg_struct *arg) {
+    return linalg_fft(stack[sp], true, fft_completion);
+}
+
+static int eigen_completion(int error, vartype *values, vartype *vectors) {
+    if (error != ERR_NONE)
+        return error;
+    if (vectors == NULL) {
+        unary_result(values);
+        return ERR_NONE;
+    }
+    return unary_two_results(vectors, values);
+}
+
+int docmd_eigen(arg_struct *arg) {
+    return linalg_eigen(stack[sp], false, eigen_completion);
+}
+
+int docmd_eigenv(arg_struct *arg) {
+    /* Returns the eigenvalues in Y and the eigenvectors, as the columns
+     * of a matrix, in X. */
+    return linalg_eigen(stack[sp], true, eigen_completion);
+}
+
+///////////////////////
+///// Polynomials /////
+///////////////////////
+
+static int get_poly(const vartype *v, int4 *n, phloat **coeffs, bool *cplx) {
+    /* Coefficient vectors may be row or column vectors, real or complex,
+     * with the coefficient of the highest power first. */
+    int4 rows, columns;
+    if (v->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) v;
+        if (contains_strings(rm))
+            return ERR_ALPHA_DATA_IS_INVALID;
+        rows = rm->rows;
+        columns = rm->columns;
+        *coeffs = rm->array->data;
+        *cplx = false;
+    } else if (v->type == TYPE_COMPLEXMATRIX) {
+        vartype_complexmatrix *cm = (vartype_complexmatrix *) v;
+        rows = cm->rows;
+        columns = cm->columns;
+        *coeffs = cm->array->data;
+        *cplx = true;
+    } else
+        return ERR_INVALID_TYPE;
+    if (rows != 1 && columns != 1)
+        return ERR_DIMENSION_ERROR;
+    *n = rows * columns;
+    return ERR_NONE;
+}
+
+/* The partial sums are range checked at every step, since once one of them
+ * has overflowed, the next step can turn it into NaN (inf - inf) instead.
+ * With range errors ignored, they are clamped to +/- HUGE and evaluation
+ * continues from there.
+ */
+static int poly_eval(const phloat *c, int4 n, bool ccplx,
+                     phloat xr, phloat xi, phloat *yr, phloat *yi,
+                     bool ignore_range) {
+    phloat sr = 0, si = 0;
+    bool cplx = ccplx || xi != 0;
+    for (int4 k = 0; k < n; k++) {
+        if (!cplx)
+            sr = sr * xr + c[k];
+        else {
+            phloat tr = sr * xr - si * xi;
+            phloat ti = sr * xi + si * xr;
+            if (ccplx) {
+                sr = tr + c[2 * k];
+                si = ti + c[2 * k + 1];
+            } else {
+                sr = tr + c[k];
+                si = ti;
+            }
+        }
+        if (p_isinf(sr) || p_isnan(sr)) {
+            if (!ignore_range)
+                return ERR_OUT_OF_RANGE;
+            sr = p_isinf(sr) < 0 ? NEG_HUGE_PHLOAT : POS_HUGE_PHLOAT;
+        }
+        if (p_isinf(si) || p_isnan(si)) {
+            if (!ignore_range)
+                return ERR_OUT_OF_RANGE;
+            si = p_isinf(si) < 0 ? NEG_HUGE_PHLOAT : POS_HUGE_PHLOAT;
+        }
+    }
+    *yr = sr;
+    *yi = si;
+    return ERR_NONE;
+}
+
+int docmd_peval(arg_struct *arg) {
+    /* Y: coefficient vector, X: argument(s).
+     * Evaluates the polynomial using Horner's scheme; a matrix argument
+     * is evaluated element by element, giving a result of the same shape.
+     */
+    int4 n;
+    phloat *c;
+    bool ccplx;
+    int err = get_poly(stack[sp - 1], &n, &c, &ccplx);
+    if (err != ERR_NONE)
+        return err;
+    vartype *x = stack[sp];
+    vartype *res;
+    phloat yr, yi;
+    bool mat_ignore = !core_settings.matrix_outofrange
+                        || flags.f.range_error_ignore;
+
+    if (x->type == TYPE_REAL || x->type == TYPE_COMPLEX) {
+        phloat xr, xi;
+        if (x->type == TYPE_REAL) {
+            xr = ((vartype_real *) x)->x;
+            xi = 0;
+        } else {
+            xr = ((vartype_complex *) x)->re;
+            xi = ((vartype_complex *) x)->im;
+        }
+        err = poly_eval(c, n, ccplx, xr, xi, &yr, &yi,
+                        flags.f.range_error_ignore);
+        if (err != ERR_NONE)
+            return err;
+        if (x->type == TYPE_REAL && !ccplx)
+            res = new_real(yr);
+        else
+            res = new_complex(yr, yi);
+    } else if (x->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) x;
+        if (contains_strings(rm))
+            return ERR_ALPHA_DATA_IS_INVALID;
+        int4 size = rm->rows * rm->columns;
+        phloat *xd = rm->array->data;
+        if (ccplx) {
+            res = new_complexmatrix(rm->rows, rm->columns);
+            if (res == NULL)
+                return ERR_INSUFFICIENT_MEMORY;
+            phloat *rd = ((vartype_complexmatrix *) res)->array->data;
+            for (int4 i = 0; i < size; i++) {
+                err = poly_eval(c, n, true, xd[i], 0, rd + 2 * i, rd + 2 * i + 1,
+                                mat_ignore);
+                if (err != ERR_NONE)
+                    break;
+            }
+        } else {
+            res = new_realmatrix(rm->rows, rm->columns);
+            if (res == NULL)
+                return ERR_INSUFFICIENT_MEMORY;
+            phloat *rd = ((vartype_realmatrix *) res)->array->data;
+            for (int4 i = 0; i < size; i++) {
+                err = poly_eval(c, n, false, xd[i], 0, rd + i, &yi, mat_ignore);
+                if (err != ERR_NONE)
+                    break;
+            }
+        }
+        if (err != ERR_NONE) {
+            free_vartype(res);
+            return err;
+        }
+    } else if (x->type == TYPE_COMPLEXMATRIX) {
+        vartype_complexmatrix *cm = (vartype_complexmatrix *) x;
+        int4 size = cm->rows * cm->columns;
+        phloat *xd = cm->array->data;
+        res = new_complexmatrix(cm->rows, cm->columns);
+        if (res == NULL)
+            return ERR_INSUFFICIENT_MEMORY;
+        phloat *rd = ((vartype_complexmatrix *) res)->array->data;
+        for (int4 i = 0; i < size; i++) {
+            err = poly_eval(c, n, ccplx, xd[2 * i], xd[2 * i + 1],
+                            rd + 2 * i, rd + 2 * i + 1, mat_ignore);
+            if (err != ERR_NONE) {
+                free_vartype(res);
+                return err;
+            }
+        }
+    } else
+        return ERR_INVALID_TYPE;
+
+    if (res == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    binary_result(res);
+    return ERR_NONE;
+}
+
+static int proot_completion(int error, vartype *values, vartype *vectors) {
+    if (error == ERR_NONE)
+        unary_result(values);
+    return error;
+}
+
+int docmd_proot(arg_struct *arg) {
+    /* X: coefficient vector.
+     * The roots are found as the eigenvalues of the companion matrix,
+     * and are returned as a complex column vector.
+     */
+    int4 n;
+    phloat *c;
+    bool ccplx;
+    int err = get_poly(stack[sp], &n, &c, &ccplx);
+    if (err != ERR_NONE)
+        return err;
+    int s = ccplx ? 2 : 1;
+    int4 lead = 0;
+    while (lead < n && c[s * lead] == 0 && (!ccplx || c[s * lead + 1] == 0))
+        lead++;
+    int4 deg = n - lead - 1;
+    if (deg < 1)
+        return ERR_INVALID_DATA;
+    c += s * lead;
+
+    vartype *comp = new_complexmatrix(deg, deg);
+    if (comp == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    phloat *d = ((vartype_complexmatrix *) comp)->array->data;
+    for (int4 i = 0; i < 2 * deg * deg; i++)
+        d[i] = 0;
+    phloat ar = c[0], ai = ccplx ? c[1] : 0;
+    phloat h = ar * ar + ai * ai;
+    for (int4 j = 0; j < deg; j++) {
+        /* First row: -c[j+1] / c[0] */
+        phloat br = c[s * (j + 1)], bi = ccplx ? c[s * (j + 1) + 1] : 0;
+        phloat re, im;
+        if (ai == 0) {
+            re = -br / ar;
+            im = -bi / ar;
+        } else if (p_isinf(h) == 0 && h != 0) {
+            re = -(br * ar + bi * ai) / h;
+            im = -(bi * ar - br * ai) / h;
+        } else {
+            /* Avoid overflow / underflow in ar^2 + ai^2 */
+            phloat m = fabs(ar) > fabs(ai) ? fabs(ar) : fabs(ai);
+            phloat sr = ar / m, si = ai / m;
+            phloat sh = sr * sr + si * si;
+            re = -((br / m) * sr + (bi / m) * si) / sh;
+            im = -((bi / m) * sr - (br / m) * si) / sh;
+        }
+        if (p_isinf(re) || p_isnan(re)) {
+            if (core_settings.matrix_outofrange
+                                    && !flags.f.range_error_ignore) {
+                free_vartype(comp);
+                return ERR_OUT_OF_RANGE;
+            }
+            re = p_isinf(re) < 0 ? NEG_HUGE_PHLOAT : POS_HUGE_PHLOAT;
+        }
+        if (p_isinf(im) || p_isnan(im)) {
+            if (core_settings.matrix_outofrange
+                                    && !flags.f.range_error_ignore) {
+                free_vartype(comp);
+                return ERR_OUT_OF_RANGE;
+            }
+            im = p_isinf(im) < 0 ? NEG_HUGE_PHLOAT : POS_HUGE_PHLOAT;
+        }
+        d[2 * j] = re;
+        d[2 * j + 1] = im;
+        if (j > 0)
+            d[2 * (j * deg + j - 1)] = 1;
+    }
+    /* linalg_eigen() works on a copy, so the companion matrix can be
+     * released as soon as it returns. */
+    err = linalg_eigen(comp, false, proot_completion);
+    free_vartype(comp);
+    return err;
+}
+
+//////////////////////////////////
+///// Differential equations /////
+//////////////////////////////////
+
+int docmd_ode(arg_struct *arg) {
+    /* Z: initial state, Y: start time, X: end time; ACC: tolerance.
+     * The named program is called with the state in Y and the time in X,
+     * and should return the derivative of the state in X.
+     * Returns the final state in Y, and in X a matrix with one row per
+     * accepted step, holding the time followed by the state elements.
+     */
+    int err;
+    if (arg->type == ARGTYPE_IND_NUM
+            || arg->type == ARGTYPE_IND_STK
+            || arg->type == ARGTYPE_IND_STR) {
+        err = resolve_ind_arg(arg);
+        if (err != ERR_NONE)
+            return err;
+    }
+    if (arg->type != ARGTYPE_STR)
+        return ERR_INVALID_TYPE;
+    int prgm;
+    int4 pc;
+    if (!find_global_label(arg, &prgm, &pc))
+        return ERR_LABEL_NOT_FOUND;
+    if (!program_running())
+        clear_all_rtns();
+    return start_ode(arg->val.text, arg->length);
+}
+
+/////////////////////////
+///// Map functions /////
+/////////////////////////
+
+static int get_map(arg_struct *arg, vartype_map **res) {
+    vartype *v;
+    int err = get_arg_object(arg, &v);
+    if (err != ERR_NONE)
+        return err;
+    if (v->type != TYPE_MAP)
+        return ERR_INVALID_TYPE;
+    *res = (vartype_map *) v;
+    return ERR_NONE;
+}
+
+static int check_map_key(const vartype *key) {
+    if (is_map_key(key))
+        return ERR_NONE;
+    else if (key->type == TYPE_REAL)
+        return ERR_INVALID_DATA;
+    else
+        return ERR_INVALID_TYPE;
+}
+
+int docmd_newmap(arg_struct *arg) {
+    vartype *v = new_map(0);
+    if (v == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    return recall_result(v);
+}
+
+int docmd_mput(arg_struct *arg) {
+    // MPUT <map>: stores X in the map under the key in Y.
+    int err = check_map_key(stack[sp - 1]);
+    if (err != ERR_NONE)
+        return err;
+    vartype_map *map;
+    err = get_map(arg, &map);
+    if (err != ERR_NONE)
+        return err;
+    vartype *key = dup_vartype(stack[sp - 1]);
+    vartype *value = dup_vartype(stack[sp]);
+    if (key == NULL || value == NULL
+            || !disentangle((vartype *) map)
+            || !map_put(map, key, value)) {
+        free_vartype(key);
+        free_vartype(value);
+        return ERR_INSUFFICIENT_MEMORY;
+    }
+    return ERR_NONE;
+}
+
+int docmd_mget(arg_struct *arg) {
+    // MGET <map>: recalls the value stored in the map under the key in X.
+    int err = check_map_key(stack[sp]);
+    if (err != ERR_NONE)
+        return err;
+    vartype_map *map;
+    err = get_map(arg, &map);
+    if (err != ERR_NONE)
+        return err;
+    int4 i = map_find(map, stack[sp]);
+    if (i == -1)
+        return ERR_NONEXISTENT;
+    vartype *v = dup_vartype(map->array->values[i]);
+    if (v == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    return recall_result(v);
+}
+
+int docmd_mdel(arg_struct *arg) {
+    // MDEL <map>: removes the key in X, and its value, from the map.
+    // Removing a key that isn't there is not an error.
+    int err = check_map_key(stack[sp]);
+    if (err != ERR_NONE)
+        return err;
+    vartype_map *map;
+    err = get_map(arg, &map);
+    if (err != ERR_NONE)
+        return err;
+    if (map_find(map, stack[sp]) == -1)
+        return ERR_NONE;
+    if (!disentangle((vartype *) map))
+        return ERR_INSUFFICIENT_MEMORY;
+    map_remove(map, stack[sp]);
+    return ERR_NONE;
+}
+
+int docmd_mkey_t(arg_struct *arg) {
+    // MKEY? <map>: tests whether the map has an entry for the key in X.
+    int err = check_map_key(stack[sp]);
+    if (err != ERR_NONE)
+        return err;
+    vartype_map *map;
+    err = get_map(arg, &map);
+    if (err != ERR_NONE)
+        return err;
+    return map_find(map, stack[sp]) == -1 ? ERR_NO : ERR_YES;
+}
+
+int docmd_mkeys(arg_struct *arg) {
+    // MKEYS: replaces the map in X with a list of its keys.
+    vartype_map *map = (vartype_map *) stack[sp];
+    vartype_list *list = (vartype_list *) new_list(map->array->size);
+    if (list == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    int4 n = 0;
+    for (int4 i = 0; i < map->array->capacity; i++) {
+        if (map->array->keys[i] == NULL)
+            continue;
+        vartype *key = dup_vartype(map->array->keys[i]);
+        if (key == NULL) {
+            free_vartype((vartype *) list);
+            return ERR_INSUFFICIENT_MEMORY;
+        }
+        list->array->data[n++] = key;
+    }
+    unary_result((vartype *) list);
+    return ERR_NONE;
+}
+
+///////////////////
+///// Sorting /////
+///////////////////
+
+/* SORT and RSORT sort a list, or the rows of a real matrix, in ascending or
+ * descending order, using vartype_compare(). The sort is a bottom-up merge
+ * sort of a permutation, which is stable, so equal items keep their
+ * relative order in both directions. It runs as an interruptible worker,
+ * merging a bounded number of items per call, and the permutation is only
+ * applied to a private copy of the list or matrix once it is complete.
+ */
+
+struct sort_data_struct {
+    vartype *v;
+    int4 n;
+    int4 key;
+    bool descending;
+    bool two_args;
+    int4 *src, *dst;
+    int4 width, lo, mid, hi, i, j, k;
+    void *scratch;
+};
+
+static sort_data_struct *sort_data;
+
+static void sort_free(sort_data_struct *dat) {
+    free_vartype(dat->v);
+    free(dat->src);
+    free(dat->dst);
+    free(dat->scratch);
+    free(dat);
+    sort_data = NULL;
+}
+
+static int sort_compare(sort_data_struct *dat, int4 a, int4 b) {
+    int c;
+    if (dat->v->type == TYPE_LIST) {
+        vartype **data = ((vartype_list *) dat->v)->array->data;
+        c = vartype_compare(data[a], data[b]);
+    } else {
+        vartype_realmatrix *rm = (vartype_realmatrix *) dat->v;
+        c = matrix_element_compare(rm, a * rm->columns + dat->key,
+                                   rm, b * rm->columns + dat->key);
+    }
+    return dat->descending ? -c : c;
+}
+
+static void sort_start_merge(sort_data_struct *dat) {
+    int4 n = dat->n;
+    dat->mid = dat->lo + dat->width;
+    if (dat->mid > n)
+        dat->mid = n;
+    dat->hi = dat->mid + dat->width;
+    if (dat->hi > n)
+        dat->hi = n;
+    dat->i = dat->lo;
+    dat->j = dat->mid;
+    dat->k = dat->lo;
+}
+
+static void sort_apply(sort_data_struct *dat) {
+    int4 n = dat->n;
+    int4 *perm = dat->src;
+    if (n == 0)
+        return;
+    if (dat->v->type == TYPE_LIST) {
+        vartype **data = ((vartype_list *) dat->v)->array->data;
+        vartype **tmp = (vartype **) dat->scratch;
+        for (int4 i = 0; i < n; i++)
+            tmp[i] = data[perm[i]];
+        memcpy(data, tmp, n * sizeof(vartype *));
+    } else {
+        vartype_realmatrix *rm = (vartype_realmatrix *) dat->v;
+        int4 cols = rm->columns;
+        phloat *data = rm->array->data;
+        phloat *tmp = (phloat *) dat->scratch;
+        for (int4 i = 0; i < n; i++) {
+            phloat *row = data + perm[i] * cols;
+            for (int4 j = 0; j < cols; j++)
+                tmp[i * cols + j] = row[j];
+        }
+        for (int4 i = 0; i < n * cols; i++)
+            data[i] = tmp[i];
+        char *is_string = rm->array->is_string;
+        if (is_string != NULL) {
+            char *stmp = (char *) (tmp + n * cols);
+            for (int4 i = 0; i < n; i++)
+                memcpy(stmp + i * cols, is_string + perm[i] * cols, cols);
+            memcpy(is_string, stmp, n * cols);
+        }
+    }
+}
+
+static int sort_worker(bool interrupted) {
+    sort_data_struct *dat = sort_data;
+    int4 n = dat->n;
+    int4 count = 0;
+
+    if (interrupted) {
+        sort_free(dat);
+        return ERR_INTERRUPTED;
+    }
+
+    while (count < 10000) {
+        if (dat->width >= n) {
+            sort_apply(dat);
+            vartype *v = dat->v;
+            bool two_args = dat->two_args;
+            dat->v = NULL;
+            sort_free(dat);
+            if (two_args)
+                return binary_result(v);
+            unary_result(v);
+            return ERR_NONE;
+        }
+        int4 *src = dat->src;
+        int4 *dst = dat->dst;
+        int4 i = dat->i, j = dat->j, k = dat->k;
+        int4 mid = dat->mid, hi = dat->hi;
+        while (k < hi && count < 10000) {
+            if (i < mid && (j >= hi || sort_compare(dat, src[i], src[j]) <= 0))
+                dst[k++] = src[i++];
+            else
+                dst[k++] = src[j++];
+            count++;
+        }
+        dat->i = i;
+        dat->j = j;
+        dat->k = k;
+        if (k < hi)
+            break;
+        dat->lo = hi;
+        if (dat->lo >= n) {
+            dat->src = dst;
+            dat->dst = src;
+            dat->width *= 2;
+            dat->lo = 0;
+        }
+        sort_start_merge(dat);
+    }
+    return ERR_INTERRUPTIBLE;
+}
+
+static int sort(bool descending) {
+    /* X: list or real matrix, sorted by its first column; or
+     * Y: real matrix, X: number of the column to sort by.
+     */
+    vartype *v;
+    int4 key = 0;
+    bool two_args = stack[sp]->type == TYPE_REAL;
+    if (two_args) {
+        if (sp == 0)
+            return ERR_TOO_FEW_ARGUMENTS;
+        if (stack[sp - 1]->type != TYPE_REALMATRIX)
+            return ERR_INVALID_TYPE;
+        vartype_realmatrix *rm = (vartype_realmatrix *) stack[sp - 1];
+        phloat col = ((vartype_real *) stack[sp])->x;
+        if (col < 1 || col >= rm->columns + 1)
+            return ERR_DIMENSION_ERROR;
+        key = to_int4(col) - 1;
+        v = stack[sp - 1];
+    } else
+        v = stack[sp];
+
+    int4 n, itemsize;
+    if (v->type == TYPE_LIST) {
+        n = ((vartype_list *) v)->size;
+        itemsize = sizeof(vartype *);
+    } else {
+        vartype_realmatrix *rm = (vartype_realmatrix *) v;
+        n = rm->rows;
+        itemsize = rm->columns * (sizeof(phloat) + 1);
+    }
+
+    sort_data_struct *dat = (sort_data_struct *) malloc(sizeof(sort_data_struct));
+    if (dat == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    dat->v = dup_vartype(v);
+    dat->src = (int4 *) malloc(n * sizeof(int4));
+    dat->dst = (int4 *) malloc(n * sizeof(int4));
+    dat->scratch = malloc(n * itemsize);
+    if (dat->v == NULL || !disentangle(dat->v)
+            || n != 0 && (dat->src == NULL || dat->dst == NULL
+                                           || dat->scratch == NULL)) {
+        sort_free(dat);
+        return ERR_INSUFFICIENT_MEMORY;
+    }
+    for (int4 i = 0; i < n; i++)
+        dat->src[i] = i;
+    dat->n = n;
+    dat->key = key;
+    dat->descending = descending;
+    dat->two_args = two_args;
+    dat->width = 1;
+    dat->lo = 0;
+    sort_start_merge(dat);
+
+    sort_data = dat;
+    mode_interruptible = sort_worker;
+    mode_stoppable = false;
+    return ERR_INTERRUPTIBLE;
+}
+
+int docmd_sort(arg_struct *arg) {
+    return sort(false);
+}
+
+int docmd_rsort(arg_struct *arg) {
+    return sort(true);
+}
+
+/////////////////////
+///// Searching /////
+/////////////////////
+
+/* BSRCH, BRACKET, and INTERP look up X in a table that is sorted in the
+ * order used by SORT, either ascending or descending. The table is a list,
+ * or a real matrix whose first column holds the keys; since only the keys
+ * are read, a view produced by TRANS or GETM can be searched directly.
+ * Each lookup is a binary search, taking O(log n) comparisons.
+ */
+
+static int4 table_size(const vartype *table) {
+    if (table->type == TYPE_LIST)
+        return ((const vartype_list *) table)->size;
+    else
+        return ((const vartype_realmatrix *) table)->rows;
+}
+
+/* Compares key i of the table to x, flipping the sign for tables that
+ * are sorted in descending order, so callers can assume ascending order.
+ */
+static int table_compare(const vartype *table, bool descending, int4 i, const vartype *x) {
+    int c;
+    if (table->type == TYPE_LIST)
+        c = vartype_compare(((const vartype_list *) table)->array->data[i], x);
+    else {
+        const vartype_realmatrix *rm = (const vartype_realmatrix *) table;
+        c = matrix_element_compare_to(rm, rm->index(i, 0), x);
+    }
+    return descending ? -c : c;
+}
+
+static bool table_descending(const vartype *table) {
+    int4 n = table_size(table);
+    if (n < 2)
+        return false;
+    if (table->type == TYPE_LIST) {
+        vartype **data = ((const vartype_list *) table)->array->data;
+        return vartype_compare(data[0], data[n - 1]) > 0;
+    } else {
+        const vartype_realmatrix *rm = (const vartype_realmatrix *) table;
+        return matrix_element_compare(rm, rm->index(0, 0),
+                                      rm, rm->index(n - 1, 0)) > 0;
+    }
+}
+
+/* Returns the index of the first key that is greater than x, or, if
+ * or_equal is true, greater than or equal to x.
+ */
+static int4 table_search(const vartype *table, const vartype *x, bool or_equal) {
+    bool descending = table_descending(table);
+    int4 lo = 0;
+    int4 hi = table_size(table);
+    while (lo < hi) {
+        int4 mid = lo + (hi - lo) / 2;
+        int c = table_compare(table, descending, mid, x);
+        if (c < 0 || c == 0 && !or_equal)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static int get_table(arg_struct *arg, vartype **res) {
+    int err = get_arg_object(arg, res);
+    if (err != ERR_NONE)
+        return err;
+    if ((*res)->type != TYPE_LIST && (*res)->type != TYPE_REALMATRIX)
+        return ERR_INVALID_TYPE;
+    return ERR_NONE;
+}
+
+/* Finds the pair of adjacent keys that brackets x, and returns the index of
+ * the first one. Values outside the table are bracketed by the first or the
+ * last pair.
+ */
+static int get_bracket(arg_struct *arg, vartype **table, int4 *index) {
+    int err = get_table(arg, table);
+    if (err != ERR_NONE)
+        return err;
+    int4 n = table_size(*table);
+    if (n < 2)
+        return ERR_DIMENSION_ERROR;
+    int4 i = table_search(*table, stack[sp], false) - 1;
+    if (i < 0)
+        i = 0;
+    else if (i > n - 2)
+        i = n - 2;
+    *index = i;
+    return ERR_NONE;
+}
+
+int docmd_bsrch(arg_struct *arg) {
+    // BSRCH <table>: returns the index of the first key equal to X,
+    // or -1 if there is no such key.
+    vartype *table;
+    int err = get_table(arg, &table);
+    if (err != ERR_NONE)
+        return err;
+    int4 i = table_search(table, stack[sp], true);
+    if (i == table_size(table)
+            || table_compare(table, false, i, stack[sp]) != 0)
+        i = -2;
+    vartype *v = new_real(i + 1);
+    if (v == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    unary_result(v);
+    return ERR_NONE;
+}
+
+int docmd_bracket(arg_struct *arg) {
+    // BRACKET <table>: returns the indices of the two adjacent keys that
+    // bracket X, the lower one in Y and the higher one in X.
+    vartype *table;
+    int4 i;
+    int err = get_bracket(arg, &table, &i);
+    if (err != ERR_NONE)
+        return err;
+    vartype *lo = new_real(i + 1);
+    vartype *hi = new_real(i + 2);
+    if (lo == NULL || hi == NULL) {
+        free_vartype(lo);
+        free_vartype(hi);
+        return ERR_INSUFFICIENT_MEMORY;
+    }
+    return unary_two_results(hi, lo);
+}
+
+int docmd_interp(arg_struct *arg) {
+    // INTERP <matrix>: interpolates linearly in a table whose first column
+    // holds the keys and whose second column holds the values. Values
+    // outside the table are extrapolated from the first or last two rows.
+    vartype *table;
+    int4 i;
+    int err = get_bracket(arg, &table, &i);
+    if (err != ERR_NONE)
+        return err;
+    if (table->type != TYPE_REALMATRIX)
+        return ERR_INVALID_TYPE;
+    vartype_realmatrix *rm = (vartype_realmatrix *) table;
+    if (rm->columns < 2)
+        return ERR_DIMENSION_ERROR;
+    int4 k0 = rm->index(i, 0), k1 = rm->index(i + 1, 0);
+    int4 v0 = rm->index(i, 1), v1 = rm->index(i + 1, 1);
+    if (rm->array->str(k0) || rm->array->str(k1)
+            || rm->array->str(v0) || rm->array->str(v1))
+        return ERR_ALPHA_DATA_IS_INVALID;
+    phloat x0 = rm->array->data[k0], x1 = rm->array->data[k1];
+    phloat y0 = rm->array->data[v0], y1 = rm->array->data[v1];
+    phloat x = ((vartype_real *) stack[sp])->x;
+    phloat r;
+    if (x1 == x0)
+        r = y0;
+    else
+        r = y0 + (x - x0) * (y1 - y0) / (x1 - x0);
+    int inf = p_isinf(r);
+    if (inf != 0) {
+        if (flags.f.range_error_ignore)
+            r = inf == 1 ? POS_HUGE_PHLOAT : NEG_HUGE_PHLOAT;
+        else
+            return ERR_OUT_OF_RANGE;
+    }
+    vartype *v = new_real(r);
+    if (v == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    unary_result(v);
+    return ERR_NONE;
+}
@@ -130,4 +130,32 @@ int docmd_from_list(arg_struct *arg);
 int docmd_width(arg_struct *arg);
 int docmd_height(arg_struct *arg);
 
+int docmd_newspm(arg_struct *arg);
+int docmd_sparse(arg_struct *arg);
+int docmd_dense(arg_struct *arg);
+int docmd_cg(arg_struct *arg);
+int docmd_bicgstb(arg_struct *arg);
+int docmd_lsq(arg_struct *arg);
+int docmd_fft(arg_struct *arg);
+int docmd_ifft(arg_struct *arg);
+int docmd_eigen(arg_struct *arg);
+int docmd_eigenv(arg_struct *arg);
+int docmd_peval(arg_struct *arg);
+int docmd_proot(arg_struct *arg);
+int docmd_ode(arg_struct *arg);
+
+int docmd_newmap(arg_struct *arg);
+int docmd_mput(arg_struct *arg);
+int docmd_mget(arg_struct *arg);
+int docmd_mdel(arg_struct *arg);
+int docmd_mkey_t(arg_struct *arg);
+int docmd_mkeys(arg_struct *arg);
+
+int docmd_sort(arg_struct *arg);
+int docmd_rsort(arg_struct *arg);
+
+int docmd_bsrch(arg_struct *arg);
+int docmd_bracket(arg_struct *arg);
+int docmd_interp(arg_struct *arg);
+
 #endif
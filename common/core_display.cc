@@ -1631,40 +1631,56 @@ static int ext_stk_cat[] = {
 #if defined(ANDROID) || defined(IPHONE)
 #ifdef FREE42_FPTEST
 static int ext_misc_cat[] = {
-    CMD_A2LINE, CMD_A2PLINE, CMD_CAPS,   CMD_C_LN_1_X, CMD_C_E_POW_X_1, CMD_DYNAMIC,
-    CMD_FMA,    CMD_GETLI,   CMD_GETMI,  CMD_HEIGHT,   CMD_IDENT,       CMD_LOCK,
-    CMD_MIXED,  CMD_PCOMPLX, CMD_PRREG,  CMD_PUTLI,    CMD_PUTMI,       CMD_RCOMPLX,
-    CMD_STATIC, CMD_STRACE,  CMD_UNLOCK, CMD_WIDTH,    CMD_X2LINE,      CMD_ACCEL,
-    CMD_LOCAT,  CMD_HEADING, CMD_FPTEST, CMD_NULL,     CMD_NULL,        CMD_NULL
+    CMD_A2LINE, CMD_A2PLINE,  CMD_BICGSTB,     CMD_BRACKET, CMD_BSRCH,   CMD_CAPS,
+    CMD_CG,     CMD_C_LN_1_X, CMD_C_E_POW_X_1, CMD_DENSE,   CMD_DYNAMIC, CMD_EIGEN,
+    CMD_EIGENV, CMD_FFT,      CMD_FMA,         CMD_GETLI,   CMD_GETMI,   CMD_HEIGHT,
+    CMD_IDENT,  CMD_IFFT,     CMD_INTERP,      CMD_LOCK,    CMD_LSQ,     CMD_MDEL,
+    CMD_MGET,   CMD_MIXED,    CMD_MKEY_T,      CMD_MKEYS,   CMD_MPUT,    CMD_NEWMAP,
+    CMD_NEWSPM, CMD_ODE,      CMD_PCOMPLX,     CMD_PEVAL,   CMD_PROOT,   CMD_PRREG,
+    CMD_PUTLI,  CMD_PUTMI,    CMD_RCOMPLX,     CMD_RSORT,   CMD_SORT,    CMD_SPARSE,
+    CMD_STATIC, CMD_STRACE,   CMD_UNLOCK,      CMD_WIDTH,   CMD_X2LINE,  CMD_ACCEL,
+    CMD_LOCAT,  CMD_HEADING,  CMD_FPTEST,      CMD_NULL,    CMD_NULL,    CMD_NULL
 };
-#define MISC_CAT_ROWS 5
+#define MISC_CAT_ROWS 9
 #else
 static int ext_misc_cat[] = {
-    CMD_A2LINE, CMD_A2PLINE, CMD_CAPS,   CMD_C_LN_1_X, CMD_C_E_POW_X_1, CMD_DYNAMIC,
-    CMD_FMA,    CMD_GETLI,   CMD_GETMI,  CMD_HEIGHT,   CMD_IDENT,       CMD_LOCK,
-    CMD_MIXED,  CMD_PCOMPLX, CMD_PRREG,  CMD_PUTLI,    CMD_PUTMI,       CMD_RCOMPLX,
-    CMD_STATIC, CMD_STRACE,  CMD_UNLOCK, CMD_WIDTH,    CMD_X2LINE,      CMD_ACCEL,
-    CMD_LOCAT,  CMD_HEADING, CMD_NULL,   CMD_NULL,     CMD_NULL,        CMD_NULL
+    CMD_A2LINE, CMD_A2PLINE,  CMD_BICGSTB,     CMD_BRACKET, CMD_BSRCH,   CMD_CAPS,
+    CMD_CG,     CMD_C_LN_1_X, CMD_C_E_POW_X_1, CMD_DENSE,   CMD_DYNAMIC, CMD_EIGEN,
+    CMD_EIGENV, CMD_FFT,      CMD_FMA,         CMD_GETLI,   CMD_GETMI,   CMD_HEIGHT,
+    CMD_IDENT,  CMD_IFFT,     CMD_INTERP,      CMD_LOCK,    CMD_LSQ,     CMD_MDEL,
+    CMD_MGET,   CMD_MIXED,    CMD_MKEY_T,      CMD_MKEYS,   CMD_MPUT,    CMD_NEWMAP,
+    CMD_NEWSPM, CMD_ODE,      CMD_PCOMPLX,     CMD_PEVAL,   CMD_PROOT,   CMD_PRREG,
+    CMD_PUTLI,  CMD_PUTMI,    CMD_RCOMPLX,     CMD_RSORT,   CMD_SORT,    CMD_SPARSE,
+    CMD_STATIC, CMD_STRACE,   CMD_UNLOCK,      CMD_WIDTH,   CMD_X2LINE,  CMD_ACCEL,
+    CMD_LOCAT,  CMD_HEADING,  CMD_NULL,        CMD_NULL,    CMD_NULL,    CMD_NULL
 };
-#define MISC_CAT_ROWS 5
+#define MISC_CAT_ROWS 9
 #endif
 #else
 #ifdef FREE42_FPTEST
 static int ext_misc_cat[] = {
-    CMD_A2LINE, CMD_A2PLINE, CMD_CAPS,   CMD_C_LN_1_X, CMD_C_E_POW_X_1, CMD_DYNAMIC,
-    CMD_FMA,    CMD_GETLI,   CMD_GETMI,  CMD_HEIGHT,   CMD_IDENT,       CMD_LOCK,
-    CMD_MIXED,  CMD_PCOMPLX, CMD_PRREG,  CMD_PUTLI,    CMD_PUTMI,       CMD_RCOMPLX,
-    CMD_STATIC, CMD_STRACE,  CMD_UNLOCK, CMD_WIDTH,    CMD_X2LINE,      CMD_FPTEST
+    CMD_A2LINE, CMD_A2PLINE,  CMD_BICGSTB,     CMD_BRACKET, CMD_BSRCH,   CMD_CAPS,
+    CMD_CG,     CMD_C_LN_1_X, CMD_C_E_POW_X_1, CMD_DENSE,   CMD_DYNAMIC, CMD_EIGEN,
+    CMD_EIGENV, CMD_FFT,      CMD_FMA,         CMD_GETLI,   CMD_GETMI,   CMD_HEIGHT,
+    CMD_IDENT,  CMD_IFFT,     CMD_INTERP,      CMD_LOCK,    CMD_LSQ,     CMD_MDEL,
+    CMD_MGET,   CMD_MIXED,    CMD_MKEY_T,      CMD_MKEYS,   CMD_MPUT,    CMD_NEWMAP,
+    CMD_NEWSPM, CMD_ODE,      CMD_PCOMPLX,     CMD_PEVAL,   CMD_PROOT,   CMD_PRREG,
+    CMD_PUTLI,  CMD_PUTMI,    CMD_RCOMPLX,     CMD_RSORT,   CMD_SORT,    CMD_SPARSE,
+    CMD_STATIC, CMD_STRACE,   CMD_UNLOCK,      CMD_WIDTH,   CMD_X2LINE,  CMD_FPTEST
 };
-#define MISC_CAT_ROWS 4
+#define MISC_CAT_ROWS 8
 #else
 static int ext_misc_cat[] = {
-    CMD_A2LINE, CMD_A2PLINE, CMD_CAPS,   CMD_C_LN_1_X, CMD_C_E_POW_X_1, CMD_DYNAMIC,
-    CMD_FMA,    CMD_GETLI,   CMD_GETMI,  CMD_HEIGHT,   CMD_IDENT,       CMD_LOCK,
-    CMD_MIXED,  CMD_PCOMPLX, CMD_PRREG,  CMD_PUTLI,    CMD_PUTMI,       CMD_RCOMPLX,
-    CMD_STATIC, CMD_STRACE,  CMD_UNLOCK, CMD_WIDTH,    CMD_X2LINE,      CMD_NULL
+    CMD_A2LINE, CMD_A2PLINE,  CMD_BICGSTB,     CMD_BRACKET, CMD_BSRCH,   CMD_CAPS,
+    CMD_CG,     CMD_C_LN_1_X, CMD_C_E_POW_X_1, CMD_DENSE,   CMD_DYNAMIC, CMD_EIGEN,
+    CMD_EIGENV, CMD_FFT,      CMD_FMA,         CMD_GETLI,   CMD_GETMI,   CMD_HEIGHT,
+    CMD_IDENT,  CMD_IFFT,     CMD_INTERP,      CMD_LOCK,    CMD_LSQ,     CMD_MDEL,
+    CMD_MGET,   CMD_MIXED,    CMD_MKEY_T,      CMD_MKEYS,   CMD_MPUT,    CMD_NEWMAP,
+    CMD_NEWSPM, CMD_ODE,      CMD_PCOMPLX,     CMD_PEVAL,   CMD_PROOT,   CMD_PRREG,
+    CMD_PUTLI,  CMD_PUTMI,    CMD_RCOMPLX,     CMD_RSORT,   CMD_SORT,    CMD_SPARSE,
+    CMD_STATIC, CMD_STRACE,   CMD_UNLOCK,      CMD_WIDTH,   CMD_X2LINE,  CMD_NULL
 };
-#define MISC_CAT_ROWS 4
+#define MISC_CAT_ROWS 8
 #endif
 #endif
 
@@ -1805,21 +1821,22 @@ static void draw_catalog() {
         int show_cpx = 1;
         int show_mat = 1;
         int show_list = 1;
+        int show_map = 1;
 
         switch (catsect) {
             case CATSECT_REAL:
             case CATSECT_REAL_ONLY:
-                show_cpx = show_mat = show_list = 0; break;
+                show_cpx = show_mat = show_list = show_map = 0; break;
             case CATSECT_CPX:
-                show_real = show_str = show_mat = show_list = 0; break;
+                show_real = show_str = show_mat = show_list = show_map = 0; break;
             case CATSECT_MAT:
             case CATSECT_MAT_ONLY:
-                show_real = show_str = show_cpx = show_list = 0; break;
+                show_real = show_str = show_cpx = show_list = show_map = 0; break;
             case CATSECT_MAT_LIST:
             case CATSECT_MAT_LIST_ONLY:
-                show_real = show_str = show_cpx = 0; break;
+                show_real = show_str = show_cpx = show_map = 0; break;
             case CATSECT_LIST_STR_ONLY:
-                show_real = show_cpx = show_mat = 0; break;
+                show_real = show_cpx = show_mat = show_map = 0; break;
             case CATSECT_LIST:
             case CATSECT_LIST_ONLY:
                 show_real = show_str = show_cpx = show_mat = 0; break;
@@ -1841,11 +1858,15 @@ static void draw_catalog() {
                     break;
                 case TYPE_REALMATRIX:
                 case TYPE_COMPLEXMATRIX:
+                case TYPE_SPARSEMATRIX:
                     if (show_mat) vcount++;
                     break;
                 case TYPE_LIST:
                     if (show_list) vcount++;
                     break;
+                case TYPE_MAP:
+                    if (show_map) vcount++;
+                    break;
             }
         }
         if (vcount == 0) {
@@ -1882,9 +1903,12 @@ static void draw_catalog() {
                     if (show_cpx) break; else continue;
                 case TYPE_REALMATRIX:
                 case TYPE_COMPLEXMATRIX:
+                case TYPE_SPARSEMATRIX:
                     if (show_mat) break; else continue;
                 case TYPE_LIST:
                     if (show_list) break; else continue;
+                case TYPE_MAP:
+                    if (show_map) break; else continue;
                 default:
                     continue;
             }
@@ -2054,15 +2078,16 @@ void show() {
             }
             case TYPE_REALMATRIX: {
                 vartype_realmatrix *rm = (vartype_realmatrix *) rx;
-                phloat *d = rm->array->data;
+                int4 n = rm->index(0);
+                phloat *d = rm->array->data + n;
                 bufptr = vartype2string(rx, buf, 22);
                 draw_string(0, 0, buf, bufptr);
                 draw_string(0, 1, "1:1=", 4);
                 bufptr = 0;
-                if (rm->array->is_string[0] != 0) {
+                if (rm->array->str(n) != 0) {
                     char *text;
                     int4 len;
-                    get_matrix_string(rm, 0, &text, &len);
+                    get_matrix_string(rm, n, &text, &len);
                     char2buf(buf, 18, &bufptr, '"');
                     string2buf(buf, 18, &bufptr, text, len);
                     if (bufptr < 18)
@@ -2082,12 +2107,24 @@ void show() {
                 draw_string(0, 0, buf, bufptr);
                 draw_string(0, 1, "1:1=", 4);
                 c.type = TYPE_COMPLEX;
-                c.re = cm->array->data[0];
-                c.im = cm->array->data[1];
+                int4 n = 2 * cm->index(0);
+                c.re = cm->array->data[n];
+                c.im = cm->array->data[n + 1];
                 bufptr = vartype2string((vartype *) &c, buf, 18);
                 draw_string(4, 1, buf, bufptr);
                 break;
             }
+            case TYPE_SPARSEMATRIX: {
+                vartype_sparsematrix *sm = (vartype_sparsematrix *) rx;
+                bufptr = vartype2string(rx, buf, 22);
+                draw_string(0, 0, buf, bufptr);
+                draw_string(0, 1, "1:1=", 4);
+                bufptr = phloat2string(sparse_get(sm, 0, 0), buf, 18,
+                                       0, 0, 3,
+                                       flags.f.thousands_separators);
+                draw_string(4, 1, buf, bufptr);
+                break;
+            }
         }
     }
     flush_display();
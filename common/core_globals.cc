@@ -85,6 +85,8 @@ const error_spec errors[] = {
     { /* NAME_TOO_LONG */          "Name Too Long",           13 },
     { /* PROGRAM_LOCKED */         "Program Locked",          14 },
     { /* NEXT_PROGRAM_LOCKED */    "Next Program Locked",     19 },
+    { /* ODE_ODE */                "ODE(ODE)",                 8 },
+    { /* ODE_LIMIT */              "ODE Limit",                9 },
 };
 
 
@@ -642,6 +644,7 @@ const char *virtual_flags =
 int vars_capacity = 0;
 int vars_count = 0;
 var_struct *vars = NULL;
+int local_vars_count = 0;
 
 /* Programs */
 int prgms_capacity = 0;
@@ -814,8 +817,11 @@ bool no_keystrokes_yet;
  * Version 51: 3.3    BASE enhancements (menu additions)
  * Version 52: 3.3    BASE enhancements (carry; display modes)
  * Version 53: 3.3.3  STATIC/DYNAMIC for menus
+ * Version 54: 3.3.7  Sparse matrices
+ * Version 55: 3.3.7  Associative maps
+ * Version 56: 3.3.7  ODE integrator
  */
-#define FREE42_VERSION 53
+#define FREE42_VERSION 56
 
 
 /*******************/
@@ -872,6 +878,7 @@ static bool rtn_level_0_has_func_state;
 static int rtn_stop_level = -1;
 static bool rtn_solve_active = false;
 static bool rtn_integ_active = false;
+static bool rtn_ode_active = false;
 
 #ifdef IPHONE
 /* For iPhone, we disable OFF by default, to satisfy App Store
@@ -913,7 +920,7 @@ void vartype_string::trim1() {
     } else if (length == SSLENV + 1) {
         char temp[SSLENV];
         memcpy(temp, t.ptr + 1, --length);
-        free(t.ptr);
+        free_string_text(t.ptr);
         memcpy(t.buf, temp, length);
     } else if (length > 0) {
         memmove(t.buf, t.buf + 1, --length);
@@ -963,7 +970,8 @@ static bool persist_vartype(vartype *v) {
             int4 rows = rm->rows;
             int4 columns = rm->columns;
             bool must_write = true;
-            if (rm->array->refcount > 1) {
+            // Views are written as ordinary, unshared matrices
+            if (rm->array->refcount > 1 && !rm->is_view()) {
                 int n = array_list_search(rm->array);
                 if (n == -1) {
                     // A negative row count signals a new shared matrix
@@ -983,16 +991,23 @@ static bool persist_vartype(vartype *v) {
             write_int4(columns);
             if (must_write) {
                 int size = rm->rows * rm->columns;
-                if (fwrite(rm->array->is_string, 1, size, gfile) != size)
-                    return false;
+                if (rm->is_view() || rm->array->is_string == NULL) {
+                    for (int i = 0; i < size; i++)
+                        if (!write_char(rm->array->str(rm->index(i))))
+                            return false;
+                } else {
+                    if (fwrite(rm->array->is_string, 1, size, gfile) != size)
+                        return false;
+                }
                 for (int i = 0; i < size; i++) {
-                    if (rm->array->is_string[i] == 0) {
-                        if (!write_phloat(rm->array->data[i]))
+                    int4 n = rm->index(i);
+                    if (rm->array->str(n) == 0) {
+                        if (!write_phloat(rm->array->data[n]))
                             return false;
                     } else {
                         char *text;
                         int4 len;
-                        get_matrix_string(rm, i, &text, &len);
+                        get_matrix_string(rm, n, &text, &len);
                         if (!write_int4(len))
                             return false;
                         if (fwrite(text, 1, len, gfile) != len)
@@ -1007,7 +1022,7 @@ static bool persist_vartype(vartype *v) {
             int4 rows = cm->rows;
             int4 columns = cm->columns;
             bool must_write = true;
-            if (cm->array->refcount > 1) {
+            if (cm->array->refcount > 1 && !cm->is_view()) {
                 int n = array_list_search(cm->array);
                 if (n == -1) {
                     // A negative row count signals a new shared matrix
@@ -1026,10 +1041,13 @@ static bool persist_vartype(vartype *v) {
             write_int4(rows);
             write_int4(columns);
             if (must_write) {
-                int size = 2 * cm->rows * cm->columns;
-                for (int i = 0; i < size; i++)
-                    if (!write_phloat(cm->array->data[i]))
+                int size = cm->rows * cm->columns;
+                for (int i = 0; i < size; i++) {
+                    int4 n = 2 * cm->index(i);
+                    if (!write_phloat(cm->array->data[n])
+                            || !write_phloat(cm->array->data[n + 1]))
                         return false;
+                }
             }
             return true;
         }
@@ -1061,6 +1079,72 @@ static bool persist_vartype(vartype *v) {
             }
             return true;
         }
+        case TYPE_SPARSEMATRIX: {
+            vartype_sparsematrix *sm = (vartype_sparsematrix *) v;
+            int4 rows = sm->rows;
+            int4 columns = sm->columns;
+            bool must_write = true;
+            if (sm->array->refcount > 1) {
+                int n = array_list_search(sm->array);
+                if (n == -1) {
+                    // A negative row count signals a new shared matrix
+                    rows = -rows;
+                    if (!array_list_grow())
+                        return false;
+                    array_list[array_count++] = sm->array;
+                } else {
+                    // A zero row count means this matrix shares its data
+                    // with a previously written matrix
+                    rows = 0;
+                    columns = n;
+                    must_write = false;
+                }
+            }
+            write_int4(rows);
+            write_int4(columns);
+            if (must_write) {
+                int4 nnz = sm->nnz();
+                if (!write_int4(nnz))
+                    return false;
+                for (int4 i = 1; i <= sm->rows; i++)
+                    if (!write_int4(sm->array->rowptr[i]))
+                        return false;
+                for (int4 i = 0; i < nnz; i++)
+                    if (!write_int4(sm->array->colidx[i])
+                            || !write_phloat(sm->array->values[i]))
+                        return false;
+            }
+            return true;
+        }
+        case TYPE_MAP: {
+            vartype_map *map = (vartype_map *) v;
+            int data_index = -1;
+            bool must_write = true;
+            if (map->array->refcount > 1) {
+                int n = array_list_search(map->array);
+                if (n == -1) {
+                    // data_index == -2 indicates a new shared map
+                    data_index = -2;
+                    if (!array_list_grow())
+                        return false;
+                    array_list[array_count++] = map->array;
+                } else {
+                    // data_index >= 0 refers to a previously shared map
+                    data_index = n;
+                    must_write = false;
+                }
+            }
+            write_int4(map->array->size);
+            write_int(data_index);
+            if (must_write) {
+                for (int4 i = 0; i < map->array->capacity; i++)
+                    if (map->array->keys[i] != NULL
+                            && (!persist_vartype(map->array->keys[i])
+                                || !persist_vartype(map->array->values[i])))
+                        return false;
+            }
+            return true;
+        }
         default:
             /* Should not happen */
             return false;
@@ -1168,7 +1252,8 @@ static bool unpersist_vartype(vartype **v) {
             if (rm == NULL)
                 return false;
             int4 size = rows * columns;
-            if (fread(rm->array->is_string, 1, size, gfile) != size) {
+            if (!alloc_string_map(rm->array)
+                    || fread(rm->array->is_string, 1, size, gfile) != size) {
                 free_vartype((vartype *) rm);
                 return false;
             }
@@ -1176,11 +1261,12 @@ static bool unpersist_vartype(vartype **v) {
             int4 i;
             for (i = 0; i < size; i++) {
                 success = false;
-                if (rm->array->is_string[i] == 0) {
+                if (rm->array->str(i) == 0) {
                     if (!read_phloat(&rm->array->data[i]))
                         break;
                 } else {
                     rm->array->is_string[i] = 1;
+                    rm->array->nstrings++;
                     if (bug_mode == 0) {
                         if (ver < 34) {
                             // 6 bytes of text followed by length byte
@@ -1250,6 +1336,10 @@ static bool unpersist_vartype(vartype **v) {
                 free_vartype((vartype *) rm);
                 return false;
             }
+            if (rm->array->nstrings == 0) {
+                free(rm->array->is_string);
+                rm->array->is_string = NULL;
+            }
             if (shared) {
                 if (!array_list_grow()) {
                     free_vartype((vartype *) rm);
@@ -1332,6 +1422,108 @@ static bool unpersist_vartype(vartype **v) {
             *v = (vartype *) list;
             return true;
         }
+        case TYPE_SPARSEMATRIX: {
+            int4 rows, columns, nnz;
+            if (!read_int4(&rows) || !read_int4(&columns))
+                return false;
+            if (rows == 0) {
+                // Shared matrix
+                vartype *m = dup_vartype((vartype *) array_list[columns]);
+                if (m == NULL)
+                    return false;
+                else {
+                    *v = m;
+                    return true;
+                }
+            }
+            bool shared = rows < 0;
+            if (shared)
+                rows = -rows;
+            if (!read_int4(&nnz) || nnz < 0)
+                return false;
+            vartype_sparsematrix *sm = (vartype_sparsematrix *) new_sparsematrix(rows, columns, nnz);
+            if (sm == NULL)
+                return false;
+            sparsematrix_data *sd = sm->array;
+            bool success = false;
+            int4 i;
+            for (i = 1; i <= rows; i++)
+                if (!read_int4(&sd->rowptr[i])
+                        || sd->rowptr[i] < sd->rowptr[i - 1]
+                        || sd->rowptr[i] > nnz)
+                    goto sparse_done;
+            if (sd->rowptr[rows] != nnz)
+                goto sparse_done;
+            for (i = 0; i < nnz; i++)
+                if (!read_int4(&sd->colidx[i])
+                        || sd->colidx[i] < 0 || sd->colidx[i] >= columns
+                        || !read_phloat(&sd->values[i]))
+                    goto sparse_done;
+            success = true;
+            sparse_done:
+            if (!success) {
+                free_vartype((vartype *) sm);
+                return false;
+            }
+            if (shared) {
+                if (!array_list_grow()) {
+                    free_vartype((vartype *) sm);
+                    return false;
+                }
+                array_list[array_count++] = sm;
+            }
+            *v = (vartype *) sm;
+            return true;
+        }
+        case TYPE_MAP: {
+            int4 size;
+            int data_index;
+            if (!read_int4(&size) || !read_int(&data_index) || size < 0)
+                return false;
+            if (data_index >= 0) {
+                // Shared map
+                vartype *m = dup_vartype((vartype *) array_list[data_index]);
+                if (m == NULL)
+                    return false;
+                else {
+                    *v = m;
+                    return true;
+                }
+            }
+            bool shared = data_index == -2;
+            vartype_map *map = (vartype_map *) new_map(size);
+            if (map == NULL)
+                return false;
+            if (shared) {
+                if (!array_list_grow()) {
+                    free_vartype((vartype *) map);
+                    return false;
+                }
+                array_list[array_count++] = map;
+            }
+            for (int4 i = 0; i < size; i++) {
+                vartype *key, *value;
+                if (!unpersist_vartype(&key))
+                    goto map_fail;
+                if (key == NULL || !is_map_key(key)) {
+                    free_vartype(key);
+                    goto map_fail;
+                }
+                if (!unpersist_vartype(&value)) {
+                    free_vartype(key);
+                    goto map_fail;
+                }
+                if (!map_put(map, key, value)) {
+                    free_vartype(key);
+                    free_vartype(value);
+                    map_fail:
+                    free_vartype((vartype *) map);
+                    return false;
+                }
+            }
+            *v = (vartype *) map;
+            return true;
+        }
         default:
             return false;
     }
@@ -1441,6 +1633,8 @@ static bool persist_globals() {
         goto done;
     if (!write_bool(rtn_integ_active))
         goto done;
+    if (!write_bool(rtn_ode_active))
+        goto done;
     ret = true;
 
     done:
@@ -1595,6 +1789,8 @@ static bool unpersist_globals() {
         free(vars);
         vars = NULL;
     }
+    invalidate_var_index();
+    local_vars_count = 0;
     if (!read_int(&vars_count)) {
         vars_count = 0;
         goto done;
@@ -1628,8 +1824,11 @@ static bool unpersist_globals() {
             free(vars);
             vars = NULL;
             vars_count = 0;
+            local_vars_count = 0;
             goto done;
         }
+        if (vars[i].level != -1)
+            local_vars_count++;
     }
     vars_capacity = vars_count;
 
@@ -1763,6 +1962,8 @@ static bool unpersist_globals() {
                 vars[pos].flags = VAR_PRIVATE;
                 vars[pos].value = (vartype *) list;
                 vars_count++;
+                local_vars_count++;
+                invalidate_var_index();
             }
         }
         current_prgm = saved_prgm;
@@ -1771,6 +1972,10 @@ static bool unpersist_globals() {
         goto done;
     if (!read_bool(&rtn_integ_active))
         goto done;
+    if (ver < 56)
+        rtn_ode_active = false;
+    else if (!read_bool(&rtn_ode_active))
+        goto done;
 
     ret = true;
 
@@ -2802,6 +3007,8 @@ int push_rtn_addr(int prgm, int4 pc) {
         rtn_solve_active = true;
     else if (prgm == -3)
         rtn_integ_active = true;
+    else if (prgm == -4)
+        rtn_ode_active = true;
     return ERR_NONE;
 }
 
@@ -2942,6 +3149,7 @@ int push_func_state(int n) {
     vartype **tmpstk = tlist->array->data;
     int4 tmpdepth = tlist->size;
     tlist->array->data = stack;
+    tlist->array->capacity = stack_capacity;
     tlist->size = sp + 1;
     stack = tmpstk;
     stack_capacity = 4;
@@ -3034,6 +3242,7 @@ int push_stack_state(bool big) {
             vartype **tmpstk = tlist->array->data;
             int4 tmpdepth = tlist->size;
             tlist->array->data = stack;
+            tlist->array->capacity = stack_capacity;
             tlist->size = sp + 1;
             stack = tmpstk;
             stack_capacity = tmpdepth;
@@ -3060,14 +3269,7 @@ int push_stack_state(bool big) {
  * capacity.
  */
 static bool ensure_list_capacity_4(vartype_list *list) {
-    int4 size = list->size;
-    if (size < 4) {
-        vartype **newdata = (vartype **) realloc(list->array->data, 4 * sizeof(vartype *));
-        if (newdata == NULL)
-            return false;
-        list->array->data = newdata;
-    }
-    return true;
+    return reserve_list(list, 4);
 }
 
 int pop_func_state(bool error) {
@@ -3120,10 +3322,12 @@ int pop_func_state(bool error) {
             }
             vartype **tmpstk = stack;
             int tmpsize = sp + 1;
+            int tmpcap = stack_capacity;
             stack = tlist->array->data;
             stack_capacity = tlist->size;
             sp = stack_capacity - 1;
             tlist->array->data = tmpstk;
+            tlist->array->capacity = tmpcap;
             tlist->size = tmpsize;
         } else if (!big && flags.f.big_stack) {
             if (sp < 3) {
@@ -3164,12 +3368,14 @@ int pop_func_state(bool error) {
 
         vartype **tmpstk = stack;
         int tmpsize = sp + 1;
+        int tmpcap = stack_capacity;
         stack = tlist->array->data;
         stack_capacity = tlist->size;
         sp = stack_capacity - 1;
         if (stack_capacity < 4)
             stack_capacity = 4;
         tlist->array->data = tmpstk;
+        tlist->array->capacity = tmpcap;
         tlist->size = tmpsize;
 
         if (error)
@@ -3306,11 +3512,13 @@ static void remove_locals() {
     if (matedit_mode == 3 && matedit_level >= rtn_level)
         leave_matrix_editor();
     int last = -1;
-    for (int i = vars_count - 1; i >= 0; i--) {
+    int unseen = local_vars_count;
+    for (int i = vars_count - 1; i >= 0 && unseen > 0; i--) {
         if (vars[i].level == -1)
             continue;
         if (vars[i].level < rtn_level)
             break;
+        unseen--;
         if ((matedit_mode == 1 || matedit_mode == 3)
                 && vars[i].level == matedit_level
                 && string_equals(vars[i].name, vars[i].length, matedit_name, matedit_length)) {
@@ -3323,10 +3531,13 @@ static void remove_locals() {
             matedit_stack = NULL;
             matedit_stack_depth = 0;
         }
+        if ((vars[i].flags & (VAR_HIDDEN | VAR_PRIVATE)) == 0)
+            var_index_remove(i);
         if ((vars[i].flags & VAR_HIDING) != 0) {
             for (int j = i - 1; j >= 0; j--)
                 if ((vars[j].flags & VAR_HIDDEN) != 0 && string_equals(vars[i].name, vars[i].length, vars[j].name, vars[j].length)) {
                     vars[j].flags &= ~VAR_HIDDEN;
+                    var_index_add(j);
                     break;
                 }
         }
@@ -3339,11 +3550,16 @@ static void remove_locals() {
     int from = last;
     int to = last;
     while (from < vars_count) {
-        if (vars[from].length != 100)
-            vars[to++] = vars[from];
+        if (vars[from].length != 100) {
+            vars[to] = vars[from];
+            if ((vars[to].flags & (VAR_HIDDEN | VAR_PRIVATE)) == 0)
+                var_index_move(from, to);
+            to++;
+        }
         from++;
     }
     vars_count -= from - to;
+    local_vars_count -= from - to;
     update_catalog();
 }
 
@@ -3355,7 +3571,9 @@ int rtn(int err) {
     int4 newpc;
     bool stop;
     pop_rtn_addr(&newprgm, &newpc, &stop);
-    if (newprgm == -3) {
+    if (newprgm == -4) {
+        return return_to_ode(stop);
+    } else if (newprgm == -3) {
         return return_to_integ(stop);
     } else if (newprgm == -2) {
         return return_to_solve(0, stop);
@@ -3448,6 +3666,8 @@ void pop_rtn_addr(int *prgm, int4 *pc, bool *stop) {
             rtn_solve_active = false;
         else if (*prgm == -3)
             rtn_integ_active = false;
+        else if (*prgm == -4)
+            rtn_ode_active = false;
     }
 }
 
@@ -3515,6 +3735,10 @@ bool integ_active() {
     return rtn_integ_active;
 }
 
+bool ode_active() {
+    return rtn_ode_active;
+}
+
 bool unwind_stack_until_solve() {
     int prgm;
     int4 pc;
@@ -4196,6 +4420,7 @@ void hard_reset(int reason) {
     rtn_stop_level = -1;
     rtn_solve_active = false;
     rtn_integ_active = false;
+    rtn_ode_active = false;
 
     /* Clear programs */
     if (prgms != NULL) {
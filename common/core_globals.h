@@ -74,6 +74,8 @@ extern FILE *gfile;
 #define ERR_NAME_TOO_LONG          39
 #define ERR_PROGRAM_LOCKED         40
 #define ERR_NEXT_PROGRAM_LOCKED    41
+#define ERR_ODE_ODE                42
+#define ERR_ODE_LIMIT              43
 
 #define RTNERR_MAX 8
 
@@ -350,6 +352,10 @@ struct var_struct {
 extern int vars_capacity;
 extern int vars_count;
 extern var_struct *vars;
+/* Number of entries in vars[] whose level is not -1; lets remove_locals()
+ * stop as soon as it has seen them all, instead of walking past every
+ * global variable. */
+extern int local_vars_count;
 
 /* Programs */
 struct prgm_struct {
@@ -580,6 +586,7 @@ void save_csld();
 bool is_csld();
 bool solve_active();
 bool integ_active();
+bool ode_active();
 bool unwind_stack_until_solve();
 
 bool read_bool(bool *b);
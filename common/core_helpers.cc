@@ -32,7 +32,7 @@ int resolve_ind_arg(arg_struct *arg, char *buf, int *buflen) {
     vartype *v;
     switch (arg->type) {
         case ARGTYPE_IND_NUM: {
-            vartype *regs = recall_var("REGS", 4);
+            vartype *regs = recall_regs();
             if (regs == NULL)
                 return ERR_SIZE_ERROR;
             if (regs->type != TYPE_REALMATRIX)
@@ -43,7 +43,7 @@ int resolve_ind_arg(arg_struct *arg, char *buf, int *buflen) {
                 int4 num = arg->val.num;
                 if (num >= size)
                     return ERR_SIZE_ERROR;
-                if (rm->array->is_string[num] == 0) {
+                if (rm->array->str(num) == 0) {
                     phloat x = rm->array->data[num];
                     if (x < 0)
                         x = -x;
@@ -255,10 +255,16 @@ int unary_two_results(vartype *x, vartype *y) {
 
 int unary_no_result() {
     if (!flags.f.big_stack) {
-        vartype *t = dup_vartype(stack[REG_T]);
-        if (t == NULL)
-            return ERR_INSUFFICIENT_MEMORY;
-        free_vartype(lastx);
+        vartype *t;
+        if (scalar_reusable(lastx, stack[REG_T])) {
+            t = lastx;
+            copy_scalar(t, stack[REG_T]);
+        } else {
+            t = dup_vartype(stack[REG_T]);
+            if (t == NULL)
+                return ERR_INSUFFICIENT_MEMORY;
+            free_vartype(lastx);
+        }
         lastx = stack[REG_X];
         stack[REG_X] = stack[REG_Y];
         stack[REG_Y] = stack[REG_Z];
@@ -273,16 +279,24 @@ int unary_no_result() {
 
 int binary_result(vartype *x) {
     vartype *t;
+    bool reuse_y = false;
     if (!flags.f.big_stack) {
-        t = dup_vartype(stack[REG_T]);
-        if (t == NULL) {
-            free_vartype(x);
-            return ERR_INSUFFICIENT_MEMORY;
+        reuse_y = scalar_reusable(stack[REG_Y], stack[REG_T]);
+        if (reuse_y) {
+            t = stack[REG_Y];
+            copy_scalar(t, stack[REG_T]);
+        } else {
+            t = dup_vartype(stack[REG_T]);
+            if (t == NULL) {
+                free_vartype(x);
+                return ERR_INSUFFICIENT_MEMORY;
+            }
         }
     }
     free_vartype(lastx);
     lastx = stack[sp];
-    free_vartype(stack[sp - 1]);
+    if (!reuse_y)
+        free_vartype(stack[sp - 1]);
     if (flags.f.big_stack) {
         sp--;
     } else {
@@ -317,21 +331,30 @@ int ternary_result(vartype *x) {
         free_vartype(stack[sp - 2]);
         sp -= 2;
     } else {
-        vartype *tt = dup_vartype(stack[REG_T]);
+        bool reuse_y = scalar_reusable(stack[REG_Y], stack[REG_T]);
+        bool reuse_z = scalar_reusable(stack[REG_Z], stack[REG_T]);
+        vartype *tt = reuse_y ? stack[REG_Y] : dup_vartype(stack[REG_T]);
         if (tt == NULL) {
             free_vartype(x);
             return ERR_INSUFFICIENT_MEMORY;
         }
-        vartype *ttt = dup_vartype(stack[REG_T]);
+        vartype *ttt = reuse_z ? stack[REG_Z] : dup_vartype(stack[REG_T]);
         if (ttt == NULL) {
             free_vartype(x);
-            free_vartype(tt);
+            if (!reuse_y)
+                free_vartype(tt);
             return ERR_INSUFFICIENT_MEMORY;
         }
+        if (reuse_y)
+            copy_scalar(tt, stack[REG_T]);
+        else
+            free_vartype(stack[REG_Y]);
+        if (reuse_z)
+            copy_scalar(ttt, stack[REG_T]);
+        else
+            free_vartype(stack[REG_Z]);
         free_vartype(lastx);
         lastx = stack[REG_X];
-        free_vartype(stack[REG_Y]);
-        free_vartype(stack[REG_Z]);
         stack[REG_Y] = tt;
         stack[REG_Z] = ttt;
     }
@@ -340,6 +363,39 @@ int ternary_result(vartype *x) {
     return ERR_NONE;
 }
 
+int quaternary_two_results(vartype *x, vartype *y) {
+    if (flags.f.big_stack) {
+        free_vartype(lastx);
+        lastx = stack[sp];
+        free_vartype(stack[sp - 1]);
+        free_vartype(stack[sp - 2]);
+        free_vartype(stack[sp - 3]);
+        sp -= 2;
+    } else {
+        vartype *tt;
+        if (scalar_reusable(stack[REG_Z], stack[REG_T])) {
+            tt = stack[REG_Z];
+            copy_scalar(tt, stack[REG_T]);
+        } else {
+            tt = dup_vartype(stack[REG_T]);
+            if (tt == NULL) {
+                free_vartype(x);
+                free_vartype(y);
+                return ERR_INSUFFICIENT_MEMORY;
+            }
+            free_vartype(stack[REG_Z]);
+        }
+        free_vartype(lastx);
+        lastx = stack[REG_X];
+        free_vartype(stack[REG_Y]);
+        stack[REG_Z] = tt;
+    }
+    stack[sp - 1] = y;
+    stack[sp] = x;
+    print_trace();
+    return ERR_NONE;
+}
+
 bool ensure_stack_capacity(int n) {
     if (!flags.f.big_stack)
         return true;
@@ -430,36 +486,64 @@ bool string_equals(const char *s1, int s1len, const char *s2, int s2len) {
     return true;
 }
 
+/* Finds the first occurrence of needle in haystack at or after startpos.
+ * Short needles are located with memchr() on their first character;
+ * longer ones use Boyer-Moore-Horspool, which compares the last character
+ * of each window first and can skip up to the length of the needle on a
+ * mismatch.
+ */
+static int text_search(const char *haystack, int hlen,
+                       const char *needle, int nlen, int startpos) {
+    int last = hlen - nlen;
+    if (startpos > last)
+        return -1;
+    if (nlen < 4) {
+        int i = startpos;
+        while (i <= last) {
+            const char *p = (const char *) memchr(haystack + i, needle[0], last - i + 1);
+            if (p == NULL)
+                return -1;
+            i = (int) (p - haystack);
+            if (memcmp(p + 1, needle + 1, nlen - 1) == 0)
+                return i;
+            i++;
+        }
+        return -1;
+    }
+    int skip[256];
+    for (int c = 0; c < 256; c++)
+        skip[c] = nlen;
+    for (int j = 0; j < nlen - 1; j++)
+        skip[(unsigned char) needle[j]] = nlen - 1 - j;
+    char lastc = needle[nlen - 1];
+    for (int i = startpos; i <= last; ) {
+        char c = haystack[i + nlen - 1];
+        if (c == lastc && memcmp(haystack + i, needle, nlen - 1) == 0)
+            return i;
+        i += skip[(unsigned char) c];
+    }
+    return -1;
+}
+
 int string_pos(const char *ntext, int nlen, const vartype *hs, int startpos) {
     int pos = -1;
     if (hs->type == TYPE_REAL) {
         phloat x = ((const vartype_real *) hs)->x;
         char c;
-        int i;
         if (x < 0)
             x = -x;
         if (x >= 256)
             return -2;
         c = to_char(x);
-        for (i = startpos; i < nlen; i++)
-            if (ntext[i] == c) {
-                pos = i;
-                break;
-            }
+        if (startpos < nlen) {
+            const char *p = (const char *) memchr(ntext + startpos, c, nlen - startpos);
+            if (p != NULL)
+                pos = (int) (p - ntext);
+        }
     } else {
         const vartype_string *s = (const vartype_string *) hs;
-        if (s->length != 0) {
-            int i, j;
-            const char *text = s->txt();
-            for (i = startpos; i < nlen - s->length + 1; i++) {
-                for (j = 0; j < s->length; j++)
-                    if (ntext[i + j] != text[j])
-                        goto notfound;
-                pos = i;
-                break;
-                notfound:;
-            }
-        }
+        if (s->length != 0)
+            pos = text_search(ntext, nlen, s->txt(), s->length, startpos);
     }
     return pos;
 }
@@ -481,25 +565,34 @@ bool vartype_equals(const vartype *v1, const vartype *v2) {
         case TYPE_REALMATRIX: {
             const vartype_realmatrix *x = (const vartype_realmatrix *) v1;
             const vartype_realmatrix *y = (const vartype_realmatrix *) v2;
-            if (x->array == y->array)
-                return true;
             int4 sz, i;
             if (x->rows != y->rows || x->columns != y->columns)
                 return false;
+            if (x->array == y->array && x->offset == y->offset
+                    && x->rowstride == y->rowstride
+                    && x->colstride == y->colstride)
+                return true;
+            // The hashes are cached, so after the first comparison, this
+            // rejects unequal matrices without looking at their elements.
+            if (!x->is_view() && !y->is_view()
+                    && content_hash(v1) != content_hash(v2))
+                return false;
             sz = x->rows * x->columns;
             for (i = 0; i < sz; i++) {
-                int xstr = x->array->is_string[i];
-                int ystr = y->array->is_string[i];
+                int4 xi = x->index(i);
+                int4 yi = y->index(i);
+                int xstr = x->array->str(xi);
+                int ystr = y->array->str(yi);
                 if (xstr != ystr)
                     return false;
                 if (xstr == 0) {
-                    if (x->array->data[i] != y->array->data[i])
+                    if (x->array->data[xi] != y->array->data[yi])
                         return false;
                 } else {
                     int len1, len2;
                     const char *text1, *text2;
-                    get_matrix_string(x, i, &text1, &len1);
-                    get_matrix_string(y, i, &text2, &len2);
+                    get_matrix_string(x, xi, &text1, &len1);
+                    get_matrix_string(y, yi, &text2, &len2);
                     if (!string_equals(text1, len1, text2, len2))
                         return false;
                 }
@@ -509,14 +602,39 @@ bool vartype_equals(const vartype *v1, const vartype *v2) {
         case TYPE_COMPLEXMATRIX: {
             const vartype_complexmatrix *x = (const vartype_complexmatrix *) v1;
             const vartype_complexmatrix *y = (const vartype_complexmatrix *) v2;
-            if (x->array == y->array)
-                return true;
             int4 sz, i;
             if (x->rows != y->rows || x->columns != y->columns)
                 return false;
-            sz = 2 * x->rows * x->columns;
-            for (i = 0; i < sz; i++)
-                if (x->array->data[i] != y->array->data[i])
+            if (x->array == y->array && x->offset == y->offset
+                    && x->rowstride == y->rowstride
+                    && x->colstride == y->colstride)
+                return true;
+            sz = x->rows * x->columns;
+            for (i = 0; i < sz; i++) {
+                int4 xi = 2 * x->index(i);
+                int4 yi = 2 * y->index(i);
+                if (x->array->data[xi] != y->array->data[yi]
+                        || x->array->data[xi + 1] != y->array->data[yi + 1])
+                    return false;
+            }
+            return true;
+        }
+        case TYPE_SPARSEMATRIX: {
+            const vartype_sparsematrix *x = (const vartype_sparsematrix *) v1;
+            const vartype_sparsematrix *y = (const vartype_sparsematrix *) v2;
+            if (x->rows != y->rows || x->columns != y->columns)
+                return false;
+            if (x->array == y->array)
+                return true;
+            int4 nnz = x->nnz();
+            if (nnz != y->nnz())
+                return false;
+            for (int4 i = 1; i <= x->rows; i++)
+                if (x->array->rowptr[i] != y->array->rowptr[i])
+                    return false;
+            for (int4 i = 0; i < nnz; i++)
+                if (x->array->colidx[i] != y->array->colidx[i]
+                        || x->array->values[i] != y->array->values[i])
                     return false;
             return true;
         }
@@ -532,6 +650,8 @@ bool vartype_equals(const vartype *v1, const vartype *v2) {
                 return true;
             if (x->size != y->size)
                 return false;
+            if (content_hash(v1) != content_hash(v2))
+                return false;
             int4 sz = x->size;
             const vartype **data1 = (const vartype **) x->array->data;
             const vartype **data2 = (const vartype **) y->array->data;
@@ -540,12 +660,149 @@ bool vartype_equals(const vartype *v1, const vartype *v2) {
                     return false;
             return true;
         }
+        case TYPE_MAP: {
+            const vartype_map *x = (const vartype_map *) v1;
+            const vartype_map *y = (const vartype_map *) v2;
+            if (x->array == y->array)
+                return true;
+            if (x->array->size != y->array->size)
+                return false;
+            for (int4 i = 0; i < x->array->capacity; i++) {
+                const vartype *key = x->array->keys[i];
+                if (key == NULL)
+                    continue;
+                int4 j = map_find(y, key);
+                if (j == -1 || !vartype_equals(x->array->values[i], y->array->values[j]))
+                    return false;
+            }
+            return true;
+        }
         default:
             /* Looks like someone added a type that we're not handling yet! */
             return false;
     }
 }
 
+/* The ordering used by SORT and the lookup functions. Values of different
+ * types are ordered real < complex < string < everything else, the rest
+ * going by type number. Reals compare numerically, complex numbers by real
+ * part and then imaginary part, strings by character code, and lists and
+ * real matrices element by element, with a shorter list or a smaller matrix
+ * ordering first when one is a prefix of the other. Complex and sparse
+ * matrices and maps are grouped by type but not ordered among themselves.
+ * Values that are vartype_equals() always compare as 0.
+ */
+
+static int type_rank(int type) {
+    switch (type) {
+        case TYPE_REAL: return 0;
+        case TYPE_COMPLEX: return 1;
+        case TYPE_STRING: return 2;
+        default: return 2 + type;
+    }
+}
+
+static int phloat_compare(phloat x, phloat y) {
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+int text_compare(const char *s1, int4 s1len, const char *s2, int4 s2len) {
+    int4 n = s1len < s2len ? s1len : s2len;
+    for (int4 i = 0; i < n; i++) {
+        unsigned char c1 = s1[i];
+        unsigned char c2 = s2[i];
+        if (c1 != c2)
+            return c1 < c2 ? -1 : 1;
+    }
+    return s1len < s2len ? -1 : s1len > s2len ? 1 : 0;
+}
+
+int matrix_element_compare(const vartype_realmatrix *m1, int4 i1,
+                           const vartype_realmatrix *m2, int4 i2) {
+    bool str1 = m1->array->str(i1) != 0;
+    bool str2 = m2->array->str(i2) != 0;
+    if (str1 != str2)
+        return str1 ? 1 : -1;
+    if (!str1)
+        return phloat_compare(m1->array->data[i1], m2->array->data[i2]);
+    const char *text1, *text2;
+    int4 len1, len2;
+    get_matrix_string(m1, i1, &text1, &len1);
+    get_matrix_string(m2, i2, &text2, &len2);
+    return text_compare(text1, len1, text2, len2);
+}
+
+int matrix_element_compare_to(const vartype_realmatrix *m, int4 i,
+                              const vartype *v) {
+    bool str = m->array->str(i) != 0;
+    if (v->type != (str ? TYPE_STRING : TYPE_REAL)) {
+        int r1 = type_rank(str ? TYPE_STRING : TYPE_REAL);
+        int r2 = type_rank(v->type);
+        return r1 < r2 ? -1 : 1;
+    }
+    if (!str)
+        return phloat_compare(m->array->data[i], ((const vartype_real *) v)->x);
+    const char *text;
+    int4 len;
+    get_matrix_string(m, i, &text, &len);
+    const vartype_string *s = (const vartype_string *) v;
+    return text_compare(text, len, s->txt(), s->length);
+}
+
+int vartype_compare(const vartype *v1, const vartype *v2) {
+    if (v1->type != v2->type) {
+        int r1 = type_rank(v1->type);
+        int r2 = type_rank(v2->type);
+        return r1 < r2 ? -1 : 1;
+    }
+    switch (v1->type) {
+        case TYPE_REAL:
+            return phloat_compare(((const vartype_real *) v1)->x,
+                                  ((const vartype_real *) v2)->x);
+        case TYPE_COMPLEX: {
+            const vartype_complex *x = (const vartype_complex *) v1;
+            const vartype_complex *y = (const vartype_complex *) v2;
+            int c = phloat_compare(x->re, y->re);
+            return c != 0 ? c : phloat_compare(x->im, y->im);
+        }
+        case TYPE_STRING: {
+            const vartype_string *x = (const vartype_string *) v1;
+            const vartype_string *y = (const vartype_string *) v2;
+            return text_compare(x->txt(), x->length, y->txt(), y->length);
+        }
+        case TYPE_LIST: {
+            const vartype_list *x = (const vartype_list *) v1;
+            const vartype_list *y = (const vartype_list *) v2;
+            if (x->array == y->array)
+                return 0;
+            int4 n = x->size < y->size ? x->size : y->size;
+            for (int4 i = 0; i < n; i++) {
+                int c = vartype_compare(x->array->data[i], y->array->data[i]);
+                if (c != 0)
+                    return c;
+            }
+            return x->size < y->size ? -1 : x->size > y->size ? 1 : 0;
+        }
+        case TYPE_REALMATRIX: {
+            const vartype_realmatrix *x = (const vartype_realmatrix *) v1;
+            const vartype_realmatrix *y = (const vartype_realmatrix *) v2;
+            if (x->rows != y->rows)
+                return x->rows < y->rows ? -1 : 1;
+            if (x->columns != y->columns)
+                return x->columns < y->columns ? -1 : 1;
+            int4 sz = x->rows * x->columns;
+            for (int4 i = 0; i < sz; i++) {
+                int c = matrix_element_compare(x, x->index(i), y, y->index(i));
+                if (c != 0)
+                    return c;
+            }
+            return 0;
+        }
+        default:
+            return 0;
+    }
+}
+
 int anum(const char *text, int len, phloat *res) {
     char buf[50];
     int src_pos = 0;
@@ -1406,6 +1663,7 @@ int dimension_array(const char *name, int namelen, int4 rows, int4 columns, bool
     int4 size = rows * columns;
     if (matrix == NULL || (matrix->type != TYPE_REALMATRIX
                         && matrix->type != TYPE_COMPLEXMATRIX
+                        && matrix->type != TYPE_SPARSEMATRIX
                         && matrix->type != TYPE_LIST)) {
         vartype *newmatrix;
         if (size == 0)
@@ -1432,54 +1690,17 @@ int dimension_array_ref(vartype *matrix, int4 rows, int4 columns) {
             return ERR_NONE;
         if (oldmatrix->array->refcount == 1) {
             int4 oldsize = oldmatrix->rows * oldmatrix->columns;
-            if (size == oldsize) {
-                /* Easy case! */
-                oldmatrix->rows = rows;
-                oldmatrix->columns = columns;
-                return ERR_NONE;
-            } else if (size < oldsize) {
-                /* Also pretty easy, shrinking means we don't have to worry
-                 * about allocation failures. We do deal with realloc()
-                 * failures, because technically, realloc() can fail even when
-                 * shrinking, but that is easy to handle by simply hanging onto
-                 * the existing block.
+            oldmatrix->array->hash = 0;
+            if (size != oldsize) {
+                /* Since there are no shared references to this array,
+                 * I can modify it in place using a realloc().
                  */
-                free_long_strings(oldmatrix->array->is_string + size, oldmatrix->array->data + size, oldsize - size);
-                char *new_is_string = (char *) realloc(oldmatrix->array->is_string, size);
-                if (new_is_string != NULL)
-                    oldmatrix->array->is_string = new_is_string;
-                phloat *new_data = (phloat *) realloc((void *) oldmatrix->array->data, size * sizeof(phloat));
-                if (new_data != NULL)
-                    oldmatrix->array->data = new_data;
-                oldmatrix->rows = rows;
-                oldmatrix->columns = columns;
-                return ERR_NONE;
-            }
-            /* Since there are no shared references to this array,
-             * I can modify it in place using a realloc(). However, I
-             * only use realloc() on the 'data' array, not on the
-             * 'is_string' array -- if I used it on both, and the second
-             * call fails, I might be unable to roll back the first.
-             * So, playing safe -- shouldn't be too big a handicap since
-             * 'is_string' is a lot smaller than 'data', so the transient
-             * memory overhead is only about 12.5%.
-             */
-            char *new_is_string = (char *) malloc(size);
-            if (new_is_string == NULL)
-                return ERR_INSUFFICIENT_MEMORY;
-            phloat *new_data = (phloat *) realloc((void *) oldmatrix->array->data, size * sizeof(phloat));
-            if (new_data == NULL) {
-                free(new_is_string);
-                return ERR_INSUFFICIENT_MEMORY;
-            }
-            memcpy(new_is_string, oldmatrix->array->is_string, oldsize);
-            for (int4 i = oldsize; i < size; i++) {
-                new_is_string[i] = 0;
-                new_data[i] = 0;
+                realmatrix_data *new_array =
+                        resize_realmatrix_data(oldmatrix->array, size);
+                if (new_array == NULL)
+                    return ERR_INSUFFICIENT_MEMORY;
+                oldmatrix->array = new_array;
             }
-            free(oldmatrix->array->is_string);
-            oldmatrix->array->is_string = new_is_string;
-            oldmatrix->array->data = new_data;
             oldmatrix->rows = rows;
             oldmatrix->columns = columns;
             return ERR_NONE;
@@ -1492,32 +1713,29 @@ int dimension_array_ref(vartype *matrix, int4 rows, int4 columns) {
              */
             realmatrix_data *new_array;
             int4 i, s, oldsize;
-            new_array = (realmatrix_data *) malloc(sizeof(realmatrix_data));
+            new_array = new_realmatrix_data(size);
             if (new_array == NULL)
                 return ERR_INSUFFICIENT_MEMORY;
-            new_array->data = (phloat *) malloc(size * sizeof(phloat));
-            if (new_array->data == NULL) {
-                free(new_array);
-                return ERR_INSUFFICIENT_MEMORY;
-            }
-            new_array->is_string = (char *) malloc(size);
-            if (new_array->is_string == NULL) {
-                nomem:
-                free(new_array->data);
+            if (oldmatrix->array->is_string != NULL
+                    && !alloc_string_map(new_array)) {
                 free(new_array);
                 return ERR_INSUFFICIENT_MEMORY;
             }
             oldsize = oldmatrix->rows * oldmatrix->columns;
             s = oldsize < size ? oldsize : size;
             for (i = 0; i < s; i++) {
-                new_array->is_string[i] = oldmatrix->array->is_string[i];
-                if (oldmatrix->array->is_string[i] == 2) {
+                char c = oldmatrix->array->str(i);
+                if (c != 0) {
+                    new_array->is_string[i] = c;
+                    new_array->nstrings++;
+                }
+                if (c == 2) {
                     int4 *sp = *(int4 **) &oldmatrix->array->data[i];
                     int4 *dp = (int4 *) malloc(*sp + 4);
                     if (dp == NULL) {
-                        free_long_strings(new_array->is_string, new_array->data, i);
-                        free(new_array->is_string);
-                        goto nomem;
+                        new_array->size = i;
+                        free_realmatrix_data(new_array);
+                        return ERR_INSUFFICIENT_MEMORY;
                     }
                     memcpy(dp, sp, *sp + 4);
                     *(int4 **) &new_array->data[i] = dp;
@@ -1525,11 +1743,8 @@ int dimension_array_ref(vartype *matrix, int4 rows, int4 columns) {
                     new_array->data[i] = oldmatrix->array->data[i];
                 }
             }
-            for (i = s; i < size; i++) {
-                new_array->is_string[i] = 0;
+            for (i = s; i < size; i++)
                 new_array->data[i] = 0;
-            }
-            new_array->refcount = 1;
             oldmatrix->array->refcount--;
             oldmatrix->array = new_array;
             oldmatrix->rows = rows;
@@ -1587,6 +1802,40 @@ int dimension_array_ref(vartype *matrix, int4 rows, int4 columns) {
             oldmatrix->columns = columns;
             return ERR_NONE;
         }
+    } else if (matrix->type == TYPE_SPARSEMATRIX) {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) matrix;
+        if (sm->rows == rows && sm->columns == columns)
+            return ERR_NONE;
+        if (!disentangle(matrix))
+            return ERR_INSUFFICIENT_MEMORY;
+        sparsematrix_data *sd = sm->array;
+        int4 i, p, q;
+        if (rows != sm->rows) {
+            int4 *new_rowptr = (int4 *) realloc(sd->rowptr, (rows + 1) * sizeof(int4));
+            if (new_rowptr == NULL)
+                return ERR_INSUFFICIENT_MEMORY;
+            sd->rowptr = new_rowptr;
+            for (i = sm->rows + 1; i <= rows; i++)
+                sd->rowptr[i] = sd->rowptr[sm->rows];
+            sm->rows = rows;
+        }
+        if (columns < sm->columns) {
+            /* Squeeze out the elements in the columns that are going away */
+            q = 0;
+            p = 0;
+            for (i = 0; i < rows; i++) {
+                int4 end = sd->rowptr[i + 1];
+                for (; p < end; p++)
+                    if (sd->colidx[p] < columns) {
+                        sd->colidx[q] = sd->colidx[p];
+                        sd->values[q] = sd->values[p];
+                        q++;
+                    }
+                sd->rowptr[i + 1] = q;
+            }
+        }
+        sm->columns = columns;
+        return ERR_NONE;
     } else /* matrix->type == TYPE_LIST */ {
         if (columns != 1)
             return ERR_DIMENSION_ERROR;
@@ -1594,6 +1843,7 @@ int dimension_array_ref(vartype *matrix, int4 rows, int4 columns) {
         if (oldlist->size == size)
             return ERR_NONE;
         if (oldlist->array->refcount == 1) {
+            oldlist->array->hash = 0;
             /* Since there are no shared references to this array,
              * I can modify it in place using a realloc().
              */
@@ -1602,18 +1852,26 @@ int dimension_array_ref(vartype *matrix, int4 rows, int4 columns) {
                     free_vartype(oldlist->array->data[i]);
                     oldlist->array->data[i] = NULL;
                 }
+                oldlist->size = size;
+                /* Hang on to the spare capacity unless the list has shrunk
+                 * a lot, so that deleting and then inserting again, as DELR
+                 * and INSR do, doesn't reallocate every time.
+                 */
+                if (size >= oldlist->array->capacity / 4)
+                    return ERR_NONE;
                 vartype **new_data = (vartype **) realloc(oldlist->array->data, size * sizeof(vartype *));
                 /* Note: If the realloc() fails to shrink the array, we just keep
                  * using the existing one, basically pretending that it succeeded.
                  */
-                if (new_data != NULL)
+                if (new_data != NULL) {
                     oldlist->array->data = new_data;
-                oldlist->size = size;
+                    oldlist->array->capacity = size;
+                }
                 return ERR_NONE;
             } else {
-                vartype **new_data = (vartype **) realloc(oldlist->array->data, size * sizeof(vartype *));
-                if (new_data == NULL)
+                if (!reserve_list(oldlist, size))
                     return ERR_INSUFFICIENT_MEMORY;
+                vartype **new_data = oldlist->array->data;
                 for (int4 i = oldlist->size; i < size; i++) {
                     new_data[i] = new_real(0);
                     if (new_data[i] == NULL) {
@@ -1622,12 +1880,9 @@ int dimension_array_ref(vartype *matrix, int4 rows, int4 columns) {
                             free_vartype(new_data[j]);
                             new_data[j] = NULL;
                         }
-                        vartype **reverted_data = (vartype **) realloc(new_data, oldlist->size * sizeof(vartype *));
-                        oldlist->array->data = reverted_data == NULL ? new_data : reverted_data;
                         return ERR_INSUFFICIENT_MEMORY;
                     }
                 }
-                oldlist->array->data = new_data;
                 oldlist->size = size;
                 return ERR_NONE;
             }
@@ -1657,6 +1912,8 @@ int dimension_array_ref(vartype *matrix, int4 rows, int4 columns) {
                 }
             }
             new_array->refcount = 1;
+            new_array->capacity = size;
+            new_array->hash = 0;
             oldlist->array->refcount--;
             oldlist->array = new_array;
             oldlist->size = size;
@@ -1866,6 +2123,20 @@ int vartype2string(const vartype *v, char *buf, int buflen, int max_mant_digits)
             return chars_so_far;
         }
 
+        case TYPE_SPARSEMATRIX: {
+            vartype_sparsematrix *m = (vartype_sparsematrix *) v;
+            int i;
+            int chars_so_far = 0;
+            string2buf(buf, buflen, &chars_so_far, "[ ", 2);
+            i = int2string(m->rows, buf + chars_so_far, buflen - chars_so_far);
+            chars_so_far += i;
+            char2buf(buf, buflen, &chars_so_far, 'x');
+            i = int2string(m->columns, buf + chars_so_far, buflen - chars_so_far);
+            chars_so_far += i;
+            string2buf(buf, buflen, &chars_so_far, " Sparse ]", 9);
+            return chars_so_far;
+        }
+
         case TYPE_STRING: {
             vartype_string *s = (vartype_string *) v;
             int i;
@@ -1889,6 +2160,17 @@ int vartype2string(const vartype *v, char *buf, int buflen, int max_mant_digits)
             return chars_so_far;
         }
 
+        case TYPE_MAP: {
+            vartype_map *map = (vartype_map *) v;
+            int i;
+            int chars_so_far = 0;
+            string2buf(buf, buflen, &chars_so_far, "{ ", 2);
+            i = int2string(map->array->size, buf + chars_so_far, buflen - chars_so_far);
+            chars_so_far += i;
+            string2buf(buf, buflen, &chars_so_far, "-Elem Map }", 11);
+            return chars_so_far;
+        }
+
         default: {
             const char *msg = "UnsuppVarType";
             int msglen = 13;
@@ -2074,7 +2356,8 @@ int matedit_get(vartype **res) {
         m = list->array->data[matedit_stack[i]];
     }
 
-    if (m->type != TYPE_REALMATRIX && m->type != TYPE_COMPLEXMATRIX && m->type != TYPE_LIST) {
+    if (m->type != TYPE_REALMATRIX && m->type != TYPE_COMPLEXMATRIX
+            && m->type != TYPE_SPARSEMATRIX && m->type != TYPE_LIST) {
         err = matedit_stack_depth == 0 ? ERR_INVALID_TYPE : ERR_INVALID_DATA;
         goto bad_matrix;
     }
@@ -2089,6 +2372,10 @@ int matedit_get(vartype **res) {
         vartype_complexmatrix *cm = (vartype_complexmatrix *) m;
         if (matedit_i >= cm->rows || matedit_j >= cm->columns)
             matedit_i = matedit_j = 0;
+    } else if (m->type == TYPE_SPARSEMATRIX) {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) m;
+        if (matedit_i >= sm->rows || matedit_j >= sm->columns)
+            matedit_i = matedit_j = 0;
     } else { // m->type == TYPE_LIST
         vartype_list *list = (vartype_list *) m;
         if (matedit_i >= list->size)
@@ -40,6 +40,7 @@ int unary_no_result();
 int binary_result(vartype *x);
 void binary_two_results(vartype *x, vartype *y);
 int ternary_result(vartype *x);
+int quaternary_two_results(vartype *x, vartype *y);
 bool ensure_stack_capacity(int n);
 void shrink_stack();
 phloat rad_to_angle(phloat x);
@@ -52,6 +53,12 @@ void string_copy(char *dst, int *dstlen, const char *src, int srclen);
 bool string_equals(const char *s1, int s1len, const char *s2, int s2len);
 int string_pos(const char *ntext, int nlen, const vartype *hs, int startpos);
 bool vartype_equals(const vartype *v1, const vartype *v2);
+int text_compare(const char *s1, int4 s1len, const char *s2, int4 s2len);
+int matrix_element_compare(const vartype_realmatrix *m1, int4 i1,
+                           const vartype_realmatrix *m2, int4 i2);
+int matrix_element_compare_to(const vartype_realmatrix *m, int4 i,
+                              const vartype *v);
+int vartype_compare(const vartype *v1, const vartype *v2);
 int anum(const char *text, int len, phloat *res);
 void fix_thousands_separators(char *buf, int *bufptr);
 void fix_base_separators(char *buf, int *bufptr);
@@ -16,6 +16,7 @@
  *****************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "core_globals.h"
 #include "core_linalg1.h"
@@ -52,9 +53,29 @@ static int div_cc_completion2(int error, vartype_complexmatrix *a, int4 *perm,
                                     vartype_complexmatrix *b);
 static int small_div(const vartype *left, const vartype *right,
                                     int (*completion)(int, vartype *));
+static int sparse_div(const vartype *left, const vartype_sparsematrix *right,
+                                    int (*completion)(int, vartype *));
+
+static vartype *sparse_num;
+static int (*sparse_num_completion)(int, vartype *);
+
+static int sparse_num_completion_1(int error, vartype *res) {
+    free_vartype(sparse_num);
+    return sparse_num_completion(error, res);
+}
 
 int linalg_div(const vartype *left, const vartype *right,
                                     int (*completion)(int, vartype *)) {
+    if (right->type == TYPE_SPARSEMATRIX)
+        return sparse_div(left, (vartype_sparsematrix *) right, completion);
+    if (left->type == TYPE_SPARSEMATRIX) {
+        /* Sparse numerator, dense denominator: solve using a dense copy */
+        sparse_num = sparse_to_dense((vartype_sparsematrix *) left);
+        if (sparse_num == NULL)
+            return completion(ERR_INSUFFICIENT_MEMORY, NULL);
+        sparse_num_completion = completion;
+        return linalg_div(sparse_num, right, sparse_num_completion_1);
+    }
     if (left->type == TYPE_REALMATRIX) {
         if (right->type == TYPE_REALMATRIX) {
             vartype_realmatrix *num = (vartype_realmatrix *) left;
@@ -288,6 +309,7 @@ static int matrix_mul_rr(vartype_realmatrix *left, vartype_realmatrix *right, in
 static int matrix_mul_cr(vartype_complexmatrix *left, vartype_realmatrix *right, int (*completion)(int, vartype *));
 static int matrix_mul_rc(vartype_realmatrix *left, vartype_complexmatrix *right, int (*completion)(int, vartype *));
 static int matrix_mul_cc(vartype_complexmatrix *left, vartype_complexmatrix *right, int (*completion)(int, vartype *));
+static int sparse_mul(const vartype *left, const vartype *right, int (*completion)(int, vartype *));
 
 static vartype *small_div_res;
 static int (*small_div_completion)(int, vartype *);
@@ -979,6 +1001,8 @@ static int matrix_mul_cc_worker(bool interrupted) {
 
 int linalg_mul(const vartype *left, const vartype *right,
                                     int (*completion)(int, vartype *)) {
+    if (left->type == TYPE_SPARSEMATRIX || right->type == TYPE_SPARSEMATRIX)
+        return sparse_mul(left, right, completion);
     if (left->type == TYPE_REALMATRIX) {
         if (right->type == TYPE_REALMATRIX)
             return matrix_mul_rr((vartype_realmatrix *) left,
@@ -1497,3 +1521,1906 @@ static int small_det_c(vartype_complexmatrix *m, phloat *dre, phloat *dim) {
             return ERR_OUT_OF_RANGE;
     return ERR_NONE;
 }
+
+
+/***************************************************/
+/***** Sparse matrix multiplication & division *****/
+/***************************************************/
+
+static int fix_range(phloat *x) {
+    int inf = p_isinf(*x);
+    if (inf != 0) {
+        if (core_settings.matrix_outofrange && !flags.f.range_error_ignore)
+            return ERR_OUT_OF_RANGE;
+        *x = inf < 0 ? NEG_HUGE_PHLOAT : POS_HUGE_PHLOAT;
+    }
+    return ERR_NONE;
+}
+
+static int int4_compare(const void *a, const void *b) {
+    int4 x = *(const int4 *) a;
+    int4 y = *(const int4 *) b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* Products involving sparse matrices are computed one row at a time, using
+ * a dense accumulator for the current row: row i of the result is the sum of
+ * a(i,k) times row k of the right-hand matrix, over all nonzero a(i,k). The
+ * result is sparse if both operands are; otherwise, it is dense.
+ */
+struct sparse_mul_data_struct {
+    const vartype *left;
+    const vartype *right;
+    vartype *result;
+    phloat *acc;
+    char *used;
+    int4 *cols;
+    int4 i;
+    int (*completion)(int error, vartype *result);
+};
+
+static sparse_mul_data_struct *sparse_mul_data;
+
+static int sparse_mul_worker(bool interrupted);
+
+static int sparse_mul(const vartype *left, const vartype *right,
+                      int (*completion)(int, vartype *)) {
+    int4 lrows, lcols, rrows, rcols;
+    const vartype *m[2] = { left, right };
+    for (int i = 0; i < 2; i++) {
+        if (m[i]->type == TYPE_SPARSEMATRIX) {
+            vartype_sparsematrix *sm = (vartype_sparsematrix *) m[i];
+            rrows = sm->rows;
+            rcols = sm->columns;
+        } else if (m[i]->type == TYPE_REALMATRIX) {
+            vartype_realmatrix *rm = (vartype_realmatrix *) m[i];
+            if (contains_strings(rm))
+                return completion(ERR_ALPHA_DATA_IS_INVALID, NULL);
+            rrows = rm->rows;
+            rcols = rm->columns;
+        } else
+            return completion(ERR_INVALID_TYPE, NULL);
+        if (i == 0) {
+            lrows = rrows;
+            lcols = rcols;
+        }
+    }
+    if (lcols != rrows)
+        return completion(ERR_DIMENSION_ERROR, NULL);
+
+    sparse_mul_data_struct *dat = (sparse_mul_data_struct *)
+                                malloc(sizeof(sparse_mul_data_struct));
+    if (dat == NULL)
+        return completion(ERR_INSUFFICIENT_MEMORY, NULL);
+    bool sparse_result = left->type == TYPE_SPARSEMATRIX
+                            && right->type == TYPE_SPARSEMATRIX;
+    if (sparse_result) {
+        int4 cap = ((vartype_sparsematrix *) left)->nnz()
+                    + ((vartype_sparsematrix *) right)->nnz();
+        dat->result = new_sparsematrix(lrows, rcols, cap);
+        dat->acc = (phloat *) malloc(rcols * sizeof(phloat));
+        dat->used = (char *) malloc(rcols);
+        dat->cols = (int4 *) malloc(rcols * sizeof(int4));
+    } else {
+        dat->result = new_realmatrix(lrows, rcols);
+        dat->acc = NULL;
+        dat->used = NULL;
+        dat->cols = NULL;
+    }
+    if (dat->result == NULL || sparse_result
+            && (dat->acc == NULL || dat->used == NULL || dat->cols == NULL)) {
+        free_vartype(dat->result);
+        free(dat->acc);
+        free(dat->used);
+        free(dat->cols);
+        free(dat);
+        return completion(ERR_INSUFFICIENT_MEMORY, NULL);
+    }
+    if (sparse_result) {
+        for (int4 j = 0; j < rcols; j++)
+            dat->acc[j] = 0;
+        memset(dat->used, 0, rcols);
+    }
+    dat->left = left;
+    dat->right = right;
+    dat->i = 0;
+    dat->completion = completion;
+
+    sparse_mul_data = dat;
+    mode_interruptible = sparse_mul_worker;
+    mode_stoppable = false;
+    return ERR_INTERRUPTIBLE;
+}
+
+static int sparse_mul_worker(bool interrupted) {
+    sparse_mul_data_struct *dat = sparse_mul_data;
+    int err = ERR_NONE;
+    int count = 0;
+    int4 i = dat->i;
+    int4 q, n;
+
+    if (interrupted) {
+        err = ERR_INTERRUPTED;
+        goto finished;
+    }
+
+    const vartype_sparsematrix *ls, *rs;
+    const vartype_realmatrix *ld, *rd;
+    ls = dat->left->type == TYPE_SPARSEMATRIX
+            ? (const vartype_sparsematrix *) dat->left : NULL;
+    ld = ls == NULL ? (const vartype_realmatrix *) dat->left : NULL;
+    rs = dat->right->type == TYPE_SPARSEMATRIX
+            ? (const vartype_sparsematrix *) dat->right : NULL;
+    rd = rs == NULL ? (const vartype_realmatrix *) dat->right : NULL;
+    q = ls != NULL ? ls->columns : ld->columns;
+    n = rs != NULL ? rs->columns : rd->columns;
+
+    while (count < 1000) {
+        if (i == (ls != NULL ? ls->rows : ld->rows)) {
+            err = dat->completion(ERR_NONE, dat->result);
+            free(dat->acc);
+            free(dat->used);
+            free(dat->cols);
+            free(dat);
+            return err;
+        }
+
+        phloat *acc;
+        int4 ncols = 0;
+        if (dat->used == NULL)
+            acc = ((vartype_realmatrix *) dat->result)->array->data + i * n;
+        else
+            acc = dat->acc;
+
+        int4 p = 0, pend = q;
+        if (ls != NULL) {
+            p = ls->array->rowptr[i];
+            pend = ls->array->rowptr[i + 1];
+        }
+        for (; p < pend; p++) {
+            int4 k;
+            phloat a;
+            if (ls != NULL) {
+                k = ls->array->colidx[p];
+                a = ls->array->values[p];
+            } else {
+                k = p;
+                a = ld->array->data[i * q + k];
+                if (a == 0)
+                    continue;
+            }
+            if (rs != NULL) {
+                int4 end = rs->array->rowptr[k + 1];
+                for (int4 p2 = rs->array->rowptr[k]; p2 < end; p2++) {
+                    int4 j = rs->array->colidx[p2];
+                    acc[j] += a * rs->array->values[p2];
+                    if (dat->used != NULL && !dat->used[j]) {
+                        dat->used[j] = 1;
+                        dat->cols[ncols++] = j;
+                    }
+                }
+                count += end - rs->array->rowptr[k];
+            } else {
+                const phloat *r = rd->array->data + k * n;
+                for (int4 j = 0; j < n; j++)
+                    acc[j] += a * r[j];
+                count += n;
+            }
+            count++;
+        }
+
+        if (dat->used == NULL) {
+            for (int4 j = 0; j < n; j++)
+                if ((err = fix_range(&acc[j])) != ERR_NONE)
+                    goto finished;
+        } else {
+            vartype_sparsematrix *res = (vartype_sparsematrix *) dat->result;
+            int4 nnz = res->array->rowptr[i];
+            if (!sparse_reserve(res, nnz + ncols)) {
+                err = ERR_INSUFFICIENT_MEMORY;
+                goto finished;
+            }
+            qsort(dat->cols, ncols, sizeof(int4), int4_compare);
+            for (int4 c = 0; c < ncols; c++) {
+                int4 j = dat->cols[c];
+                phloat x = acc[j];
+                acc[j] = 0;
+                dat->used[j] = 0;
+                if (x == 0)
+                    continue;
+                if ((err = fix_range(&x)) != ERR_NONE)
+                    goto finished;
+                res->array->colidx[nnz] = j;
+                res->array->values[nnz] = x;
+                nnz++;
+            }
+            res->array->rowptr[i + 1] = nnz;
+            count += ncols;
+        }
+        i++;
+    }
+
+    dat->i = i;
+    return ERR_INTERRUPTIBLE;
+
+    finished:
+    err = dat->completion(err, NULL);
+    free_vartype(dat->result);
+    free(dat->acc);
+    free(dat->used);
+    free(dat->cols);
+    free(dat);
+    return err;
+}
+
+/* Sparse linear systems are solved by Gaussian elimination with partial
+ * pivoting, working directly on the sparse rows so that only the fill-in
+ * actually produced is ever stored. Rows that haven't been used as pivots
+ * yet are kept in buckets by the column of their first nonzero element;
+ * step k chooses the pivot for column k from bucket k and eliminates
+ * column k from the other rows in that bucket, which then move on to later
+ * buckets. Once all columns are done, the pivot rows form an upper
+ * triangular system, which is solved by back substitution.
+ */
+struct sparse_row {
+    int4 len;
+    int4 *cols;
+    phloat *vals;
+};
+
+struct sparse_div_data_struct {
+    int4 n, m;
+    sparse_row *rows;
+    phloat *b;
+    int4 *head, *next;
+    int4 *pivot;
+    phloat tiny;
+    int4 k, pending;
+    int state;
+    vartype_realmatrix *result;
+    int (*completion)(int error, vartype *result);
+};
+
+static sparse_div_data_struct *sparse_div_data;
+
+static void sparse_div_free(sparse_div_data_struct *dat) {
+    if (dat->rows != NULL)
+        for (int4 i = 0; i < dat->n; i++) {
+            free(dat->rows[i].cols);
+            free(dat->rows[i].vals);
+        }
+    free(dat->rows);
+    free(dat->b);
+    free(dat->head);
+    free(dat->next);
+    free(dat->pivot);
+    free_vartype((vartype *) dat->result);
+    free(dat);
+}
+
+static void sparse_div_bucket(sparse_div_data_struct *dat, int4 r) {
+    int4 c = dat->rows[r].len == 0 ? dat->n : dat->rows[r].cols[0];
+    dat->next[r] = dat->head[c];
+    dat->head[c] = r;
+}
+
+static int sparse_div_worker(bool interrupted);
+
+static int sparse_div(const vartype *left, const vartype_sparsematrix *right,
+                      int (*completion)(int, vartype *)) {
+    int4 n = right->rows;
+    int4 m, i, j;
+    sparse_div_data_struct *dat;
+    const sparsematrix_data *sd = right->array;
+    phloat scale = 0;
+    phloat tiniest = 1e20 / POS_HUGE_PHLOAT;
+    if (left->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) left;
+        if (contains_strings(rm))
+            return completion(ERR_ALPHA_DATA_IS_INVALID, NULL);
+        if (rm->rows != n)
+            return completion(ERR_DIMENSION_ERROR, NULL);
+        m = rm->columns;
+    } else if (left->type == TYPE_SPARSEMATRIX) {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) left;
+        if (sm->rows != n)
+            return completion(ERR_DIMENSION_ERROR, NULL);
+        m = sm->columns;
+    } else
+        return completion(ERR_INVALID_TYPE, NULL);
+    if (right->columns != n)
+        return completion(ERR_DIMENSION_ERROR, NULL);
+
+    dat = (sparse_div_data_struct *) malloc(sizeof(sparse_div_data_struct));
+    if (dat == NULL)
+        return completion(ERR_INSUFFICIENT_MEMORY, NULL);
+    dat->n = n;
+    dat->m = m;
+    dat->rows = (sparse_row *) malloc(n * sizeof(sparse_row));
+    if (dat->rows != NULL)
+        for (i = 0; i < n; i++) {
+            dat->rows[i].cols = NULL;
+            dat->rows[i].vals = NULL;
+        }
+    dat->b = (phloat *) malloc(n * m * sizeof(phloat));
+    dat->head = (int4 *) malloc((n + 1) * sizeof(int4));
+    dat->next = (int4 *) malloc(n * sizeof(int4));
+    dat->pivot = (int4 *) malloc(n * sizeof(int4));
+    dat->result = (vartype_realmatrix *) new_realmatrix(n, m);
+    if (dat->rows == NULL || dat->b == NULL || dat->head == NULL
+            || dat->next == NULL || dat->pivot == NULL
+            || dat->result == NULL)
+        goto nomem;
+
+    for (i = 0; i < n; i++) {
+        sparse_row *row = dat->rows + i;
+        int4 start = sd->rowptr[i];
+        row->len = sd->rowptr[i + 1] - start;
+        row->cols = (int4 *) malloc((row->len + 1) * sizeof(int4));
+        row->vals = (phloat *) malloc((row->len + 1) * sizeof(phloat));
+        if (row->cols == NULL || row->vals == NULL)
+            goto nomem;
+        for (j = 0; j < row->len; j++) {
+            row->cols[j] = sd->colidx[start + j];
+            row->vals[j] = sd->values[start + j];
+            phloat a = row->vals[j] < 0 ? -row->vals[j] : row->vals[j];
+            if (a > scale)
+                scale = a;
+        }
+    }
+    if (left->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) left;
+        for (i = 0; i < n * m; i++)
+            dat->b[i] = rm->array->data[i];
+    } else {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) left;
+        for (i = 0; i < n * m; i++)
+            dat->b[i] = 0;
+        for (i = 0; i < n; i++)
+            for (j = sm->array->rowptr[i]; j < sm->array->rowptr[i + 1]; j++)
+                dat->b[i * m + sm->array->colidx[j]] = sm->array->values[j];
+    }
+
+    /* For a zero pivot, we substitute a small number, like lu_decomp_r()
+     * does; in this case, based on the largest element of the matrix.
+     */
+    if (scale == 0)
+        dat->tiny = tiniest;
+    else {
+        dat->tiny = pow(10, floor(log10(scale)) - 20);
+        if (dat->tiny < tiniest)
+            dat->tiny = tiniest;
+    }
+
+    for (i = 0; i <= n; i++)
+        dat->head[i] = -1;
+    for (i = n - 1; i >= 0; i--)
+        sparse_div_bucket(dat, i);
+    dat->k = 0;
+    dat->pending = -1;
+    dat->state = 0;
+    dat->completion = completion;
+
+    sparse_div_data = dat;
+    mode_interruptible = sparse_div_worker;
+    mode_stoppable = false;
+    return ERR_INTERRUPTIBLE;
+
+    nomem:
+    sparse_div_free(dat);
+    return completion(ERR_INSUFFICIENT_MEMORY, NULL);
+}
+
+static int sparse_div_worker(bool interrupted) {
+    sparse_div_data_struct *dat = sparse_div_data;
+    int4 n = dat->n;
+    int4 m = dat->m;
+    sparse_row *rows = dat->rows;
+    phloat *b = dat->b;
+    int4 k = dat->k;
+    int count = 0;
+    int err;
+
+    if (interrupted) {
+        err = ERR_INTERRUPTED;
+        goto finished;
+    }
+
+    while (dat->state == 0 && count < 1000) {
+        if (k == n) {
+            dat->state = 1;
+            k = n - 1;
+            break;
+        }
+        if (dat->pending == -1) {
+            /* Start of step k: choose the pivot */
+            if (dat->head[k] == -1) {
+                if (core_settings.matrix_singularmatrix) {
+                    err = ERR_SINGULAR_MATRIX;
+                    goto finished;
+                }
+                /* No row has a nonzero in column k; take the first row
+                 * from a later bucket, and give it a tiny element there.
+                 */
+                int4 c = k + 1;
+                while (dat->head[c] == -1)
+                    c++;
+                int4 r = dat->head[c];
+                sparse_row *row = rows + r;
+                int4 *nc = (int4 *) realloc(row->cols, (row->len + 1) * sizeof(int4));
+                if (nc == NULL) {
+                    err = ERR_INSUFFICIENT_MEMORY;
+                    goto finished;
+                }
+                row->cols = nc;
+                phloat *nv = (phloat *) realloc((void *) row->vals, (row->len + 1) * sizeof(phloat));
+                if (nv == NULL) {
+                    err = ERR_INSUFFICIENT_MEMORY;
+                    goto finished;
+                }
+                row->vals = nv;
+                dat->head[c] = dat->next[r];
+                memmove(row->cols + 1, row->cols, row->len * sizeof(int4));
+                memmove((void *) (row->vals + 1), (const void *) row->vals, row->len * sizeof(phloat));
+                row->cols[0] = k;
+                row->vals[0] = dat->tiny;
+                row->len++;
+                dat->next[r] = -1;
+                dat->head[k] = r;
+            }
+            int4 pr = -1;
+            phloat max = -1;
+            for (int4 r = dat->head[k]; r != -1; r = dat->next[r]) {
+                phloat a = rows[r].vals[0];
+                if (a < 0)
+                    a = -a;
+                if (a > max) {
+                    max = a;
+                    pr = r;
+                }
+                count++;
+            }
+            dat->pivot[k] = pr;
+            /* The rest of the bucket is what needs to be eliminated */
+            int4 *pp = &dat->head[k];
+            while (*pp != pr)
+                pp = &dat->next[*pp];
+            *pp = dat->next[pr];
+            dat->pending = dat->head[k];
+            dat->head[k] = -1;
+        }
+
+        int4 pr = dat->pivot[k];
+        sparse_row *prow = rows + pr;
+        while (dat->pending != -1 && count < 1000) {
+            int4 r = dat->pending;
+            dat->pending = dat->next[r];
+            sparse_row *row = rows + r;
+            phloat f = row->vals[0] / prow->vals[0];
+            int4 cap = row->len + prow->len - 1;
+            int4 *nc = (int4 *) malloc((cap + 1) * sizeof(int4));
+            phloat *nv = (phloat *) malloc((cap + 1) * sizeof(phloat));
+            if (nc == NULL || nv == NULL) {
+                free(nc);
+                free(nv);
+                err = ERR_INSUFFICIENT_MEMORY;
+                goto finished;
+            }
+            int4 p = 1, q = 1, len = 0;
+            while (p < row->len || q < prow->len) {
+                int4 c1 = p < row->len ? row->cols[p] : n;
+                int4 c2 = q < prow->len ? prow->cols[q] : n;
+                phloat x;
+                int4 c;
+                if (c1 < c2) {
+                    c = c1;
+                    x = row->vals[p++];
+                } else if (c1 > c2) {
+                    c = c2;
+                    x = -f * prow->vals[q++];
+                } else {
+                    c = c1;
+                    x = row->vals[p++] - f * prow->vals[q++];
+                }
+                if (x != 0) {
+                    nc[len] = c;
+                    nv[len] = x;
+                    len++;
+                }
+            }
+            free(row->cols);
+            free(row->vals);
+            row->cols = nc;
+            row->vals = nv;
+            row->len = len;
+            for (int4 j = 0; j < m; j++)
+                b[r * m + j] -= f * b[pr * m + j];
+            sparse_div_bucket(dat, r);
+            count += cap + m;
+        }
+        if (dat->pending == -1)
+            k++;
+    }
+
+    if (dat->state == 1) {
+        phloat *x = dat->result->array->data;
+        while (count < 1000) {
+            if (k < 0) {
+                vartype *res = (vartype *) dat->result;
+                dat->result = NULL;
+                err = dat->completion(ERR_NONE, res);
+                sparse_div_free(dat);
+                return err;
+            }
+            sparse_row *row = rows + dat->pivot[k];
+            const phloat *bk = b + dat->pivot[k] * m;
+            for (int4 j = 0; j < m; j++) {
+                phloat sum = bk[j];
+                for (int4 p = 1; p < row->len; p++)
+                    sum -= row->vals[p] * x[row->cols[p] * m + j];
+                sum /= row->vals[0];
+                if ((err = fix_range(&sum)) != ERR_NONE)
+                    goto finished;
+                x[k * m + j] = sum;
+            }
+            count += row->len * m;
+            k--;
+        }
+    }
+
+    dat->k = k;
+    return ERR_INTERRUPTIBLE;
+
+    finished:
+    err = dat->completion(err, NULL);
+    sparse_div_free(dat);
+    return err;
+}
+
+
+/*************************************/
+/***** Iterative linear solvers *****/
+/*************************************/
+
+/* CG and BiCGSTAB solve A x = b starting from x = 0, and stop when the
+ * residual satisfies |b - A x| <= tol * |b|, or when the iteration limit is
+ * reached. A can be a dense real matrix or a sparse matrix; it is only used
+ * to compute matrix-vector products, so a sparse A is never filled in.
+ * CG requires A to be symmetric positive definite; BiCGSTAB works for
+ * general nonsingular A.
+ */
+
+struct iter_solve_data_struct {
+    const vartype *a;
+    int4 n;
+    bool cg;
+    int4 maxiter;
+    int4 iter;
+    phloat threshold;
+    phloat rr, rho, alpha, omega;
+    phloat *x, *r, *r0, *p, *v, *s, *t;
+    vartype *result;
+    int (*completion)(int error, vartype *x, int4 iterations);
+};
+
+static iter_solve_data_struct *iter_solve_data;
+
+static int iter_solve_worker(bool interrupted);
+
+static void iter_matvec(const vartype *a, const phloat *src, phloat *dst) {
+    if (a->type == TYPE_SPARSEMATRIX) {
+        const vartype_sparsematrix *sm = (const vartype_sparsematrix *) a;
+        const sparsematrix_data *sd = sm->array;
+        for (int4 i = 0; i < sm->rows; i++) {
+            phloat sum = 0;
+            for (int4 k = sd->rowptr[i]; k < sd->rowptr[i + 1]; k++)
+                sum += sd->values[k] * src[sd->colidx[k]];
+            dst[i] = sum;
+        }
+    } else {
+        const vartype_realmatrix *rm = (const vartype_realmatrix *) a;
+        int4 n = rm->columns;
+        const phloat *row = rm->array->data;
+        for (int4 i = 0; i < rm->rows; i++) {
+            phloat sum = 0;
+            for (int4 j = 0; j < n; j++)
+                sum += row[j] * src[j];
+            dst[i] = sum;
+            row += n;
+        }
+    }
+}
+
+static phloat iter_dot(const phloat *a, const phloat *b, int4 n) {
+    phloat sum = 0;
+    for (int4 i = 0; i < n; i++)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+int linalg_iter_solve(const vartype *a, const vartype *b, phloat tol,
+                      int4 maxiter, bool cg,
+                      int (*completion)(int, vartype *, int4)) {
+    int4 n;
+    if (a->type == TYPE_SPARSEMATRIX) {
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) a;
+        n = sm->rows;
+        if (sm->columns != n)
+            return ERR_DIMENSION_ERROR;
+    } else if (a->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) a;
+        n = rm->rows;
+        if (rm->columns != n)
+            return ERR_DIMENSION_ERROR;
+        if (contains_strings(rm))
+            return ERR_ALPHA_DATA_IS_INVALID;
+    } else
+        return ERR_INVALID_TYPE;
+    if (b->type != TYPE_REALMATRIX)
+        return ERR_INVALID_TYPE;
+    vartype_realmatrix *bm = (vartype_realmatrix *) b;
+    if (bm->rows != n || bm->columns != 1)
+        return ERR_DIMENSION_ERROR;
+    if (contains_strings(bm))
+        return ERR_ALPHA_DATA_IS_INVALID;
+    if (tol < 0 || maxiter < 1)
+        return ERR_INVALID_DATA;
+
+    iter_solve_data_struct *dat = (iter_solve_data_struct *)
+                                malloc(sizeof(iter_solve_data_struct));
+    if (dat == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    int nvec = cg ? 3 : 6;
+    dat->x = (phloat *) malloc(nvec * n * sizeof(phloat));
+    dat->result = new_realmatrix(n, 1);
+    if (dat->x == NULL || dat->result == NULL) {
+        free(dat->x);
+        free_vartype(dat->result);
+        free(dat);
+        return ERR_INSUFFICIENT_MEMORY;
+    }
+    phloat *x = ((vartype_realmatrix *) dat->result)->array->data;
+    dat->r = dat->x;
+    dat->p = dat->r + n;
+    dat->v = dat->p + n;
+    if (cg) {
+        dat->r0 = dat->s = dat->t = NULL;
+    } else {
+        dat->r0 = dat->v + n;
+        dat->s = dat->r0 + n;
+        dat->t = dat->s + n;
+    }
+    dat->x = x;
+    for (int4 i = 0; i < n; i++) {
+        x[i] = 0;
+        dat->r[i] = bm->array->data[i];
+        dat->p[i] = dat->r[i];
+        if (!cg)
+            dat->r0[i] = dat->r[i];
+    }
+    dat->rr = iter_dot(dat->r, dat->r, n);
+    dat->threshold = tol * tol * dat->rr;
+    dat->rho = dat->alpha = dat->omega = 1;
+    dat->a = a;
+    dat->n = n;
+    dat->cg = cg;
+    dat->maxiter = maxiter;
+    dat->iter = 0;
+    dat->completion = completion;
+
+    iter_solve_data = dat;
+    mode_interruptible = iter_solve_worker;
+    mode_stoppable = false;
+    return ERR_INTERRUPTIBLE;
+}
+
+static int iter_solve_worker(bool interrupted) {
+    iter_solve_data_struct *dat = iter_solve_data;
+    int4 n = dat->n;
+    phloat *x = dat->x, *r = dat->r, *p = dat->p, *v = dat->v;
+    int err = ERR_NONE;
+    int4 count = 0;
+    vartype *res;
+
+    if (interrupted) {
+        err = ERR_INTERRUPTED;
+        goto finished;
+    }
+
+    while (count < 10000) {
+        if (dat->rr <= dat->threshold || dat->iter == dat->maxiter)
+            goto done;
+        if (dat->cg) {
+            iter_matvec(dat->a, p, v);
+            phloat pap = iter_dot(p, v, n);
+            if (!(pap > 0)) {
+                /* Not positive definite, or NaN */
+                err = ERR_INVALID_DATA;
+                goto finished;
+            }
+            phloat alpha = dat->rr / pap;
+            for (int4 i = 0; i < n; i++) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * v[i];
+            }
+            phloat rr = iter_dot(r, r, n);
+            phloat beta = rr / dat->rr;
+            for (int4 i = 0; i < n; i++)
+                p[i] = r[i] + beta * p[i];
+            dat->rr = rr;
+        } else {
+            phloat *r0 = dat->r0, *s = dat->s, *t = dat->t;
+            phloat rho = iter_dot(r0, r, n);
+            if (rho == 0) {
+                err = ERR_INVALID_DATA;
+                goto finished;
+            }
+            if (dat->iter > 0) {
+                phloat beta = (rho / dat->rho) * (dat->alpha / dat->omega);
+                for (int4 i = 0; i < n; i++)
+                    p[i] = r[i] + beta * (p[i] - dat->omega * v[i]);
+            }
+            iter_matvec(dat->a, p, v);
+            phloat r0v = iter_dot(r0, v, n);
+            if (r0v == 0) {
+                err = ERR_INVALID_DATA;
+                goto finished;
+            }
+            phloat alpha = rho / r0v;
+            for (int4 i = 0; i < n; i++)
+                s[i] = r[i] - alpha * v[i];
+            phloat ss = iter_dot(s, s, n);
+            if (ss <= dat->threshold) {
+                for (int4 i = 0; i < n; i++)
+                    x[i] += alpha * p[i];
+                dat->iter++;
+                goto done;
+            }
+            iter_matvec(dat->a, s, t);
+            phloat tt = iter_dot(t, t, n);
+            if (tt == 0) {
+                err = ERR_SINGULAR_MATRIX;
+                goto finished;
+            }
+            phloat omega = iter_dot(t, s, n) / tt;
+            for (int4 i = 0; i < n; i++) {
+                x[i] += alpha * p[i] + omega * s[i];
+                r[i] = s[i] - omega * t[i];
+            }
+            if (omega == 0) {
+                err = ERR_INVALID_DATA;
+                goto finished;
+            }
+            dat->rr = iter_dot(r, r, n);
+            dat->rho = rho;
+            dat->alpha = alpha;
+            dat->omega = omega;
+            count += n;
+        }
+        dat->iter++;
+        count += (dat->a->type == TYPE_SPARSEMATRIX
+                    ? ((vartype_sparsematrix *) dat->a)->nnz() : n * n) + 5 * n;
+    }
+    return ERR_INTERRUPTIBLE;
+
+    done:
+    for (int4 i = 0; i < n; i++)
+        if ((err = fix_range(&x[i])) != ERR_NONE)
+            goto finished;
+    res = dat->result;
+    free(r);
+    err = dat->completion(ERR_NONE, res, dat->iter);
+    free(dat);
+    return err;
+
+    finished:
+    err = dat->completion(err, NULL, 0);
+    free(r);
+    free_vartype(dat->result);
+    free(dat);
+    return err;
+}
+
+
+/*****************************/
+/***** QR least squares *****/
+/*****************************/
+
+/* Solves the overdetermined system A x = b in the least-squares sense, by
+ * reducing A to upper triangular form with Householder reflections, which
+ * are applied to b along the way; the solution then follows by
+ * back-substitution. This avoids forming the normal equations A^T A x =
+ * A^T b, which would square the condition number of the problem.
+ * A is m x n with m >= n, and b is m x k, each column of b being a separate
+ * response. The results are the n x k matrix of coefficients, and a k x 3
+ * matrix with, for each response, the residual sum of squares, the
+ * coefficient of determination R^2 (relative to the mean of the response),
+ * and the standard error of the fit, sqrt(RSS / (m - n)), or 0 if m = n.
+ */
+
+struct lsq_data_struct {
+    int4 m, n, k;
+    int state;
+    int4 j, c;
+    phloat *w;      // A, reduced in place; the reflectors end up below R
+    phloat *b;      // b, with the reflectors applied
+    phloat *rdiag;  // The diagonal of R
+    phloat *tss;    // Total sum of squares of each response
+    vartype *result;
+    int (*completion)(int error, vartype *coeffs, vartype *stats);
+};
+
+static lsq_data_struct *lsq_data;
+
+static int lsq_worker(bool interrupted);
+
+static void lsq_free(lsq_data_struct *dat) {
+    free(dat->w);
+    free(dat->b);
+    free(dat->rdiag);
+    free(dat->tss);
+    free_vartype(dat->result);
+    free(dat);
+}
+
+int linalg_lsq(const vartype *a, const vartype *b,
+               int (*completion)(int, vartype *, vartype *)) {
+    if (a->type != TYPE_REALMATRIX || b->type != TYPE_REALMATRIX)
+        return ERR_INVALID_TYPE;
+    vartype_realmatrix *am = (vartype_realmatrix *) a;
+    vartype_realmatrix *bm = (vartype_realmatrix *) b;
+    int4 m = am->rows;
+    int4 n = am->columns;
+    int4 k = bm->columns;
+    if (m < n || bm->rows != m)
+        return ERR_DIMENSION_ERROR;
+    if (contains_strings(am) || contains_strings(bm))
+        return ERR_ALPHA_DATA_IS_INVALID;
+
+    lsq_data_struct *dat = (lsq_data_struct *) malloc(sizeof(lsq_data_struct));
+    if (dat == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    dat->w = (phloat *) malloc(m * n * sizeof(phloat));
+    dat->b = (phloat *) malloc(m * k * sizeof(phloat));
+    dat->rdiag = (phloat *) malloc(n * sizeof(phloat));
+    dat->tss = (phloat *) malloc(k * sizeof(phloat));
+    dat->result = new_realmatrix(n, k);
+    if (dat->w == NULL || dat->b == NULL || dat->rdiag == NULL
+            || dat->tss == NULL || dat->result == NULL) {
+        lsq_free(dat);
+        return ERR_INSUFFICIENT_MEMORY;
+    }
+    for (int4 i = 0; i < m * n; i++)
+        dat->w[i] = am->array->data[i];
+    for (int4 i = 0; i < m * k; i++)
+        dat->b[i] = bm->array->data[i];
+    for (int4 c = 0; c < k; c++) {
+        phloat mean = 0, tss = 0;
+        for (int4 i = 0; i < m; i++)
+            mean += dat->b[i * k + c];
+        mean /= m;
+        for (int4 i = 0; i < m; i++) {
+            phloat d = dat->b[i * k + c] - mean;
+            tss += d * d;
+        }
+        dat->tss[c] = tss;
+    }
+    dat->m = m;
+    dat->n = n;
+    dat->k = k;
+    dat->state = 0;
+    dat->j = 0;
+    dat->c = 0;
+    dat->completion = completion;
+
+    lsq_data = dat;
+    mode_interruptible = lsq_worker;
+    mode_stoppable = false;
+    return ERR_INTERRUPTIBLE;
+}
+
+static int lsq_worker(bool interrupted) {
+    lsq_data_struct *dat = lsq_data;
+    int4 m = dat->m, n = dat->n, k = dat->k;
+    phloat *w = dat->w, *b = dat->b;
+    int4 j = dat->j, c = dat->c;
+    int4 count = 0;
+    int err;
+    vartype *stats;
+
+    if (interrupted) {
+        err = ERR_INTERRUPTED;
+        goto finished;
+    }
+
+    if (dat->state == 0) {
+        /* Householder reduction. For column j, c == j means the reflector
+         * still has to be constructed; after that, c runs over the
+         * remaining columns of A, followed by the columns of b.
+         */
+        while (count < 10000) {
+            if (j == n) {
+                dat->state = 1;
+                j = n - 1;
+                break;
+            }
+            if (c == j) {
+                /* Scale the column before taking its norm, so squaring
+                 * the elements can't overflow or underflow. */
+                phloat amax = 0;
+                for (int4 i = j; i < m; i++) {
+                    phloat t = w[i * n + j];
+                    if (t < 0)
+                        t = -t;
+                    if (t > amax)
+                        amax = t;
+                }
+                if (amax == 0) {
+                    err = ERR_SINGULAR_MATRIX;
+                    goto finished;
+                }
+                phloat ss = 0;
+                for (int4 i = j; i < m; i++) {
+                    phloat t = w[i * n + j] / amax;
+                    ss += t * t;
+                }
+                phloat norm = sqrt(ss) * amax;
+                phloat x0 = w[j * n + j];
+                phloat alpha = x0 < 0 ? norm : -norm;
+                /* The reflector is v = x - alpha e1; it is stored in place
+                 * of x, and R(j, j) = alpha. */
+                w[j * n + j] = x0 - alpha;
+                dat->rdiag[j] = alpha;
+                count += m - j;
+                c++;
+            } else {
+                /* H y = y - 2 v (v^T y) / (v^T v), and
+                 * v^T v = -2 alpha v(0), so H y = y + v (v^T y) / (alpha v(0)) */
+                phloat *y;
+                int4 stride;
+                if (c < n) {
+                    y = w + c;
+                    stride = n;
+                } else {
+                    y = b + (c - n);
+                    stride = k;
+                }
+                phloat s = 0;
+                for (int4 i = j; i < m; i++)
+                    s += w[i * n + j] * y[i * stride];
+                s /= dat->rdiag[j] * w[j * n + j];
+                for (int4 i = j; i < m; i++)
+                    y[i * stride] += s * w[i * n + j];
+                count += 2 * (m - j);
+                if (++c == n + k) {
+                    j++;
+                    c = j;
+                }
+            }
+        }
+    }
+
+    if (dat->state == 1) {
+        /* Back-substitution, R x = Q^T b, from the bottom row up */
+        phloat *x = ((vartype_realmatrix *) dat->result)->array->data;
+        while (count < 10000) {
+            if (j < 0)
+                goto done;
+            for (c = 0; c < k; c++) {
+                phloat sum = b[j * k + c];
+                for (int4 l = j + 1; l < n; l++)
+                    sum -= w[j * n + l] * x[l * k + c];
+                sum /= dat->rdiag[j];
+                if ((err = fix_range(&sum)) != ERR_NONE)
+                    goto finished;
+                x[j * k + c] = sum;
+            }
+            count += (n - j) * k;
+            j--;
+        }
+    }
+
+    dat->j = j;
+    dat->c = c;
+    return ERR_INTERRUPTIBLE;
+
+    done:
+    /* The last m - n elements of Q^T b are the residual components */
+    stats = new_realmatrix(k, 3);
+    if (stats == NULL) {
+        err = ERR_INSUFFICIENT_MEMORY;
+        goto finished;
+    } else {
+        phloat *s = ((vartype_realmatrix *) stats)->array->data;
+        for (c = 0; c < k; c++) {
+            phloat rss = 0;
+            for (int4 i = n; i < m; i++)
+                rss += b[i * k + c] * b[i * k + c];
+            phloat tss = dat->tss[c];
+            s[c * 3] = rss;
+            s[c * 3 + 1] = tss == 0 ? (rss == 0 ? 1 : 0) : 1 - rss / tss;
+            s[c * 3 + 2] = m == n ? 0 : sqrt(rss / (m - n));
+            for (int4 i = 0; i < 3; i++)
+                if ((err = fix_range(&s[c * 3 + i])) != ERR_NONE) {
+                    free_vartype(stats);
+                    goto finished;
+                }
+        }
+        vartype *res = dat->result;
+        dat->result = NULL;
+        err = dat->completion(ERR_NONE, res, stats);
+        lsq_free(dat);
+        return err;
+    }
+
+    finished:
+    err = dat->completion(err, NULL, NULL);
+    lsq_free(dat);
+    return err;
+}
+
+
+/************************************/
+/***** Fast Fourier transform *****/
+/************************************/
+
+/* The transform of a vector x of length n is X(k) = sum x(j) e^(-2 pi i jk/n);
+ * the inverse uses e^(+2 pi i jk/n) and divides by n, and is computed as
+ * conj(FFT(conj(x))) / n.
+ * When n is a power of two, the transform is done in place with the
+ * iterative radix-2 algorithm. Otherwise, Bluestein's algorithm rewrites it
+ * as a convolution with the chirp w(j) = e^(-pi i j^2/n), which is then
+ * computed using radix-2 transforms of length m >= 2n - 1:
+ * X(k) = w(k) sum (x(j) w(j)) conj(w(k - j)).
+ * Every phase keeps its progress in the data struct, so the worker can
+ * return after a fixed amount of work no matter how long the vector is.
+ */
+
+#define FFT_SLICE 10000
+
+enum fft_phase {
+    FFT_TWIDDLE,    // tw(k) = e^(-2 pi i k/m), k < m / 2
+    FFT_CHIRP,      // w(k), k < n
+    FFT_FILL,       // a = x w, zero padded; b = conj(w), wrapped around
+    FFT_A,          // FFT(a)
+    FFT_B,          // FFT(b)
+    FFT_MUL,        // a = conj(FFT(a) FFT(b))
+    FFT_C,          // FFT(a) again, which gives m conj(a * b)
+    FFT_OUT         // Unscramble, scale, and range-check the result
+};
+
+struct fft_data_struct {
+    int4 n, m;
+    bool inverse;
+    int phase;
+    int4 i, j, len;
+    phloat *x;      // The result; starts out as the input
+    phloat *tw;
+    phloat *w;
+    phloat *a, *b;
+    vartype *result;
+    int (*completion)(int error, vartype *result);
+};
+
+static fft_data_struct *fft_data;
+
+static int fft_worker(bool interrupted);
+
+static void fft_free(fft_data_struct *dat) {
+    free(dat->tw);
+    free(dat->w);
+    free(dat->a);
+    free(dat->b);
+    free_vartype(dat->result);
+    free(dat);
+}
+
+/* One radix-2 transform of the m complex elements in p, resuming from
+ * where the previous call left off. Returns true when the transform is
+ * complete.
+ */
+static bool fft_pass(fft_data_struct *dat, phloat *p, int4 *count) {
+    int4 m = dat->m;
+    if (dat->len == 0) {
+        /* Bit-reversal permutation */
+        int4 i = dat->i, j = dat->j;
+        while (i < m) {
+            if (*count >= FFT_SLICE) {
+                dat->i = i;
+                dat->j = j;
+                return false;
+            }
+            if (i < j) {
+                phloat t = p[2 * i];
+                p[2 * i] = p[2 * j];
+                p[2 * j] = t;
+                t = p[2 * i + 1];
+                p[2 * i + 1] = p[2 * j + 1];
+                p[2 * j + 1] = t;
+            }
+            int4 bit = m >> 1;
+            while ((j & bit) != 0) {
+                j ^= bit;
+                bit >>= 1;
+            }
+            j |= bit;
+            i++;
+            (*count)++;
+        }
+        dat->i = 0;
+        dat->len = 2;
+    }
+    /* Butterflies; each stage consists of m / 2 of them, numbered by t */
+    const phloat *tw = dat->tw;
+    while (dat->len <= m) {
+        int4 half = dat->len / 2;
+        int4 step = m / dat->len;
+        int4 t = dat->i;
+        while (t < m / 2) {
+            if (*count >= FFT_SLICE) {
+                dat->i = t;
+                return false;
+            }
+            int4 k = t % half;
+            phloat *u = p + 2 * (2 * (t - k) + k);
+            phloat *v = u + 2 * half;
+            phloat wr = tw[2 * k * step];
+            phloat wi = tw[2 * k * step + 1];
+            phloat vr = v[0] * wr - v[1] * wi;
+            phloat vi = v[0] * wi + v[1] * wr;
+            v[0] = u[0] - vr;
+            v[1] = u[1] - vi;
+            u[0] += vr;
+            u[1] += vi;
+            t++;
+            (*count)++;
+        }
+        dat->i = 0;
+        dat->len *= 2;
+    }
+    dat->len = 0;
+    dat->j = 0;
+    return true;
+}
+
+int linalg_fft(const vartype *src, bool inverse,
+               int (*completion)(int, vartype *)) {
+    int4 rows, columns;
+    if (src->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) src;
+        if (contains_strings(rm))
+            return ERR_ALPHA_DATA_IS_INVALID;
+        rows = rm->rows;
+        columns = rm->columns;
+    } else if (src->type == TYPE_COMPLEXMATRIX) {
+        vartype_complexmatrix *cm = (vartype_complexmatrix *) src;
+        rows = cm->rows;
+        columns = cm->columns;
+    } else
+        return ERR_INVALID_TYPE;
+    if (rows != 1 && columns != 1)
+        return ERR_DIMENSION_ERROR;
+    int4 n = rows * columns;
+    int4 m = 1;
+    while (m < n)
+        m <<= 1;
+    bool bluestein = m != n;
+    if (bluestein) {
+        while (m < 2 * n - 1)
+            m <<= 1;
+        /* Each of a and b takes 2m phloats */
+        double d_bytes = ((double) m) * sizeof(phloat) * 2;
+        if (((double) (int4) d_bytes) != d_bytes)
+            return ERR_INSUFFICIENT_MEMORY;
+    }
+
+    fft_data_struct *dat = (fft_data_struct *) malloc(sizeof(fft_data_struct));
+    if (dat == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    dat->tw = (phloat *) malloc((m / 2 + 1) * 2 * sizeof(phloat));
+    if (bluestein) {
+        dat->w = (phloat *) malloc(n * 2 * sizeof(phloat));
+        dat->a = (phloat *) malloc(m * 2 * sizeof(phloat));
+        dat->b = (phloat *) malloc(m * 2 * sizeof(phloat));
+    } else
+        dat->w = dat->a = dat->b = NULL;
+    dat->result = new_complexmatrix(rows, columns);
+    if (dat->tw == NULL || dat->result == NULL
+            || bluestein && (dat->w == NULL || dat->a == NULL || dat->b == NULL)) {
+        fft_free(dat);
+        return ERR_INSUFFICIENT_MEMORY;
+    }
+    phloat *x = ((vartype_complexmatrix *) dat->result)->array->data;
+    if (src->type == TYPE_REALMATRIX) {
+        phloat *d = ((vartype_realmatrix *) src)->array->data;
+        for (int4 k = 0; k < n; k++)
+            x[2 * k] = d[k];
+    } else {
+        phloat *d = ((vartype_complexmatrix *) src)->array->data;
+        for (int4 k = 0; k < 2 * n; k++)
+            x[k] = d[k];
+    }
+    if (inverse)
+        for (int4 k = 0; k < n; k++)
+            x[2 * k + 1] = -x[2 * k + 1];
+
+    dat->n = n;
+    dat->m = m;
+    dat->inverse = inverse;
+    dat->phase = FFT_TWIDDLE;
+    dat->i = dat->j = dat->len = 0;
+    dat->x = x;
+    dat->completion = completion;
+
+    fft_data = dat;
+    mode_interruptible = fft_worker;
+    mode_stoppable = false;
+    return ERR_INTERRUPTIBLE;
+}
+
+static int fft_worker(bool interrupted) {
+    fft_data_struct *dat = fft_data;
+    int4 n = dat->n, m = dat->m;
+    phloat *x = dat->x, *w = dat->w, *a = dat->a, *b = dat->b;
+    bool bluestein = a != NULL;
+    int4 count = 0;
+    int4 i = dat->i;
+    int err;
+    vartype *res;
+
+    if (interrupted) {
+        err = ERR_INTERRUPTED;
+        goto finished;
+    }
+
+    if (dat->phase == FFT_TWIDDLE) {
+        /* Past a quarter turn, e^(-i theta) is computed as
+         * -i e^(-i (theta - pi/2)), so that the quarter turn itself
+         * comes out exact. */
+        for (; i < m / 2; i++) {
+            if (count >= FFT_SLICE)
+                goto suspend;
+            phloat s, c;
+            if (m % 4 == 0 && i >= m / 4) {
+                p_sincos(2 * PI * (i - m / 4) / m, &s, &c);
+                dat->tw[2 * i] = -s;
+                dat->tw[2 * i + 1] = -c;
+            } else {
+                p_sincos(2 * PI * i / m, &s, &c);
+                dat->tw[2 * i] = c;
+                dat->tw[2 * i + 1] = -s;
+            }
+            count += 4;
+        }
+        i = 0;
+        dat->phase = bluestein ? FFT_CHIRP : FFT_A;
+    }
+
+    if (dat->phase == FFT_CHIRP) {
+        /* j^2 is only needed modulo 2n, since w has period 2n in j^2 */
+        for (; i < n; i++) {
+            if (count >= FFT_SLICE)
+                goto suspend;
+            phloat s, c;
+            int4 r = (int4) (((int8) i * i) % (2 * n));
+            p_sincos(PI * r / n, &s, &c);
+            w[2 * i] = c;
+            w[2 * i + 1] = -s;
+            count += 4;
+        }
+        i = 0;
+        dat->phase = FFT_FILL;
+    }
+
+    if (dat->phase == FFT_FILL) {
+        for (; i < m; i++) {
+            if (count >= FFT_SLICE)
+                goto suspend;
+            if (i < n) {
+                a[2 * i] = x[2 * i] * w[2 * i] - x[2 * i + 1] * w[2 * i + 1];
+                a[2 * i + 1] = x[2 * i] * w[2 * i + 1] + x[2 * i + 1] * w[2 * i];
+            } else
+                a[2 * i] = a[2 * i + 1] = 0;
+            int4 k = i < n ? i : i > m - n ? m - i : -1;
+            if (k == -1)
+                b[2 * i] = b[2 * i + 1] = 0;
+            else {
+                b[2 * i] = w[2 * k];
+                b[2 * i + 1] = -w[2 * k + 1];
+            }
+            count++;
+        }
+        i = 0;
+        dat->phase = FFT_A;
+    }
+
+    if (dat->phase == FFT_A) {
+        dat->i = i;
+        if (!fft_pass(dat, bluestein ? a : x, &count))
+            return ERR_INTERRUPTIBLE;
+        i = 0;
+        dat->phase = bluestein ? FFT_B : FFT_OUT;
+    }
+
+    if (dat->phase == FFT_B) {
+        dat->i = i;
+        if (!fft_pass(dat, b, &count))
+            return ERR_INTERRUPTIBLE;
+        i = 0;
+        dat->phase = FFT_MUL;
+    }
+
+    if (dat->phase == FFT_MUL) {
+        for (; i < m; i++) {
+            if (count >= FFT_SLICE)
+                goto suspend;
+            phloat re = a[2 * i] * b[2 * i] - a[2 * i + 1] * b[2 * i + 1];
+            phloat im = a[2 * i] * b[2 * i + 1] + a[2 * i + 1] * b[2 * i];
+            a[2 * i] = re;
+            a[2 * i + 1] = -im;
+            count++;
+        }
+        i = 0;
+        dat->phase = FFT_C;
+    }
+
+    if (dat->phase == FFT_C) {
+        dat->i = i;
+        if (!fft_pass(dat, a, &count))
+            return ERR_INTERRUPTIBLE;
+        i = 0;
+        dat->phase = FFT_OUT;
+    }
+
+    /* FFT_OUT */
+    for (; i < n; i++) {
+        if (count >= FFT_SLICE)
+            goto suspend;
+        phloat re, im;
+        if (bluestein) {
+            /* The convolution is conj(a) / m */
+            phloat cr = a[2 * i] / m;
+            phloat ci = -a[2 * i + 1] / m;
+            re = cr * w[2 * i] - ci * w[2 * i + 1];
+            im = cr * w[2 * i + 1] + ci * w[2 * i];
+        } else {
+            re = x[2 * i];
+            im = x[2 * i + 1];
+        }
+        if (dat->inverse) {
+            re /= n;
+            im = -im / n;
+        }
+        if ((err = fix_range(&re)) != ERR_NONE
+                || (err = fix_range(&im)) != ERR_NONE)
+            goto finished;
+        x[2 * i] = re;
+        x[2 * i + 1] = im;
+        count++;
+    }
+    res = dat->result;
+    dat->result = NULL;
+    err = dat->completion(ERR_NONE, res);
+    fft_free(dat);
+    return err;
+
+    suspend:
+    dat->i = i;
+    return ERR_INTERRUPTIBLE;
+
+    finished:
+    err = dat->completion(err, NULL);
+    fft_free(dat);
+    return err;
+}
+
+
+/************************************/
+/***** Eigenvalues and vectors *****/
+/************************************/
+
+/* Real matrices are handled as complex ones, so the same code finds complex
+ * eigenvalues of real matrices as well as those of complex matrices.
+ * The matrix is first reduced to upper Hessenberg form H = Q^H A Q with
+ * Householder reflections, and then to upper triangular (Schur) form by
+ * the shifted QR algorithm, using Givens rotations and Wilkinson shifts,
+ * deflating whenever a subdiagonal element becomes negligible. The
+ * eigenvalues are the diagonal of the Schur form. When eigenvectors are
+ * wanted, the reflections and rotations are accumulated in Q, and the
+ * eigenvectors of the triangular matrix are found by back-substitution and
+ * transformed back with Q. They are normalized to unit length, with their
+ * largest element real and positive.
+ */
+
+#define EIG_SLICE 10000
+#define EIG_MAX_ITER 30
+
+enum eig_phase {
+    EIG_HESS,       // Householder reduction of column k
+    EIG_QR,         // QR iteration on the window lo..hi
+    EIG_VEC         // Eigenvector k
+};
+
+struct eig_data_struct {
+    int4 n;
+    bool vectors;
+    int phase;
+    int sub;
+    int4 k, i;
+    int4 lo, hi;
+    int its;
+    phloat norm;
+    phloat beta;
+    phloat mu_re, mu_im;
+    phloat *h;      // The matrix being reduced; complex, row major
+    phloat *q;      // The accumulated transformations, if vectors
+    phloat *v;      // Householder vector, or eigenvector workspace
+    phloat *rc;     // Givens rotations: c, real
+    phloat *rs;     // Givens rotations: s, complex
+    vartype *values;
+    vartype *vecs;
+    int (*completion)(int error, vartype *values, vartype *vectors);
+};
+
+static eig_data_struct *eig_data;
+
+static int eig_worker(bool interrupted);
+
+static void eig_free(eig_data_struct *dat) {
+    free(dat->h);
+    free(dat->q);
+    free(dat->v);
+    free(dat->rc);
+    free(dat->rs);
+    free_vartype(dat->values);
+    free_vartype(dat->vecs);
+    free(dat);
+}
+
+static phloat eig_abs1(const phloat *z) {
+    return (z[0] < 0 ? -z[0] : z[0]) + (z[1] < 0 ? -z[1] : z[1]);
+}
+
+int linalg_eigen(const vartype *src, bool vectors,
+                 int (*completion)(int, vartype *, vartype *)) {
+    int4 n;
+    if (src->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) src;
+        if (contains_strings(rm))
+            return ERR_ALPHA_DATA_IS_INVALID;
+        n = rm->rows;
+        if (rm->columns != n)
+            return ERR_DIMENSION_ERROR;
+    } else if (src->type == TYPE_COMPLEXMATRIX) {
+        vartype_complexmatrix *cm = (vartype_complexmatrix *) src;
+        n = cm->rows;
+        if (cm->columns != n)
+            return ERR_DIMENSION_ERROR;
+    } else
+        return ERR_INVALID_TYPE;
+
+    eig_data_struct *dat = (eig_data_struct *) malloc(sizeof(eig_data_struct));
+    if (dat == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    dat->h = (phloat *) malloc(2 * n * n * sizeof(phloat));
+    dat->q = vectors ? (phloat *) malloc(2 * n * n * sizeof(phloat)) : NULL;
+    dat->v = (phloat *) malloc(2 * n * sizeof(phloat));
+    dat->rc = (phloat *) malloc(n * sizeof(phloat));
+    dat->rs = (phloat *) malloc(2 * n * sizeof(phloat));
+    dat->values = new_complexmatrix(n, 1);
+    dat->vecs = vectors ? new_complexmatrix(n, n) : NULL;
+    if (dat->h == NULL || dat->v == NULL || dat->rc == NULL
+            || dat->rs == NULL || dat->values == NULL
+            || vectors && (dat->q == NULL || dat->vecs == NULL)) {
+        eig_free(dat);
+        return ERR_INSUFFICIENT_MEMORY;
+    }
+    phloat *h = dat->h;
+    if (src->type == TYPE_REALMATRIX) {
+        phloat *d = ((vartype_realmatrix *) src)->array->data;
+        for (int4 i = 0; i < n * n; i++) {
+            h[2 * i] = d[i];
+            h[2 * i + 1] = 0;
+        }
+    } else {
+        phloat *d = ((vartype_complexmatrix *) src)->array->data;
+        for (int4 i = 0; i < 2 * n * n; i++)
+            h[i] = d[i];
+    }
+    if (vectors)
+        for (int4 i = 0; i < n; i++)
+            for (int4 j = 0; j < n; j++) {
+                dat->q[2 * (i * n + j)] = i == j ? 1 : 0;
+                dat->q[2 * (i * n + j) + 1] = 0;
+            }
+
+    dat->n = n;
+    dat->vectors = vectors;
+    dat->phase = EIG_HESS;
+    dat->sub = 0;
+    dat->k = 0;
+    dat->i = 0;
+    dat->lo = 0;
+    dat->hi = n - 1;
+    dat->its = 0;
+    dat->completion = completion;
+
+    eig_data = dat;
+    mode_interruptible = eig_worker;
+    mode_stoppable = false;
+    return ERR_INTERRUPTIBLE;
+}
+
+static int eig_worker(bool interrupted) {
+    eig_data_struct *dat = eig_data;
+    int4 n = dat->n;
+    phloat *h = dat->h, *q = dat->q, *v = dat->v;
+    int4 k = dat->k, i = dat->i;
+    int4 count = 0;
+    int err;
+
+    if (interrupted) {
+        err = ERR_INTERRUPTED;
+        goto finished;
+    }
+
+    /* Hessenberg reduction. For column k, sub 0 constructs the reflection
+     * P = I - beta v v^H that zeroes h(k+2..n-1, k); sub 1 applies it from
+     * the left to column i, and sub 2 and 3 from the right to row i of H
+     * and Q, respectively.
+     */
+    while (dat->phase == EIG_HESS) {
+        if (count >= EIG_SLICE)
+            goto suspend;
+        if (k >= n - 2) {
+            /* The 1-norm of H, as a scale for the deflation test */
+            phloat norm = 0;
+            for (int4 j = 0; j < n * n; j++)
+                norm += eig_abs1(h + 2 * j);
+            dat->norm = norm;
+            dat->phase = EIG_QR;
+            dat->sub = 0;
+            count += n * n;
+            break;
+        }
+        int4 len = n - k - 1;
+        if (dat->sub == 0) {
+            phloat amax = 0;
+            for (int4 l = 0; l < len; l++) {
+                phloat t = eig_abs1(h + 2 * ((k + 1 + l) * n + k));
+                if (t > amax)
+                    amax = t;
+            }
+            phloat ss = 0;
+            if (amax != 0)
+                for (int4 l = 0; l < len; l++) {
+                    phloat *x = h + 2 * ((k + 1 + l) * n + k);
+                    phloat re = x[0] / amax, im = x[1] / amax;
+                    ss += re * re + im * im;
+                }
+            count += len;
+            if (ss == 0) {
+                /* Nothing to eliminate */
+                k++;
+                continue;
+            }
+            phloat xnorm = sqrt(ss) * amax;
+            phloat *x0 = h + 2 * ((k + 1) * n + k);
+            phloat a0 = hypot(x0[0], x0[1]);
+            phloat er, ei;
+            if (a0 == 0) {
+                er = 1;
+                ei = 0;
+            } else {
+                er = x0[0] / a0;
+                ei = x0[1] / a0;
+            }
+            for (int4 l = 0; l < len; l++) {
+                v[2 * l] = h[2 * ((k + 1 + l) * n + k)];
+                v[2 * l + 1] = h[2 * ((k + 1 + l) * n + k) + 1];
+            }
+            /* v = x - alpha e1, with alpha = -e xnorm */
+            v[0] += er * xnorm;
+            v[1] += ei * xnorm;
+            dat->beta = 1 / (xnorm * (xnorm + a0));
+            /* Column k itself becomes alpha e1 */
+            x0[0] = -er * xnorm;
+            x0[1] = -ei * xnorm;
+            for (int4 l = 1; l < len; l++)
+                h[2 * ((k + 1 + l) * n + k)] = h[2 * ((k + 1 + l) * n + k) + 1] = 0;
+            dat->sub = 1;
+            i = k + 1;
+        } else if (dat->sub == 1) {
+            /* Column i: y -= beta v (v^H y) */
+            phloat sr = 0, si = 0;
+            for (int4 l = 0; l < len; l++) {
+                phloat *y = h + 2 * ((k + 1 + l) * n + i);
+                sr += v[2 * l] * y[0] + v[2 * l + 1] * y[1];
+                si += v[2 * l] * y[1] - v[2 * l + 1] * y[0];
+            }
+            sr *= dat->beta;
+            si *= dat->beta;
+            for (int4 l = 0; l < len; l++) {
+                phloat *y = h + 2 * ((k + 1 + l) * n + i);
+                y[0] -= sr * v[2 * l] - si * v[2 * l + 1];
+                y[1] -= sr * v[2 * l + 1] + si * v[2 * l];
+            }
+            count += 2 * len;
+            if (++i == n) {
+                dat->sub = 2;
+                i = 0;
+            }
+        } else {
+            /* Row i of H or Q: y -= beta (y v) v^H */
+            phloat *row = (dat->sub == 2 ? h : q) + 2 * (i * n + k + 1);
+            phloat sr = 0, si = 0;
+            for (int4 l = 0; l < len; l++) {
+                sr += row[2 * l] * v[2 * l] - row[2 * l + 1] * v[2 * l + 1];
+                si += row[2 * l] * v[2 * l + 1] + row[2 * l + 1] * v[2 * l];
+            }
+            sr *= dat->beta;
+            si *= dat->beta;
+            for (int4 l = 0; l < len; l++) {
+                row[2 * l] -= sr * v[2 * l] + si * v[2 * l + 1];
+                row[2 * l + 1] -= si * v[2 * l] - sr * v[2 * l + 1];
+            }
+            count += 2 * len;
+            if (++i == n) {
+                i = 0;
+                if (dat->sub == 2 && dat->vectors)
+                    dat->sub = 3;
+                else {
+                    dat->sub = 0;
+                    k++;
+                }
+            }
+        }
+    }
+
+    /* QR iteration. Sub 0 checks for deflation and picks the shift;
+     * sub 1 subtracts the shift and computes and applies the left
+     * rotation for column k; sub 2 applies the right rotation for column k,
+     * and adds the shift back once all of them are done.
+     */
+    while (dat->phase == EIG_QR) {
+        if (count >= EIG_SLICE)
+            goto suspend;
+        int4 lo = dat->lo, hi = dat->hi;
+        if (dat->sub == 0) {
+            if (hi <= 0) {
+                dat->phase = EIG_VEC;
+                k = 0;
+                break;
+            }
+            int4 l;
+            for (l = hi; l > 0; l--) {
+                phloat tst1 = eig_abs1(h + 2 * ((l - 1) * n + l - 1))
+                            + eig_abs1(h + 2 * (l * n + l));
+                if (tst1 == 0)
+                    tst1 = dat->norm;
+                if (tst1 + eig_abs1(h + 2 * (l * n + l - 1)) == tst1) {
+                    h[2 * (l * n + l - 1)] = h[2 * (l * n + l - 1) + 1] = 0;
+                    break;
+                }
+            }
+            count += hi - l + 1;
+            if (l == hi) {
+                dat->hi = hi - 1;
+                dat->its = 0;
+                continue;
+            }
+            dat->lo = lo = l;
+            if (++dat->its > EIG_MAX_ITER) {
+                err = ERR_INVALID_DATA;
+                goto finished;
+            }
+            phloat *a = h + 2 * ((hi - 1) * n + hi - 1);
+            phloat *b = a + 2;
+            phloat *c = a + 2 * n;
+            phloat *d = c + 2;
+            if (dat->its == 10 || dat->its == 20) {
+                /* Exceptional shift, to break cycles */
+                phloat s = c[0] < 0 ? -c[0] : c[0];
+                if (hi - 2 >= lo) {
+                    phloat t = a[-2];
+                    s += t < 0 ? -t : t;
+                }
+                dat->mu_re = s;
+                dat->mu_im = 0;
+            } else {
+                /* Wilkinson shift: the eigenvalue of the trailing 2x2 block
+                 * d + p +/- sqrt(p^2 + bc), p = (a - d) / 2, closest to d */
+                phloat pr = (a[0] - d[0]) / 2, pi = (a[1] - d[1]) / 2;
+                phloat rr = pr * pr - pi * pi + b[0] * c[0] - b[1] * c[1];
+                phloat ri = 2 * pr * pi + b[0] * c[1] + b[1] * c[0];
+                phloat sr, si;
+                math_sqrt(rr, ri, &sr, &si);
+                phloat p1[2] = { pr + sr, pi + si };
+                phloat p2[2] = { pr - sr, pi - si };
+                if (eig_abs1(p1) < eig_abs1(p2)) {
+                    dat->mu_re = d[0] + p1[0];
+                    dat->mu_im = d[1] + p1[1];
+                } else {
+                    dat->mu_re = d[0] + p2[0];
+                    dat->mu_im = d[1] + p2[1];
+                }
+            }
+            for (int4 j = lo; j <= hi; j++) {
+                h[2 * (j * n + j)] -= dat->mu_re;
+                h[2 * (j * n + j) + 1] -= dat->mu_im;
+            }
+            dat->sub = 1;
+            k = lo;
+        } else if (dat->sub == 1) {
+            /* Rotation G = [c s; -conj(s) c] with c real, chosen so that
+             * G (x, y)^T = (r, 0)^T */
+            phloat *x = h + 2 * (k * n + k);
+            phloat *y = x + 2 * n;
+            phloat ax = hypot(x[0], x[1]);
+            phloat r = hypot(ax, hypot(y[0], y[1]));
+            phloat c, sr, si;
+            if (r == 0) {
+                c = 1;
+                sr = si = 0;
+            } else if (ax == 0) {
+                c = 0;
+                sr = y[0] / r;
+                si = -y[1] / r;
+            } else {
+                c = ax / r;
+                phloat er = x[0] / ax, ei = x[1] / ax;
+                sr = (er * y[0] + ei * y[1]) / r;
+                si = (ei * y[0] - er * y[1]) / r;
+            }
+            dat->rc[k] = c;
+            dat->rs[2 * k] = sr;
+            dat->rs[2 * k + 1] = si;
+            int4 jend = dat->vectors ? n - 1 : hi;
+            for (int4 j = k; j <= jend; j++) {
+                phloat *p = h + 2 * (k * n + j);
+                phloat *s = p + 2 * n;
+                phloat p0 = p[0], p1 = p[1];
+                p[0] = c * p0 + sr * s[0] - si * s[1];
+                p[1] = c * p1 + sr * s[1] + si * s[0];
+                phloat s0 = s[0], s1 = s[1];
+                s[0] = c * s0 - (sr * p0 + si * p1);
+                s[1] = c * s1 - (sr * p1 - si * p0);
+            }
+            count += jend - k + 1;
+            if (++k == hi) {
+                dat->sub = 2;
+                k = lo;
+            }
+        } else {
+            /* Columns k and k + 1 times G^H = [c -s; conj(s) c] */
+            phloat c = dat->rc[k];
+            phloat sr = dat->rs[2 * k], si = dat->rs[2 * k + 1];
+            int4 iend = k + 1 < hi ? k + 1 : hi;
+            for (int pass = 0; pass < (dat->vectors ? 2 : 1); pass++) {
+                phloat *m = pass == 0 ? h : q;
+                int4 ibeg = pass == 0 && !dat->vectors ? lo : 0;
+                int4 ilast = pass == 0 ? iend : n - 1;
+                for (int4 j = ibeg; j <= ilast; j++) {
+                    phloat *x = m + 2 * (j * n + k);
+                    phloat *y = x + 2;
+                    phloat x0 = x[0], x1 = x[1];
+                    x[0] = c * x0 + sr * y[0] + si * y[1];
+                    x[1] = c * x1 + sr * y[1] - si * y[0];
+                    phloat y0 = y[0], y1 = y[1];
+                    y[0] = c * y0 - (sr * x0 - si * x1);
+                    y[1] = c * y1 - (sr * x1 + si * x0);
+                }
+                count += ilast - ibeg + 1;
+            }
+            if (++k == hi) {
+                for (int4 j = lo; j <= hi; j++) {
+                    h[2 * (j * n + j)] += dat->mu_re;
+                    h[2 * (j * n + j) + 1] += dat->mu_im;
+                }
+                dat->sub = 0;
+            }
+        }
+    }
+
+    if (dat->phase == EIG_VEC) {
+        phloat *vals = ((vartype_complexmatrix *) dat->values)->array->data;
+        if (k == 0)
+            for (int4 j = 0; j < n; j++) {
+                vals[2 * j] = h[2 * (j * n + j)];
+                vals[2 * j + 1] = h[2 * (j * n + j) + 1];
+                if ((err = fix_range(&vals[2 * j])) != ERR_NONE
+                        || (err = fix_range(&vals[2 * j + 1])) != ERR_NONE)
+                    goto finished;
+            }
+        if (!dat->vectors)
+            goto done;
+        /* Stand-in for zero divisors, when eigenvalues coincide */
+        phloat tiny = dat->norm == 0 ? 1 : dat->norm;
+        tiny *= pow(10, -MAX_MANT_DIGITS);
+        phloat *vec = ((vartype_complexmatrix *) dat->vecs)->array->data;
+        while (k < n) {
+            if (count >= EIG_SLICE)
+                goto suspend;
+            /* Solve (T - lambda I) y = 0 with y(k) = 1, y(k+1..) = 0 */
+            phloat lr = h[2 * (k * n + k)], li = h[2 * (k * n + k) + 1];
+            v[2 * k] = 1;
+            v[2 * k + 1] = 0;
+            for (int4 r = k - 1; r >= 0; r--) {
+                phloat sr = 0, si = 0;
+                for (int4 j = r + 1; j <= k; j++) {
+                    phloat *t = h + 2 * (r * n + j);
+                    sr += t[0] * v[2 * j] - t[1] * v[2 * j + 1];
+                    si += t[0] * v[2 * j + 1] + t[1] * v[2 * j];
+                }
+                phloat dr = h[2 * (r * n + r)] - lr;
+                phloat di = h[2 * (r * n + r) + 1] - li;
+                if (dr == 0 && di == 0)
+                    dr = tiny;
+                phloat dd = dr * dr + di * di;
+                v[2 * r] = -(sr * dr + si * di) / dd;
+                v[2 * r + 1] = -(si * dr - sr * di) / dd;
+            }
+            /* x = Q y; find its largest element while at it */
+            phloat big = -1, br = 1, bi = 0;
+            for (int4 r = 0; r < n; r++) {
+                phloat xr = 0, xi = 0;
+                for (int4 j = 0; j <= k; j++) {
+                    phloat *t = q + 2 * (r * n + j);
+                    xr += t[0] * v[2 * j] - t[1] * v[2 * j + 1];
+                    xi += t[0] * v[2 * j + 1] + t[1] * v[2 * j];
+                }
+                vec[2 * (r * n + k)] = xr;
+                vec[2 * (r * n + k) + 1] = xi;
+                phloat a = hypot(xr, xi);
+                if (a > big) {
+                    big = a;
+                    br = xr;
+                    bi = xi;
+                }
+            }
+            /* Scale by conj(big element) / |big element| / |x| */
+            phloat ss = 0;
+            for (int4 r = 0; r < n; r++) {
+                phloat xr = vec[2 * (r * n + k)] / big;
+                phloat xi = vec[2 * (r * n + k) + 1] / big;
+                ss += xr * xr + xi * xi;
+            }
+            phloat f = 1 / (sqrt(ss) * big * big);
+            br *= f;
+            bi *= -f;
+            for (int4 r = 0; r < n; r++) {
+                phloat *x = vec + 2 * (r * n + k);
+                phloat xr = x[0] * br - x[1] * bi;
+                phloat xi = x[0] * bi + x[1] * br;
+                if ((err = fix_range(&xr)) != ERR_NONE
+                        || (err = fix_range(&xi)) != ERR_NONE)
+                    goto finished;
+                x[0] = xr;
+                x[1] = xi;
+            }
+            count += k * k + 2 * n * k + 4 * n;
+            k++;
+        }
+    }
+
+    done:
+    {
+        vartype *values = dat->values;
+        vartype *vecs = dat->vecs;
+        dat->values = NULL;
+        dat->vecs = NULL;
+        err = dat->completion(ERR_NONE, values, vecs);
+        eig_free(dat);
+        return err;
+    }
+
+    suspend:
+    dat->k = k;
+    dat->i = i;
+    return ERR_INTERRUPTIBLE;
+
+    finished:
+    err = dat->completion(err, NULL, NULL);
+    eig_free(dat);
+    return err;
+}
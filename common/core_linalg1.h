@@ -26,5 +26,14 @@ int linalg_mul(const vartype *left, const vartype *right,
                              int (*completion)(int, vartype *));
 int linalg_inv(const vartype *src, int (*completion)(int, vartype *));
 int linalg_det(const vartype *src, int (*completion)(int, vartype *));
+int linalg_iter_solve(const vartype *a, const vartype *b, phloat tol,
+                      int4 maxiter, bool cg,
+                      int (*completion)(int, vartype *, int4));
+int linalg_lsq(const vartype *a, const vartype *b,
+               int (*completion)(int, vartype *, vartype *));
+int linalg_fft(const vartype *src, bool inverse,
+               int (*completion)(int, vartype *));
+int linalg_eigen(const vartype *src, bool vectors,
+                 int (*completion)(int, vartype *, vartype *));
 
 #endif
@@ -24,6 +24,7 @@
 #include "core_main.h"
 #include "core_commands2.h"
 #include "core_commands4.h"
+#include "core_commands5.h"
 #include "core_commands7.h"
 #include "core_display.h"
 #include "core_display.h"
@@ -1794,43 +1795,43 @@ static int hp42ext[] = {
     CMD_NULL    | 0x4000,
 
     /* 50-5F */
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
-    CMD_NULL | 0x4000,
+    CMD_MPUT    | 0x0000,
+    CMD_MGET    | 0x0000,
+    CMD_MDEL    | 0x0000,
+    CMD_MKEY_T  | 0x0000,
+    CMD_BSRCH   | 0x0000,
+    CMD_BRACKET | 0x0000,
+    CMD_INTERP  | 0x0000,
+    CMD_ODE     | 0x0000,
+    CMD_MPUT    | 0x1000,
+    CMD_MGET    | 0x1000,
+    CMD_MDEL    | 0x1000,
+    CMD_MKEY_T  | 0x1000,
+    CMD_BSRCH   | 0x1000,
+    CMD_BRACKET | 0x1000,
+    CMD_INTERP  | 0x1000,
+    CMD_ODE     | 0x1000,
 
     /* 60-6F */
-    CMD_NULL  | 0x4000,
-    CMD_NULL  | 0x4000,
-    CMD_NULL  | 0x4000,
-    CMD_NULL  | 0x4000,
-    CMD_LCLV  | 0x2000,
-    CMD_GETMI | 0x2000,
-    CMD_PUTMI | 0x2000,
-    CMD_GETLI | 0x2000,
-    CMD_PUTLI | 0x2000,
-    CMD_NULL  | 0x4000,
-    CMD_NULL  | 0x4000,
-    CMD_NULL  | 0x4000,
-    CMD_NULL  | 0x4000,
-    CMD_NULL  | 0x4000,
-    CMD_NULL  | 0x4000,
-    CMD_NULL  | 0x4000,
+    CMD_NULL    | 0x4000,
+    CMD_NULL    | 0x4000,
+    CMD_NULL    | 0x4000,
+    CMD_NULL    | 0x4000,
+    CMD_LCLV    | 0x2000,
+    CMD_GETMI   | 0x2000,
+    CMD_PUTMI   | 0x2000,
+    CMD_GETLI   | 0x2000,
+    CMD_PUTLI   | 0x2000,
+    CMD_MPUT    | 0x2000,
+    CMD_MGET    | 0x2000,
+    CMD_MDEL    | 0x2000,
+    CMD_MKEY_T  | 0x2000,
+    CMD_BSRCH   | 0x2000,
+    CMD_BRACKET | 0x2000,
+    CMD_INTERP  | 0x2000,
 
     /* 70-7F */
-    CMD_NULL  | 0x4000,
+    CMD_ODE   | 0x2000,
     CMD_LCLV  | 0x0000,
     CMD_GETMI | 0x0000,
     CMD_PUTMI | 0x0000,
@@ -2570,137 +2571,200 @@ static int complex2buf(char *buf, phloat re, phloat im, bool always_rect, const
     return bufptr;
 }
 
-static void serialize_list(textbuf *tb, vartype_list *list, int indent) {
+static void serialize_list(textbuf *tb, vartype_list *list, int indent);
+static void serialize_map(textbuf *tb, vartype_map *map, int indent);
+
+static void serialize_element(textbuf *tb, vartype *elem, int indent) {
     char buf[50];
-    tb_indent(tb, indent);
-    tb_write(tb, "{\n", 2);
-    indent += 2;
-    tb_indent(tb, indent);
-    int n = int2string(list->size, buf, 49);
-    tb_write(tb, buf, n);
-    tb_write(tb, "-Elem List\n", 11);
-    for (int i = 0; i < list->size; i++) {
-        vartype *elem = list->array->data[i];
-        switch (elem->type) {
-            case TYPE_NULL: {
-                tb_indent(tb, indent);
-                tb_write(tb, "null\n", 5);
-                break;
-            }
-            case TYPE_REAL: {
-                vartype_real *r = (vartype_real *) elem;
-                tb_indent(tb, indent);
-                n = real2buf(buf, r->x);
-                tb_write(tb, buf, n);
-                tb_write(tb, "\n", 1);
-                break;
-            }
-            case TYPE_COMPLEX: {
-                vartype_complex *c = (vartype_complex *) elem;
-                tb_indent(tb, indent);
-                n = complex2buf(buf, c->re, c->im, true);
-                tb_write(tb, buf, n);
-                tb_write(tb, "\n", 1);
-                break;
-            }
-            case TYPE_STRING: {
-                vartype_string *s = (vartype_string *) elem;
-                tb_indent(tb, indent);
-                tb_write(tb, "\"", 1);
-                const char *txt = s->txt();
-                char cbuf[5];
-                for (int j = 0; j < s->length; j++) {
-                    unsigned char c = txt[j];
-                    if (c == 10)
-                        c = 138;
-                    else if (undefined_char(c))
-                        c &= 127;
-                    if (c == '"') {
-                        tb_write(tb, "\\\"", 2);
-                    } else if (c == '\\') {
-                        tb_write(tb, "\\\\", 2);
-                    } else {
-                        n = hp2ascii(cbuf, (const char *) &c, 1);
-                        tb_write(tb, cbuf, n);
-                    }
+    int n;
+    switch (elem->type) {
+        case TYPE_NULL: {
+            tb_indent(tb, indent);
+            tb_write(tb, "null\n", 5);
+            break;
+        }
+        case TYPE_REAL: {
+            vartype_real *r = (vartype_real *) elem;
+            tb_indent(tb, indent);
+            n = real2buf(buf, r->x);
+            tb_write(tb, buf, n);
+            tb_write(tb, "\n", 1);
+            break;
+        }
+        case TYPE_COMPLEX: {
+            vartype_complex *c = (vartype_complex *) elem;
+            tb_indent(tb, indent);
+            n = complex2buf(buf, c->re, c->im, true);
+            tb_write(tb, buf, n);
+            tb_write(tb, "\n", 1);
+            break;
+        }
+        case TYPE_STRING: {
+            vartype_string *s = (vartype_string *) elem;
+            tb_indent(tb, indent);
+            tb_write(tb, "\"", 1);
+            const char *txt = s->txt();
+            char cbuf[5];
+            for (int j = 0; j < s->length; j++) {
+                unsigned char c = txt[j];
+                if (c == 10)
+                    c = 138;
+                else if (undefined_char(c))
+                    c &= 127;
+                if (c == '"') {
+                    tb_write(tb, "\\\"", 2);
+                } else if (c == '\\') {
+                    tb_write(tb, "\\\\", 2);
+                } else {
+                    n = hp2ascii(cbuf, (const char *) &c, 1);
+                    tb_write(tb, cbuf, n);
                 }
-                tb_write(tb, "\"\n", 2);
-                break;
             }
-            case TYPE_REALMATRIX: {
-                vartype_realmatrix *rm = (vartype_realmatrix *) elem;
-                tb_indent(tb, indent);
-                tb_write(tb, "[\n", 2);
-                indent += 2;
+            tb_write(tb, "\"\n", 2);
+            break;
+        }
+        case TYPE_REALMATRIX: {
+            vartype_realmatrix *rm = (vartype_realmatrix *) elem;
+            tb_indent(tb, indent);
+            tb_write(tb, "[\n", 2);
+            indent += 2;
+            tb_indent(tb, indent);
+            n = int2string(rm->rows, buf, 49);
+            tb_write(tb, buf, n);
+            tb_write(tb, "x", 1);
+            n = int2string(rm->columns, buf, 49);
+            tb_write(tb, buf, n);
+            tb_write(tb, " Matrix\n", 8);
+            for (int j = 0; j < rm->rows * rm->columns; j++) {
                 tb_indent(tb, indent);
-                n = int2string(rm->rows, buf, 49);
-                tb_write(tb, buf, n);
-                tb_write(tb, "x", 1);
-                n = int2string(rm->columns, buf, 49);
-                tb_write(tb, buf, n);
-                tb_write(tb, " Matrix\n", 8);
-                for (int j = 0; j < rm->rows * rm->columns; j++) {
-                    tb_indent(tb, indent);
-                    if (rm->array->is_string[j]) {
-                        tb_write(tb, "\"", 1);
-                        char *text;
-                        int4 len;
-                        get_matrix_string(rm, j, &text, &len);
-                        char cbuf[5];
-                        for (int k = 0; k < len; k++) {
-                            unsigned char c = text[k];
-                            if (c == 10)
-                                c = 138;
-                            else if (undefined_char(c))
-                                c &= 127;
-                            if (c == '"') {
-                                tb_write(tb, "\\\"", 2);
-                            } else if (c == '\\') {
-                                tb_write(tb, "\\\\", 2);
-                            } else {
-                                n = hp2ascii(cbuf, (const char *) &c, 1);
-                                tb_write(tb, cbuf, n);
-                            }
+                if (rm->array->str(j)) {
+                    tb_write(tb, "\"", 1);
+                    char *text;
+                    int4 len;
+                    get_matrix_string(rm, j, &text, &len);
+                    char cbuf[5];
+                    for (int k = 0; k < len; k++) {
+                        unsigned char c = text[k];
+                        if (c == 10)
+                            c = 138;
+                        else if (undefined_char(c))
+                            c &= 127;
+                        if (c == '"') {
+                            tb_write(tb, "\\\"", 2);
+                        } else if (c == '\\') {
+                            tb_write(tb, "\\\\", 2);
+                        } else {
+                            n = hp2ascii(cbuf, (const char *) &c, 1);
+                            tb_write(tb, cbuf, n);
                         }
-                        tb_write(tb, "\"\n", 2);
-                    } else {
-                        n = real2buf(buf, rm->array->data[j]);
-                        tb_write(tb, buf, n);
-                        tb_write(tb, "\n", 1);
                     }
+                    tb_write(tb, "\"\n", 2);
+                } else {
+                    n = real2buf(buf, rm->array->data[j]);
+                    tb_write(tb, buf, n);
+                    tb_write(tb, "\n", 1);
                 }
-                indent -= 2;
-                tb_indent(tb, indent);
-                tb_write(tb, "]\n", 2);
-                break;
             }
-            case TYPE_COMPLEXMATRIX: {
-                vartype_complexmatrix *cm = (vartype_complexmatrix *) elem;
-                tb_indent(tb, indent);
-                tb_write(tb, "[\n", 2);
-                indent += 2;
+            indent -= 2;
+            tb_indent(tb, indent);
+            tb_write(tb, "]\n", 2);
+            break;
+        }
+        case TYPE_COMPLEXMATRIX: {
+            vartype_complexmatrix *cm = (vartype_complexmatrix *) elem;
+            tb_indent(tb, indent);
+            tb_write(tb, "[\n", 2);
+            indent += 2;
+            tb_indent(tb, indent);
+            n = int2string(cm->rows, buf, 49);
+            tb_write(tb, buf, n);
+            tb_write(tb, "x", 1);
+            n = int2string(cm->columns, buf, 49);
+            tb_write(tb, buf, n);
+            tb_write(tb, " Cpx Matrix\n", 12);
+            for (int j = 0; j < cm->rows * cm->columns * 2; j += 2) {
                 tb_indent(tb, indent);
-                n = int2string(cm->rows, buf, 49);
-                tb_write(tb, buf, n);
-                tb_write(tb, "x", 1);
-                n = int2string(cm->columns, buf, 49);
+                n = complex2buf(buf, cm->array->data[j], cm->array->data[j + 1], true);
                 tb_write(tb, buf, n);
-                tb_write(tb, " Cpx Matrix\n", 12);
-                for (int j = 0; j < cm->rows * cm->columns * 2; j += 2) {
+                tb_write(tb, "\n", 1);
+            }
+            indent -= 2;
+            tb_indent(tb, indent);
+            tb_write(tb, "]\n", 2);
+            break;
+        }
+        case TYPE_SPARSEMATRIX: {
+            // Written out as an ordinary matrix
+            vartype_sparsematrix *sm = (vartype_sparsematrix *) elem;
+            tb_indent(tb, indent);
+            tb_write(tb, "[\n", 2);
+            indent += 2;
+            tb_indent(tb, indent);
+            n = int2string(sm->rows, buf, 49);
+            tb_write(tb, buf, n);
+            tb_write(tb, "x", 1);
+            n = int2string(sm->columns, buf, 49);
+            tb_write(tb, buf, n);
+            tb_write(tb, " Matrix\n", 8);
+            for (int4 r = 0; r < sm->rows; r++) {
+                int4 p = sm->array->rowptr[r];
+                int4 end = sm->array->rowptr[r + 1];
+                for (int4 c = 0; c < sm->columns; c++) {
                     tb_indent(tb, indent);
-                    n = complex2buf(buf, cm->array->data[j], cm->array->data[j + 1], true);
+                    if (p < end && sm->array->colidx[p] == c)
+                        n = real2buf(buf, sm->array->values[p++]);
+                    else
+                        n = real2buf(buf, 0);
                     tb_write(tb, buf, n);
                     tb_write(tb, "\n", 1);
                 }
-                indent -= 2;
-                tb_indent(tb, indent);
-                tb_write(tb, "]\n", 2);
-                break;
-            }
-            case TYPE_LIST: {
-                serialize_list(tb, (vartype_list *) elem, indent);
-                break;
             }
+            indent -= 2;
+            tb_indent(tb, indent);
+            tb_write(tb, "]\n", 2);
+            break;
+        }
+        case TYPE_LIST: {
+            serialize_list(tb, (vartype_list *) elem, indent);
+            break;
+        }
+        case TYPE_MAP: {
+            serialize_map(tb, (vartype_map *) elem, indent);
+            break;
+        }
+    }
+}
+
+static void serialize_list(textbuf *tb, vartype_list *list, int indent) {
+    char buf[50];
+    tb_indent(tb, indent);
+    tb_write(tb, "{\n", 2);
+    indent += 2;
+    tb_indent(tb, indent);
+    int n = int2string(list->size, buf, 49);
+    tb_write(tb, buf, n);
+    tb_write(tb, "-Elem List\n", 11);
+    for (int i = 0; i < list->size; i++)
+        serialize_element(tb, list->array->data[i], indent);
+    indent -= 2;
+    tb_indent(tb, indent);
+    tb_write(tb, "}\n", 2);
+}
+
+/* Maps are written like lists, with each key followed by its value */
+static void serialize_map(textbuf *tb, vartype_map *map, int indent) {
+    char buf[50];
+    tb_indent(tb, indent);
+    tb_write(tb, "{\n", 2);
+    indent += 2;
+    tb_indent(tb, indent);
+    int n = int2string(map->array->size, buf, 49);
+    tb_write(tb, buf, n);
+    tb_write(tb, "-Elem Map\n", 10);
+    for (int4 i = 0; i < map->array->capacity; i++) {
+        if (map->array->keys[i] != NULL) {
+            serialize_element(tb, map->array->keys[i], indent);
+            serialize_element(tb, map->array->values[i], indent);
         }
     }
     indent -= 2;
@@ -2762,13 +2826,12 @@ char *core_copy() {
         const char *format = core_settings.localized_copy_paste ? number_format() : NULL;
         vartype_realmatrix *rm = (vartype_realmatrix *) stack[sp];
         phloat *data = rm->array->data;
-        char *is_string = rm->array->is_string;
         char buf[50];
-        int n = 0;
         for (int r = 0; r < rm->rows; r++) {
             for (int c = 0; c < rm->columns; c++) {
                 int bufptr;
-                if (is_string[n] == 0) {
+                int4 n = rm->index(r, c);
+                if (rm->array->str(n) == 0) {
                     bufptr = real2buf(buf, data[n], format);
                     tb_write(&tb, buf, bufptr);
                 } else {
@@ -2785,7 +2848,6 @@ char *core_copy() {
                 }
                 if (c < rm->columns - 1)
                     tb_write(&tb, "\t", 1);
-                n++;
             }
             if (r < rm->rows - 1)
                 tb_write(&tb, "\n", 1);
@@ -2796,22 +2858,45 @@ char *core_copy() {
         vartype_complexmatrix *cm = (vartype_complexmatrix *) stack[sp];
         phloat *data = cm->array->data;
         char buf[100];
-        int n = 0;
         for (int r = 0; r < cm->rows; r++) {
             for (int c = 0; c < cm->columns; c++) {
+                int4 n = 2 * cm->index(r, c);
                 int bufptr = complex2buf(buf, data[n], data[n + 1], true, format);
                 if (c < cm->columns - 1)
                     buf[bufptr++] = '\t';
                 tb_write(&tb, buf, bufptr);
-                n += 2;
             }
             if (r < cm->rows - 1)
                 tb_write(&tb, "\n", 1);
         }
         goto textbuf_finish;
+    } else if (stack[sp]->type == TYPE_SPARSEMATRIX) {
+        const char *format = core_settings.localized_copy_paste ? number_format() : NULL;
+        vartype_sparsematrix *sm = (vartype_sparsematrix *) stack[sp];
+        char buf[50];
+        for (int4 r = 0; r < sm->rows; r++) {
+            int4 p = sm->array->rowptr[r];
+            int4 end = sm->array->rowptr[r + 1];
+            for (int4 c = 0; c < sm->columns; c++) {
+                int bufptr;
+                if (p < end && sm->array->colidx[p] == c)
+                    bufptr = real2buf(buf, sm->array->values[p++], format);
+                else
+                    bufptr = real2buf(buf, 0, format);
+                if (c < sm->columns - 1)
+                    buf[bufptr++] = '\t';
+                tb_write(&tb, buf, bufptr);
+            }
+            if (r < sm->rows - 1)
+                tb_write(&tb, "\n", 1);
+        }
+        goto textbuf_finish;
     } else if (stack[sp]->type == TYPE_LIST) {
         serialize_list(&tb, (vartype_list *) stack[sp], 0);
         goto textbuf_finish;
+    } else if (stack[sp]->type == TYPE_MAP) {
+        serialize_map(&tb, (vartype_map *) stack[sp], 0);
+        goto textbuf_finish;
     } else {
         // Shouldn't happen: unrecognized data type
         return NULL;
@@ -4336,8 +4421,12 @@ static vartype *deserialize_list(const char *buf, int *pos) {
     if (len == -1)
         return NULL;
     tlen = get_token(buf, pos, &tstart);
-    if (tlen != 4 || strncmp(buf + tstart, "List", 4) != 0)
+    bool is_map = tlen == 3 && strncmp(buf + tstart, "Map", 3) == 0;
+    if (!is_map && (tlen != 4 || strncmp(buf + tstart, "List", 4) != 0))
         return NULL;
+    // A map is read as a list of alternating keys and values first
+    if (is_map)
+        len *= 2;
     vartype_list *list = (vartype_list *) new_list(len);
     if (list == NULL)
         return NULL;
@@ -4461,8 +4550,24 @@ static vartype *deserialize_list(const char *buf, int *pos) {
         failure:
         free_vartype((vartype *) list);
         return NULL;
-    } else
+    }
+    if (!is_map)
         return (vartype *) list;
+    vartype_map *map = (vartype_map *) new_map(len / 2);
+    if (map == NULL)
+        goto failure;
+    for (int i = 0; i < len; i += 2) {
+        vartype *key = list->array->data[i];
+        if (!is_map_key(key) || !map_put(map, key, list->array->data[i + 1])) {
+            free_vartype((vartype *) map);
+            goto failure;
+        }
+        // Now owned by the map
+        list->array->data[i] = NULL;
+        list->array->data[i + 1] = NULL;
+    }
+    free_vartype((vartype *) list);
+    return (vartype *) map;
 }
 
 void core_paste(const char *buf) {
@@ -4741,17 +4846,8 @@ void core_paste(const char *buf) {
             if (is_string != NULL) {
                 vartype_realmatrix *rm = (vartype_realmatrix *)
                                 malloc(sizeof(vartype_realmatrix));
-                if (rm == NULL) {
-                    free_long_strings(is_string, data, p);
-                    free(data);
-                    free(is_string);
-                    display_error(ERR_INSUFFICIENT_MEMORY);
-                    redisplay();
-                    return;
-                }
-                rm->array = (realmatrix_data *)
-                                malloc(sizeof(realmatrix_data));
-                if (rm->array == NULL) {
+                realmatrix_data *md = rm == NULL ? NULL : new_realmatrix_data(n);
+                if (md == NULL) {
                     free(rm);
                     free_long_strings(is_string, data, p);
                     free(data);
@@ -4760,12 +4856,20 @@ void core_paste(const char *buf) {
                     redisplay();
                     return;
                 }
+                memcpy((void *) md->data, (const void *) data, n * sizeof(phloat));
+                free(data);
+                for (int i = 0; i < n; i++)
+                    if (is_string[i] != 0)
+                        md->nstrings++;
+                if (md->nstrings > 0)
+                    md->is_string = is_string;
+                else
+                    free(is_string);
                 rm->type = TYPE_REALMATRIX;
                 rm->rows = rows;
                 rm->columns = cols;
-                rm->array->data = data;
-                rm->array->is_string = is_string;
-                rm->array->refcount = 1;
+                rm->array = md;
+                rm->offset = rm->rowstride = rm->colstride = 0;
                 v = (vartype *) rm;
             } else {
                 vartype_complexmatrix *cm = (vartype_complexmatrix *)
@@ -4790,6 +4894,7 @@ void core_paste(const char *buf) {
                 cm->columns = cols;
                 cm->array->data = data;
                 cm->array->refcount = 1;
+                cm->offset = cm->rowstride = cm->colstride = 0;
                 v = (vartype *) cm;
             }
         }
@@ -4810,6 +4915,101 @@ void core_paste(const char *buf) {
     redisplay();
 }
 
+static bool scan_sigma_field(const char *line, int len, int *pos, const char *format, phloat *res) {
+    int p = *pos;
+    while (p < len && (line[p] == ' ' || line[p] == '"'))
+        p++;
+    int end = scan_number(line, len, p, format, true);
+    if (end == p || !parse_phloat(line + p, end - p, res, format))
+        return false;
+    while (end < len && (line[end] == ' ' || line[end] == '"'))
+        end++;
+    *pos = end;
+    return true;
+}
+
+void core_import_sigma(const char *csv_file_name) {
+    if (mode_interruptible != NULL)
+        stop_interruptible();
+    set_running(false);
+
+    phloat *sigmaregs;
+    int err = get_sigma_regs(&sigmaregs);
+    if (err != ERR_NONE) {
+        display_error(err);
+        redisplay();
+        return;
+    }
+
+    FILE *file = my_fopen(csv_file_name, "rb");
+    if (file == NULL) {
+        char msg[1024];
+        int errnum = errno;
+        snprintf(msg, 1024, "Could not open \"%s\" for reading: %s (%d)", csv_file_name, strerror(errnum), errnum);
+        shell_message(msg);
+        return;
+    }
+
+    /* The pairs are collected in batches, so the summation registers are
+     * updated by sigma_accumulate() without ever holding the whole data
+     * set in memory.
+     */
+    const int BATCH = 256;
+    phloat xy[2 * BATCH];
+    int n = 0;
+    char line[256];
+    while (fgets(line, 256, file) != NULL) {
+        int len = (int) strlen(line);
+        if (len == 255 && line[254] != '\n') {
+            // Too long to be an x,y pair; skip the rest of it
+            int c;
+            while ((c = getc(file)) != EOF && c != '\n');
+            continue;
+        }
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+            len--;
+        line[len] = 0;
+        // Semicolon-separated files use the decimal comma
+        const char *format = strchr(line, ';') != NULL ? ",." : ".,";
+        int pos = 0;
+        /* Lines that don't start with a number, like headers and blank
+         * lines, are skipped; a line with only one number adds that x with
+         * y = 0, like Sigma+ with only one level on the stack.
+         */
+        if (!scan_sigma_field(line, len, &pos, format, &xy[2 * n]))
+            continue;
+        if (pos == len)
+            xy[2 * n + 1] = 0;
+        else {
+            if (line[pos] == ',' || line[pos] == ';' || line[pos] == '\t')
+                pos++;
+            if (!scan_sigma_field(line, len, &pos, format, &xy[2 * n + 1]))
+                continue;
+        }
+        if (++n == BATCH) {
+            sigma_accumulate(sigmaregs, xy, n, 1);
+            n = 0;
+        }
+    }
+    sigma_accumulate(sigmaregs, xy, n, 1);
+    if (ferror(file))
+        shell_message("An error occurred during the summation import.");
+    fclose(file);
+
+    vartype *v = new_real(sigmaregs[5]);
+    if (v == NULL || recall_result(v) != ERR_NONE) {
+        display_error(ERR_INSUFFICIENT_MEMORY);
+        redisplay();
+        return;
+    }
+    mode_number_entry = false;
+    mode_varmenu = false;
+    flags.f.stack_lift_disable = 0;
+    flags.f.message = 0;
+    flags.f.two_line_message = 0;
+    redisplay();
+}
+
 #if defined(ANDROID) || defined(IPHONE)
 
 void core_get_char_pixels(const char *ch, char *pixels) {
@@ -310,6 +310,19 @@ char *core_copy();
  */
 void core_paste(const char *s);
 
+/* core_import_sigma()
+ *
+ * Reads x,y pairs from the CSV file named by the csv_file_name parameter
+ * and adds them to the summation registers, as if each pair had been
+ * entered with Sigma+, and then puts the number of data points on the stack.
+ * Fields may be separated by commas, tabs, or spaces, or by semicolons, in
+ * which case the decimal comma is used. Lines that don't start with a
+ * number, such as column headers, are skipped. The file is processed one
+ * line at a time, so its size is not limited by available memory.
+ * Used by the shell to implement the Import Statistics Data command.
+ */
+void core_import_sigma(const char *csv_file_name);
+
 #if defined(ANDROID) || defined(IPHONE)
 
 /* core_get_char_pixels()
@@ -16,6 +16,7 @@
  *****************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "core_math1.h"
 #include "core_commands2.h"
@@ -97,9 +98,35 @@ struct integ_state {
 
 static integ_state integ;
 
+// Step attempts, accepted or not, before giving up with ODE Limit
+#define ODE_MAX_STEPS 10000
+
+/* ODE integrator */
+struct ode_state {
+    char active_prgm_name[7];
+    int active_prgm_length;
+    int keep_running;
+    int prev_prgm;
+    int4 prev_pc;
+    int prev_sp;
+    int state;
+    int stage;
+    int4 n, rows, columns;
+    phloat t, t1, h, acc;
+    int nsteps;
+    // y, k1 through k7, and the trial y, n elements each
+    phloat *work;
+    // Accepted steps, n + 1 elements (t, y) per row
+    int4 traj_rows, traj_capacity;
+    phloat *traj;
+};
+
+static ode_state ode;
+
 
 static void reset_solve();
 static void reset_integ();
+static void reset_ode();
 
 
 bool persist_math() {
@@ -185,6 +212,31 @@ bool persist_math() {
     if (!write_phloat(integ.prev_int)) return false;
     if (!write_phloat(integ.prev_res)) return false;
     if (!write_int(integ.prev_sp)) return false;
+
+    int ode_st = ode_active() ? ode.state : 0;
+    if (!write_int(ode_st)) return false;
+    if (ode_st != 0) {
+        if (fwrite(ode.active_prgm_name, 1, 7, gfile) != 7) return false;
+        if (!write_int(ode.active_prgm_length)) return false;
+        if (!write_int(ode.keep_running)) return false;
+        if (!write_int(ode.prev_prgm)) return false;
+        if (!write_int4(global_pc2line(ode.prev_prgm, ode.prev_pc))) return false;
+        if (!write_int(ode.prev_sp)) return false;
+        if (!write_int(ode.stage)) return false;
+        if (!write_int4(ode.n)) return false;
+        if (!write_int4(ode.rows)) return false;
+        if (!write_int4(ode.columns)) return false;
+        if (!write_phloat(ode.t)) return false;
+        if (!write_phloat(ode.t1)) return false;
+        if (!write_phloat(ode.h)) return false;
+        if (!write_phloat(ode.acc)) return false;
+        if (!write_int(ode.nsteps)) return false;
+        for (int4 i = 0; i < 9 * ode.n; i++)
+            if (!write_phloat(ode.work[i])) return false;
+        if (!write_int4(ode.traj_rows)) return false;
+        for (int4 i = 0; i < ode.traj_rows * (ode.n + 1); i++)
+            if (!write_phloat(ode.traj[i])) return false;
+    }
     return true;
 }
 
@@ -284,12 +336,50 @@ bool unpersist_math(int ver) {
     }
     solve.f_gap = NAN_PHLOAT;
 
+    reset_ode();
+    if (ver >= 56) {
+        if (!read_int(&ode.state)) return false;
+        if (ode.state != 0) {
+            ode.state = 0;
+            if (fread(ode.active_prgm_name, 1, 7, gfile) != 7) return false;
+            if (!read_int(&ode.active_prgm_length)) return false;
+            if (!read_int(&ode.keep_running)) return false;
+            if (!read_int(&ode.prev_prgm)) return false;
+            if (!read_int4(&ode.prev_pc)) return false;
+            ode.prev_pc = global_line2pc(ode.prev_prgm, ode.prev_pc);
+            if (!read_int(&ode.prev_sp)) return false;
+            if (!read_int(&ode.stage)) return false;
+            if (!read_int4(&ode.n)) return false;
+            if (!read_int4(&ode.rows)) return false;
+            if (!read_int4(&ode.columns)) return false;
+            if (!read_phloat(&ode.t)) return false;
+            if (!read_phloat(&ode.t1)) return false;
+            if (!read_phloat(&ode.h)) return false;
+            if (!read_phloat(&ode.acc)) return false;
+            if (!read_int(&ode.nsteps)) return false;
+            ode.work = (phloat *) malloc(9 * ode.n * sizeof(phloat));
+            if (ode.work == NULL)
+                return false;
+            for (int4 i = 0; i < 9 * ode.n; i++)
+                if (!read_phloat(&ode.work[i])) return false;
+            if (!read_int4(&ode.traj_rows)) return false;
+            ode.traj_capacity = ode.traj_rows;
+            ode.traj = (phloat *) malloc(ode.traj_capacity * (ode.n + 1) * sizeof(phloat));
+            if (ode.traj == NULL)
+                return false;
+            for (int4 i = 0; i < ode.traj_rows * (ode.n + 1); i++)
+                if (!read_phloat(&ode.traj[i])) return false;
+            ode.state = 1;
+        }
+    }
+
     return true;
 }
 
 void reset_math() {
     reset_solve();
     reset_integ();
+    reset_ode();
 }
 
 static void clean_stack(int prev_sp) {
@@ -1279,3 +1369,357 @@ int return_to_integ(bool stop) {
         return ERR_INTERNAL_ERROR;
     }
 }
+
+
+/* Dormand-Prince 5(4) embedded Runge-Kutta pair. The fifth-order solution
+ * is propagated, and the last stage is evaluated at the new point, so it
+ * doubles as the first stage of the next step. The coefficients are given
+ * as fractions, to be exact in both binary and decimal.
+ */
+static const int4 ode_c[8][2] = {
+    { 0, 1 }, { 0, 1 }, { 1, 5 }, { 3, 10 }, { 4, 5 }, { 8, 9 }, { 1, 1 }, { 1, 1 }
+};
+
+static const int4 ode_a[21][2] = {
+    /* 2 */ { 1, 5 },
+    /* 3 */ { 3, 40 }, { 9, 40 },
+    /* 4 */ { 44, 45 }, { -56, 15 }, { 32, 9 },
+    /* 5 */ { 19372, 6561 }, { -25360, 2187 }, { 64448, 6561 }, { -212, 729 },
+    /* 6 */ { 9017, 3168 }, { -355, 33 }, { 46732, 5247 }, { 49, 176 },
+            { -5103, 18656 },
+    /* 7 */ { 35, 384 }, { 0, 1 }, { 500, 1113 }, { 125, 192 }, { -2187, 6784 },
+            { 11, 84 }
+};
+
+// Difference between the fifth- and fourth-order weights
+static const int4 ode_e[7][2] = {
+    { 71, 57600 }, { 0, 1 }, { -71, 16695 }, { 71, 1920 }, { -17253, 339200 },
+    { 22, 525 }, { -1, 40 }
+};
+
+static void reset_ode() {
+    free((void *) ode.work);
+    ode.work = NULL;
+    free((void *) ode.traj);
+    ode.traj = NULL;
+    ode.traj_rows = 0;
+    ode.traj_capacity = 0;
+    ode.active_prgm_length = 0;
+    ode.state = 0;
+}
+
+static vartype *ode_new_y(const phloat *y) {
+    if (ode.rows == 0)
+        return new_real(y[0]);
+    vartype *v = new_realmatrix(ode.rows, ode.columns);
+    if (v != NULL)
+        memcpy((void *) ((vartype_realmatrix *) v)->array->data, (const void *) y, ode.n * sizeof(phloat));
+    return v;
+}
+
+static int ode_add_row() {
+    int4 w = ode.n + 1;
+    if (ode.traj_rows == ode.traj_capacity) {
+        int4 newcap = ode.traj_capacity < 16 ? 16 : ode.traj_capacity * 2;
+        phloat *newtraj = (phloat *) realloc((void *) ode.traj, newcap * w * sizeof(phloat));
+        if (newtraj == NULL)
+            return ERR_INSUFFICIENT_MEMORY;
+        ode.traj = newtraj;
+        ode.traj_capacity = newcap;
+    }
+    phloat *row = ode.traj + ode.traj_rows * w;
+    row[0] = ode.t;
+    memcpy((void *) (row + 1), (const void *) ode.work, ode.n * sizeof(phloat));
+    ode.traj_rows++;
+    return ERR_NONE;
+}
+
+static int ode_fail(int err) {
+    reset_ode();
+    return err;
+}
+
+static int call_ode_fn(phloat t, const phloat *y) {
+    /* The derivative program gets y in Y and t in X,
+     * and returns dy/dt, with as many elements as y, in X.
+     */
+    if (ode.active_prgm_length == 0)
+        return ode_fail(ERR_NONEXISTENT);
+    int err, i;
+    arg_struct arg;
+    clean_stack(ode.prev_sp);
+    vartype *tv = new_real(t);
+    vartype *yv = ode_new_y(y);
+    if (tv == NULL || yv == NULL) {
+        free_vartype(tv);
+        free_vartype(yv);
+        return ode_fail(ERR_INSUFFICIENT_MEMORY);
+    }
+    int saved_trace = flags.f.trace_print;
+    flags.f.trace_print = 0;
+    flags.f.stack_lift_disable = 0;
+    err = recall_two_results(tv, yv);
+    flags.f.trace_print = saved_trace;
+    if (err != ERR_NONE)
+        return ode_fail(err);
+    arg.type = ARGTYPE_STR;
+    arg.length = ode.active_prgm_length;
+    for (i = 0; i < arg.length; i++)
+        arg.val.text[i] = ode.active_prgm_name[i];
+    err = docmd_gto(&arg);
+    if (err != ERR_NONE)
+        return ode_fail(err);
+    err = push_rtn_addr(-4, 0);
+    if (err != ERR_NONE) {
+        current_prgm = ode.prev_prgm;
+        pc = ode.prev_pc;
+        return ode_fail(err);
+    } else
+        return ERR_RUN;
+}
+
+static int call_ode_stage() {
+    int4 n = ode.n;
+    int s = ode.stage;
+    phloat *y = ode.work;
+    phloat *yt = ode.work + 8 * n;
+    const int4 (*a)[2] = ode_a + (s - 2) * (s - 1) / 2;
+    for (int4 i = 0; i < n; i++) {
+        phloat sum = 0;
+        for (int j = 1; j < s; j++)
+            if (a[j - 1][0] != 0)
+                sum += phloat(a[j - 1][0]) / a[j - 1][1] * ode.work[j * n + i];
+        yt[i] = y[i] + ode.h * sum;
+    }
+    return call_ode_fn(ode.t + phloat(ode_c[s][0]) / ode_c[s][1] * ode.h, yt);
+}
+
+int start_ode(const char *name, int length) {
+    /* Z: initial state, Y: start time, X: end time.
+     * The state can be a real number or a real matrix of any shape.
+     */
+    if (ode_active())
+        return ERR_ODE_ODE;
+    vartype *y0 = stack[sp - 2];
+    if (stack[sp]->type != TYPE_REAL || stack[sp - 1]->type != TYPE_REAL)
+        return ERR_INVALID_TYPE;
+    phloat t0 = ((vartype_real *) stack[sp - 1])->x;
+    phloat t1 = ((vartype_real *) stack[sp])->x;
+    if (t0 == t1)
+        return ERR_INVALID_DATA;
+
+    phloat acc;
+    vartype *v = recall_var("ACC", 3);
+    if (v == NULL)
+        acc = phloat(1) / 1000000;
+    else if (v->type == TYPE_STRING)
+        return ERR_ALPHA_DATA_IS_INVALID;
+    else if (v->type != TYPE_REAL)
+        return ERR_INVALID_TYPE;
+    else
+        acc = ((vartype_real *) v)->x;
+    if (acc > 1)
+        acc = 1;
+    else {
+        phloat eps = phloat(1) - nextafter(phloat(1), phloat(0));
+        #ifdef BCD_MATH
+            eps *= 10;
+        #else
+            eps *= 8;
+        #endif
+        if (acc < eps)
+            acc = eps;
+    }
+
+    reset_ode();
+    if (y0->type == TYPE_REAL) {
+        ode.n = 1;
+        ode.rows = ode.columns = 0;
+    } else if (y0->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) y0;
+        if (contains_strings(rm))
+            return ERR_ALPHA_DATA_IS_INVALID;
+        ode.rows = rm->rows;
+        ode.columns = rm->columns;
+        ode.n = ode.rows * ode.columns;
+    } else
+        return ERR_INVALID_TYPE;
+    ode.work = (phloat *) malloc(9 * ode.n * sizeof(phloat));
+    if (ode.work == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    if (y0->type == TYPE_REAL)
+        ode.work[0] = ((vartype_real *) y0)->x;
+    else {
+        vartype_realmatrix *rm = (vartype_realmatrix *) y0;
+        for (int4 i = 0; i < ode.n; i++)
+            ode.work[i] = rm->array->data[rm->index(i)];
+    }
+    ode.t = t0;
+    ode.t1 = t1;
+    ode.h = (t1 - t0) / 100;
+    ode.acc = acc;
+    ode.nsteps = 0;
+    if (ode_add_row() != ERR_NONE)
+        return ode_fail(ERR_INSUFFICIENT_MEMORY);
+
+    /* The arguments are consumed; the derivative program
+     * only sees what was on the stack below them.
+     */
+    if (flags.f.big_stack) {
+        for (int i = 0; i < 3; i++)
+            free_vartype(stack[sp - i]);
+        sp -= 3;
+    }
+
+    string_copy(ode.active_prgm_name, &ode.active_prgm_length, name, length);
+    ode.prev_prgm = current_prgm;
+    ode.prev_pc = pc;
+    ode.prev_sp = flags.f.big_stack ? sp : -2;
+    ode.stage = 1;
+    ode.state = 1;
+
+    ode.keep_running = !should_i_stop_at_this_level() && program_running();
+    if (!ode.keep_running) {
+        clear_row(0);
+        draw_string(0, 0, "Integrating", 11);
+        flush_display();
+        flags.f.message = 1;
+        flags.f.two_line_message = 0;
+    }
+    return call_ode_fn(ode.t, ode.work);
+}
+
+static int finish_ode() {
+    int saved_trace = flags.f.trace_print;
+    clean_stack(ode.prev_sp);
+    int4 w = ode.n + 1;
+    vartype *x = new_realmatrix(ode.traj_rows, w);
+    vartype *y = ode_new_y(ode.work);
+    if (x == NULL || y == NULL) {
+        free_vartype(x);
+        free_vartype(y);
+        return ode_fail(ERR_INSUFFICIENT_MEMORY);
+    }
+    memcpy((void *) ((vartype_realmatrix *) x)->array->data,
+           (const void *) ode.traj, ode.traj_rows * w * sizeof(phloat));
+    reset_ode();
+    flags.f.trace_print = 0;
+    flags.f.stack_lift_disable = 0;
+    if (recall_two_results(x, y) != ERR_NONE)
+        return ERR_INSUFFICIENT_MEMORY;
+    flags.f.trace_print = saved_trace;
+
+    current_prgm = ode.prev_prgm;
+    pc = ode.prev_pc;
+
+    if (!ode.keep_running) {
+        char buf[22];
+        int bufptr = 0;
+        string2buf(buf, 22, &bufptr, "Y=", 2);
+        bufptr += vartype2string(y, buf + bufptr, 22 - bufptr);
+        clear_row(0);
+        draw_string(0, 0, buf, bufptr);
+        flush_display();
+        flags.f.message = 1;
+        flags.f.two_line_message = 0;
+        if ((flags.f.trace_print || flags.f.normal_print) && flags.f.printer_exists)
+            print_wide(buf, 2, buf + 2, bufptr - 2);
+        return ERR_STOP;
+    } else
+        return ERR_NONE;
+}
+
+int return_to_ode(bool stop) {
+    if (stop)
+        ode.keep_running = 0;
+    if (ode.state == 0)
+        return ERR_INTERNAL_ERROR;
+
+    /* Collect the derivative for the current stage */
+    int4 n = ode.n;
+    phloat *k = ode.work + ode.stage * n;
+    if (sp == -1)
+        return ode_fail(ERR_TOO_FEW_ARGUMENTS);
+    vartype *v = stack[sp];
+    if (v->type == TYPE_REAL && n == 1) {
+        k[0] = ((vartype_real *) v)->x;
+    } else if (v->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) v;
+        if (contains_strings(rm))
+            return ode_fail(ERR_ALPHA_DATA_IS_INVALID);
+        if (rm->rows * rm->columns != n)
+            return ode_fail(ERR_DIMENSION_ERROR);
+        for (int4 i = 0; i < n; i++)
+            k[i] = rm->array->data[rm->index(i)];
+    } else if (v->type == TYPE_STRING)
+        return ode_fail(ERR_ALPHA_DATA_IS_INVALID);
+    else if (v->type == TYPE_REAL)
+        return ode_fail(ERR_DIMENSION_ERROR);
+    else
+        return ode_fail(ERR_INVALID_TYPE);
+
+    if (ode.stage < 7) {
+        ode.stage++;
+        return call_ode_stage();
+    }
+
+    /* All stages done; the trial point is the fifth-order solution.
+     * Use a mixed error test, with ACC as both the absolute and the
+     * relative tolerance, and the RMS norm over all components.
+     */
+    phloat *y = ode.work;
+    phloat *yt = ode.work + 8 * n;
+    phloat err = 0;
+    for (int4 i = 0; i < n; i++) {
+        phloat e = 0;
+        for (int j = 0; j < 7; j++)
+            if (ode_e[j][0] != 0)
+                e += phloat(ode_e[j][0]) / ode_e[j][1] * ode.work[(j + 1) * n + i];
+        e *= ode.h;
+        phloat ay = fabs(y[i]);
+        phloat ayt = fabs(yt[i]);
+        phloat sc = ode.acc * (1 + (ay > ayt ? ay : ayt));
+        e /= sc;
+        err += e * e;
+    }
+    err = sqrt(err / n);
+
+    phloat factor;
+    if (err <= 1) {
+        /* Accept */
+        bool last = ode.h > 0 ? ode.t + ode.h >= ode.t1 : ode.t + ode.h <= ode.t1;
+        ode.t = last ? ode.t1 : ode.t + ode.h;
+        memcpy((void *) y, (const void *) yt, n * sizeof(phloat));
+        memcpy((void *) (ode.work + n), (const void *) (ode.work + 7 * n), n * sizeof(phloat));
+        if (ode_add_row() != ERR_NONE)
+            return ode_fail(ERR_INSUFFICIENT_MEMORY);
+        if (last)
+            return finish_ode();
+        factor = err == 0 ? 5 : phloat(0.9) * pow(err, phloat(-0.2));
+        if (factor > 5)
+            factor = 5;
+    } else {
+        /* Reject; k1 is still good */
+        factor = p_isnan(err) ? 0 : phloat(0.9) * pow(err, phloat(-0.2));
+        if (factor > 1)
+            factor = 1;
+    }
+    if (factor < phloat(0.2))
+        factor = phloat(0.2);
+    ode.h *= factor;
+    bool clipped = ode.h > 0 ? ode.t + ode.h >= ode.t1 : ode.t + ode.h <= ode.t1;
+    if (clipped)
+        ode.h = ode.t1 - ode.t;
+    if (ode.t + ode.h == ode.t) {
+        if (clipped)
+            // Within rounding of the end point already
+            return finish_ode();
+        // Step size underflow: the solution is probably singular here
+        return ode_fail(ERR_OUT_OF_RANGE);
+    }
+
+    if (++ode.nsteps >= ODE_MAX_STEPS)
+        return ode_fail(ERR_ODE_LIMIT);
+    ode.stage = 2;
+    return call_ode_stage();
+}
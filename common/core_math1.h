@@ -39,4 +39,7 @@ void get_integ_var(char *name, int *length);
 int start_integ(const char *name, int length);
 int return_to_integ(bool stop);
 
+int start_ode(const char *name, int length);
+int return_to_ode(bool stop);
+
 #endif
@@ -36,6 +36,8 @@ static int apply_sto_operation(char operation, vartype *oldval, bool trace_stk)
     int error = assert_numeric(oldval);
     if (error != ERR_NONE)
         return error;
+    if (is_matrix_view(oldval) && !disentangle(oldval))
+        return ERR_INSUFFICIENT_MEMORY;
     if (!ensure_var_space(1))
         return ERR_INSUFFICIENT_MEMORY;
     vartype *newval;
@@ -62,7 +64,8 @@ static int apply_sto_operation(char operation, vartype *oldval, bool trace_stk)
 
 int assert_numeric(const vartype *v) {
     if (v->type == TYPE_REAL || v->type == TYPE_COMPLEX
-            || v->type == TYPE_REALMATRIX || v->type == TYPE_COMPLEXMATRIX)
+            || v->type == TYPE_REALMATRIX || v->type == TYPE_COMPLEXMATRIX
+            || v->type == TYPE_SPARSEMATRIX)
         return ERR_NONE;
     else if (v->type == TYPE_STRING)
         return ERR_ALPHA_DATA_IS_INVALID;
@@ -81,7 +84,7 @@ int generic_rcl(arg_struct *arg, vartype **dst) {
     }
     switch (arg->type) {
         case ARGTYPE_NUM: {
-            vartype *regs = recall_var("REGS", 4);
+            vartype *regs = recall_regs();
             if (regs == NULL)
                 return ERR_SIZE_ERROR;
             if (regs->type == TYPE_REALMATRIX) {
@@ -90,7 +93,7 @@ int generic_rcl(arg_struct *arg, vartype **dst) {
                 int4 index = arg->val.num;
                 if (index >= size)
                     return ERR_SIZE_ERROR;
-                if (rm->array->is_string[index] == 0) {
+                if (rm->array->str(index) == 0) {
                     *dst = new_real(rm->array->data[index]);
                 } else {
                     char *text;
@@ -137,6 +140,10 @@ int generic_rcl(arg_struct *arg, vartype **dst) {
             }
             if (*dst == NULL)
                 return ERR_INSUFFICIENT_MEMORY;
+            if (is_matrix_view(*dst) && !disentangle(*dst)) {
+                free_vartype(*dst);
+                return ERR_INSUFFICIENT_MEMORY;
+            }
             return ERR_NONE;
         }
         case ARGTYPE_STR: {
@@ -208,7 +215,7 @@ int generic_sto(arg_struct *arg, char operation) {
 
     switch (arg->type) {
         case ARGTYPE_NUM: {
-            vartype *regs = recall_var("REGS", 4);
+            vartype *regs = recall_regs();
             if (regs == NULL)
                 return ERR_SIZE_ERROR;
             if (regs->type == TYPE_REALMATRIX) {
@@ -228,14 +235,11 @@ int generic_sto(arg_struct *arg, char operation) {
                     if (!disentangle((vartype *) rm))
                         return ERR_INSUFFICIENT_MEMORY;
                     if (operation == 0) {
-                        if (rm->array->is_string[num] == 2)
-                            free(*(void **) &rm->array->data[num]);
-                        rm->array->data[num] = ((vartype_real *) stack[sp])->x;
-                        rm->array->is_string[num] = 0;
+                        put_matrix_number(rm, num, ((vartype_real *) stack[sp])->x);
                     } else {
                         phloat x, n;
                         int inf;
-                        if (rm->array->is_string[num] != 0)
+                        if (rm->array->str(num) != 0)
                             return ERR_ALPHA_DATA_IS_INVALID;
                         x = ((vartype_real *) stack[sp])->x;
                         n = rm->array->data[num];
@@ -449,7 +453,8 @@ int generic_sto(arg_struct *arg, char operation) {
                     return ERR_NONEXISTENT;
                 if (operation == '*'
                         && (stack[sp]->type == TYPE_REALMATRIX
-                            || stack[sp]->type == TYPE_COMPLEXMATRIX)
+                            || stack[sp]->type == TYPE_COMPLEXMATRIX
+                            || stack[sp]->type == TYPE_SPARSEMATRIX)
                         && matedit_mode == 3
                         && matedit_level == vars[idx].level
                         && string_equals(arg->val.text,
@@ -464,6 +469,164 @@ int generic_sto(arg_struct *arg, char operation) {
     }
 }
 
+/* Sparse matrices are mapped element by element, like ordinary matrices,
+ * but if the function does not map 0 to 0, the result can't be sparse, and
+ * the operation is performed on a dense copy instead.
+ */
+static int map_unary_sparse(const vartype_sparsematrix *sm, vartype **dst,
+                                                                mappable_r mr) {
+    phloat z;
+    int error;
+    if (mr(0, &z) != ERR_NONE || z != 0) {
+        vartype *dm = sparse_to_dense(sm);
+        if (dm == NULL)
+            return ERR_INSUFFICIENT_MEMORY;
+        error = map_unary(dm, dst, mr, NULL);
+        free_vartype(dm);
+        return error;
+    }
+    vartype_sparsematrix *rm = (vartype_sparsematrix *)
+                    new_sparsematrix(sm->rows, sm->columns, sm->nnz());
+    if (rm == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    const sparsematrix_data *sd = sm->array;
+    sparsematrix_data *rd = rm->array;
+    int4 q = 0;
+    for (int4 i = 0; i < sm->rows; i++) {
+        for (int4 p = sd->rowptr[i]; p < sd->rowptr[i + 1]; p++) {
+            error = mr(sd->values[p], &z);
+            if (error != ERR_NONE) {
+                free_vartype((vartype *) rm);
+                return error;
+            }
+            if (z != 0) {
+                rd->colidx[q] = sd->colidx[p];
+                rd->values[q] = z;
+                q++;
+            }
+        }
+        rd->rowptr[i + 1] = q;
+    }
+    *dst = (vartype *) rm;
+    return ERR_NONE;
+}
+
+/* Binary operations with at least one sparse operand. The other operand may
+ * be a real number, a real matrix, or another sparse matrix. The result is
+ * sparse if there are no dense operands, and the function maps (0, 0) to 0;
+ * otherwise, the sparse operands are expanded, and the result is dense.
+ */
+static int map_binary_sparse(const vartype *src1, const vartype *src2,
+        vartype **dst, mappable_rr mrr, mappable_rc mrc, mappable_cr mcr,
+        mappable_cc mcc) {
+    const vartype *src[2] = { src1, src2 };
+    int4 rows = -1, columns = -1;
+    bool sparse_result = true;
+    phloat z0[2] = { 0, 0 };
+    int i, error;
+    for (i = 0; i < 2; i++) {
+        int4 r, c;
+        switch (src[i]->type) {
+            case TYPE_REAL:
+                z0[i] = ((vartype_real *) src[i])->x;
+                continue;
+            case TYPE_SPARSEMATRIX:
+                r = ((vartype_sparsematrix *) src[i])->rows;
+                c = ((vartype_sparsematrix *) src[i])->columns;
+                break;
+            case TYPE_REALMATRIX:
+                if (contains_strings((vartype_realmatrix *) src[i]))
+                    return ERR_ALPHA_DATA_IS_INVALID;
+                r = ((vartype_realmatrix *) src[i])->rows;
+                c = ((vartype_realmatrix *) src[i])->columns;
+                sparse_result = false;
+                break;
+            case TYPE_STRING:
+                return ERR_ALPHA_DATA_IS_INVALID;
+            default:
+                return ERR_INVALID_TYPE;
+        }
+        if (rows == -1) {
+            rows = r;
+            columns = c;
+        } else if (rows != r || columns != c)
+            return ERR_DIMENSION_ERROR;
+    }
+    if (sparse_result) {
+        phloat z;
+        if (mrr(z0[0], z0[1], &z) != ERR_NONE || z != 0)
+            sparse_result = false;
+    }
+
+    if (!sparse_result) {
+        vartype *d[2] = { NULL, NULL };
+        for (i = 0; i < 2; i++)
+            if (src[i]->type == TYPE_SPARSEMATRIX) {
+                d[i] = sparse_to_dense((vartype_sparsematrix *) src[i]);
+                if (d[i] == NULL) {
+                    free_vartype(d[0]);
+                    return ERR_INSUFFICIENT_MEMORY;
+                }
+            }
+        error = map_binary(d[0] != NULL ? d[0] : src1,
+                           d[1] != NULL ? d[1] : src2,
+                           dst, mrr, mrc, mcr, mcc);
+        free_vartype(d[0]);
+        free_vartype(d[1]);
+        return error;
+    }
+
+    /* Merge the rows of the sparse operand(s); positions where both
+     * operands are zero are skipped, since we know those map to zero.
+     */
+    const sparsematrix_data *sd[2] = { NULL, NULL };
+    int4 capacity = 0;
+    for (i = 0; i < 2; i++)
+        if (src[i]->type == TYPE_SPARSEMATRIX) {
+            sd[i] = ((vartype_sparsematrix *) src[i])->array;
+            capacity += ((vartype_sparsematrix *) src[i])->nnz();
+        }
+    vartype_sparsematrix *rm = (vartype_sparsematrix *)
+                            new_sparsematrix(rows, columns, capacity);
+    if (rm == NULL)
+        return ERR_INSUFFICIENT_MEMORY;
+    sparsematrix_data *rd = rm->array;
+    int4 q = 0;
+    for (int4 r = 0; r < rows; r++) {
+        int4 p[2], end[2];
+        for (i = 0; i < 2; i++)
+            if (sd[i] == NULL) {
+                p[i] = end[i] = 0;
+            } else {
+                p[i] = sd[i]->rowptr[r];
+                end[i] = sd[i]->rowptr[r + 1];
+            }
+        while (p[0] < end[0] || p[1] < end[1]) {
+            int4 c0 = p[0] < end[0] ? sd[0]->colidx[p[0]] : columns;
+            int4 c1 = p[1] < end[1] ? sd[1]->colidx[p[1]] : columns;
+            int4 c = c0 < c1 ? c0 : c1;
+            phloat x = z0[0], y = z0[1], z;
+            if (c0 == c)
+                x = sd[0]->values[p[0]++];
+            if (c1 == c)
+                y = sd[1]->values[p[1]++];
+            error = mrr(x, y, &z);
+            if (error != ERR_NONE) {
+                free_vartype((vartype *) rm);
+                return error;
+            }
+            if (z != 0) {
+                rd->colidx[q] = c;
+                rd->values[q] = z;
+                q++;
+            }
+        }
+        rd->rowptr[r + 1] = q;
+    }
+    *dst = (vartype *) rm;
+    return ERR_NONE;
+}
+
 int map_unary(const vartype *src, vartype **dst, mappable_r mr, mappable_c mc) {
     int error;
     switch (src->type) {
@@ -529,6 +692,8 @@ int map_unary(const vartype *src, vartype **dst, mappable_r mr, mappable_c mc) {
             *dst = (vartype *) dm;
             return ERR_NONE;
         }
+        case TYPE_SPARSEMATRIX:
+            return map_unary_sparse((vartype_sparsematrix *) src, dst, mr);
         default:
             return ERR_INTERNAL_ERROR;
     }
@@ -537,6 +702,8 @@ int map_unary(const vartype *src, vartype **dst, mappable_r mr, mappable_c mc) {
 int map_binary(const vartype *src1, const vartype *src2, vartype **dst,
         mappable_rr mrr, mappable_rc mrc, mappable_cr mcr, mappable_cc mcc) {
     int error;
+    if (src1->type == TYPE_SPARSEMATRIX || src2->type == TYPE_SPARSEMATRIX)
+        return map_binary_sparse(src1, src2, dst, mrr, mrc, mcr, mcc);
     switch (src1->type) {
         case TYPE_REAL:
             switch (src2->type) {
@@ -1286,9 +1453,13 @@ static int add_cc(phloat xre, phloat xim, phloat yre, phloat yim,
     return ERR_NONE;
 }
 
+static bool is_matrix(const vartype *v) {
+    return v->type == TYPE_REALMATRIX || v->type == TYPE_COMPLEXMATRIX
+            || v->type == TYPE_SPARSEMATRIX;
+}
+
 int generic_div(const vartype *px, const vartype *py, int (*completion)(int, vartype *)) {
-    if ((px->type == TYPE_REALMATRIX || px->type == TYPE_COMPLEXMATRIX)
-            && (py->type == TYPE_REALMATRIX || py->type == TYPE_COMPLEXMATRIX)) {
+    if (is_matrix(px) && is_matrix(py)) {
         return linalg_div(py, px, completion);
     } else {
         vartype *dst;
@@ -1298,8 +1469,7 @@ int generic_div(const vartype *px, const vartype *py, int (*completion)(int, var
 }
 
 int generic_mul(const vartype *px, const vartype *py, int (*completion)(int, vartype *)) {
-    if ((px->type == TYPE_REALMATRIX || px->type == TYPE_COMPLEXMATRIX)
-            && (py->type == TYPE_REALMATRIX || py->type == TYPE_COMPLEXMATRIX)) {
+    if (is_matrix(px) && is_matrix(py)) {
         return linalg_mul(py, px, completion);
     } else {
         vartype *dst;
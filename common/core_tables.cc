@@ -55,45 +55,45 @@
 
 const command_spec cmd_array[] =
 {
-    { /* CLX */         docmd_clx,         "CLX",                 0x00, 0x00, 0x00, 0x77,  3, ARG_NONE,   1, ALLT },
-    { /* ENTER */       docmd_enter,       "ENT\305R",            0x00, 0x00, 0x00, 0x83,  5, ARG_NONE,   1, ALLT },
-    { /* SWAP */        docmd_swap,        "X<>Y",                0x00, 0x00, 0x00, 0x71,  4, ARG_NONE,   2, ALLT },
+    { /* CLX */         docmd_clx,         "CLX",                 0x80, 0x00, 0x00, 0x77,  3, ARG_NONE,   1, ALLT },
+    { /* ENTER */       docmd_enter,       "ENT\305R",            0x80, 0x00, 0x00, 0x83,  5, ARG_NONE,   1, ALLT },
+    { /* SWAP */        docmd_swap,        "X<>Y",                0x80, 0x00, 0x00, 0x71,  4, ARG_NONE,   2, ALLT },
     { /* RDN */         docmd_rdn,         "R\16",                0x00, 0x00, 0x00, 0x75,  2, ARG_NONE,   0, NA_T },
-    { /* CHS */         docmd_chs,         "+/-",                 0x00, 0x00, 0x00, 0x54,  3, ARG_NONE,   1, 0x0f },
-    { /* DIV */         docmd_div,         "\0",                  0x00, 0x00, 0x00, 0x43,  1, ARG_NONE,   2, 0x0f },
-    { /* MUL */         docmd_mul,         "\1",                  0x00, 0x00, 0x00, 0x42,  1, ARG_NONE,   2, 0x0f },
-    { /* SUB */         docmd_sub,         "-",                   0x00, 0x00, 0x00, 0x41,  1, ARG_NONE,   2, 0x0f },
-    { /* ADD */         docmd_add,         "+",                   0x00, 0x00, 0x00, 0x40,  1, ARG_NONE,   2, 0x0f },
+    { /* CHS */         docmd_chs,         "+/-",                 0x00, 0x00, 0x00, 0x54,  3, ARG_NONE,   1, 0x4f },
+    { /* DIV */         docmd_div,         "\0",                  0x00, 0x00, 0x00, 0x43,  1, ARG_NONE,   2, 0x4f },
+    { /* MUL */         docmd_mul,         "\1",                  0x00, 0x00, 0x00, 0x42,  1, ARG_NONE,   2, 0x4f },
+    { /* SUB */         docmd_sub,         "-",                   0x00, 0x00, 0x00, 0x41,  1, ARG_NONE,   2, 0x4f },
+    { /* ADD */         docmd_add,         "+",                   0x00, 0x00, 0x00, 0x40,  1, ARG_NONE,   2, 0x4f },
     { /* LASTX */       docmd_lastx,       "LASTX",               0x00, 0x00, 0x00, 0x76,  5, ARG_NONE,   0, NA_T },
     { /* SILENT_OFF */  NULL,              "",                    0x34, 0x00, 0x00, 0x00,  0, ARG_NONE,   0, NA_T },
     { /* SILENT_ON */   NULL,              "",                    0x34, 0x00, 0x00, 0x00,  0, ARG_NONE,   0, NA_T },
-    { /* SIN */         docmd_sin,         "SIN",                 0x00, 0x00, 0x00, 0x59,  3, ARG_NONE,   1, 0x0f },
-    { /* COS */         docmd_cos,         "COS",                 0x00, 0x00, 0x00, 0x5a,  3, ARG_NONE,   1, 0x0f },
-    { /* TAN */         docmd_tan,         "TAN",                 0x00, 0x00, 0x00, 0x5b,  3, ARG_NONE,   1, 0x0f },
-    { /* ASIN */        docmd_asin,        "ASIN",                0x00, 0x00, 0x00, 0x5c,  4, ARG_NONE,   1, 0x0f },
-    { /* ACOS */        docmd_acos,        "ACOS",                0x00, 0x00, 0x00, 0x5d,  4, ARG_NONE,   1, 0x0f },
-    { /* ATAN */        docmd_atan,        "ATAN",                0x00, 0x00, 0x00, 0x5e,  4, ARG_NONE,   1, 0x0f },
-    { /* LOG */         docmd_log,         "LOG",                 0x00, 0x00, 0x00, 0x56,  3, ARG_NONE,   1, 0x0f },
-    { /* 10_POW_X */    docmd_10_pow_x,    "10^X",                0x00, 0x00, 0x00, 0x57,  4, ARG_NONE,   1, 0x0f },
-    { /* LN */          docmd_ln,          "LN",                  0x00, 0x00, 0x00, 0x50,  2, ARG_NONE,   1, 0x0f },
-    { /* E_POW_X */     docmd_e_pow_x,     "E^X",                 0x00, 0x00, 0x00, 0x55,  3, ARG_NONE,   1, 0x0f },
-    { /* SQRT */        docmd_sqrt,        "SQRT",                0x00, 0x00, 0x00, 0x52,  4, ARG_NONE,   1, 0x0f },
-    { /* SQUARE */      docmd_square,      "X^2",                 0x00, 0x00, 0x00, 0x51,  3, ARG_NONE,   1, 0x0f },
-    { /* INV */         docmd_inv,         "1/X",                 0x00, 0x00, 0x00, 0x60,  3, ARG_NONE,   1, 0x0f },
+    { /* SIN */         docmd_sin,         "SIN",                 0x00, 0x00, 0x00, 0x59,  3, ARG_NONE,   1, 0x4f },
+    { /* COS */         docmd_cos,         "COS",                 0x00, 0x00, 0x00, 0x5a,  3, ARG_NONE,   1, 0x4f },
+    { /* TAN */         docmd_tan,         "TAN",                 0x00, 0x00, 0x00, 0x5b,  3, ARG_NONE,   1, 0x4f },
+    { /* ASIN */        docmd_asin,        "ASIN",                0x00, 0x00, 0x00, 0x5c,  4, ARG_NONE,   1, 0x4f },
+    { /* ACOS */        docmd_acos,        "ACOS",                0x00, 0x00, 0x00, 0x5d,  4, ARG_NONE,   1, 0x4f },
+    { /* ATAN */        docmd_atan,        "ATAN",                0x00, 0x00, 0x00, 0x5e,  4, ARG_NONE,   1, 0x4f },
+    { /* LOG */         docmd_log,         "LOG",                 0x00, 0x00, 0x00, 0x56,  3, ARG_NONE,   1, 0x4f },
+    { /* 10_POW_X */    docmd_10_pow_x,    "10^X",                0x00, 0x00, 0x00, 0x57,  4, ARG_NONE,   1, 0x4f },
+    { /* LN */          docmd_ln,          "LN",                  0x00, 0x00, 0x00, 0x50,  2, ARG_NONE,   1, 0x4f },
+    { /* E_POW_X */     docmd_e_pow_x,     "E^X",                 0x00, 0x00, 0x00, 0x55,  3, ARG_NONE,   1, 0x4f },
+    { /* SQRT */        docmd_sqrt,        "SQRT",                0x00, 0x00, 0x00, 0x52,  4, ARG_NONE,   1, 0x4f },
+    { /* SQUARE */      docmd_square,      "X^2",                 0x00, 0x00, 0x00, 0x51,  3, ARG_NONE,   1, 0x4f },
+    { /* INV */         docmd_inv,         "1/X",                 0x00, 0x00, 0x00, 0x60,  3, ARG_NONE,   1, 0x4f },
     { /* Y_POW_X */     docmd_y_pow_x,     "Y^X",                 0x00, 0x00, 0x00, 0x53,  3, ARG_NONE,   2, FUNC },
     { /* PERCENT */     docmd_percent,     "%",                   0x00, 0x00, 0x00, 0x4c,  1, ARG_NONE,   2, 0x01 },
     { /* PI */          docmd_pi,          "PI",                  0x00, 0x00, 0x00, 0x72,  2, ARG_NONE,   0, NA_T },
     { /* COMPLEX */     docmd_complex,     "C\317\315PL\305X",    0x00, 0x00, 0xa0, 0x72,  7, ARG_NONE,  -1, 0x00 },
-    { /* STO */         docmd_sto,         "STO",                 0x20, 0x81, 0x00, 0x91,  3, ARG_VAR,    1, ALLT },
-    { /* STO_DIV */     docmd_sto_div,     "STO\0",               0x00, 0x85, 0x00, 0x95,  4, ARG_VAR,    1, 0x0f },
-    { /* STO_MUL */     docmd_sto_mul,     "STO\1",               0x00, 0x84, 0x00, 0x94,  4, ARG_VAR,    1, 0x0f },
-    { /* STO_SUB */     docmd_sto_sub,     "STO-",                0x00, 0x83, 0x00, 0x93,  4, ARG_VAR,    1, 0x0f },
-    { /* STO_ADD */     docmd_sto_add,     "STO+",                0x00, 0x82, 0x00, 0x92,  4, ARG_VAR,    1, 0x0f },
+    { /* STO */         docmd_sto,         "STO",                 0xa0, 0x81, 0x00, 0x91,  3, ARG_VAR,    1, ALLT },
+    { /* STO_DIV */     docmd_sto_div,     "STO\0",               0x00, 0x85, 0x00, 0x95,  4, ARG_VAR,    1, 0x4f },
+    { /* STO_MUL */     docmd_sto_mul,     "STO\1",               0x00, 0x84, 0x00, 0x94,  4, ARG_VAR,    1, 0x4f },
+    { /* STO_SUB */     docmd_sto_sub,     "STO-",                0x00, 0x83, 0x00, 0x93,  4, ARG_VAR,    1, 0x4f },
+    { /* STO_ADD */     docmd_sto_add,     "STO+",                0x00, 0x82, 0x00, 0x92,  4, ARG_VAR,    1, 0x4f },
     { /* RCL */         docmd_rcl,         "RCL",                 0x20, 0x91, 0x00, 0x90,  3, ARG_VAR,    0, NA_T },
-    { /* RCL_DIV */     docmd_rcl_div,     "RCL\0",               0x00, 0x95, 0xf2, 0xd4,  4, ARG_VAR,    1, 0x0f },
-    { /* RCL_MUL */     docmd_rcl_mul,     "RCL\1",               0x00, 0x94, 0xf2, 0xd3,  4, ARG_VAR,    1, 0x0f },
-    { /* RCL_SUB */     docmd_rcl_sub,     "RCL-",                0x00, 0x93, 0xf2, 0xd2,  4, ARG_VAR,    1, 0x0f },
-    { /* RCL_ADD */     docmd_rcl_add,     "RCL+",                0x00, 0x92, 0xf2, 0xd1,  4, ARG_VAR,    1, 0x0f },
+    { /* RCL_DIV */     docmd_rcl_div,     "RCL\0",               0x00, 0x95, 0xf2, 0xd4,  4, ARG_VAR,    1, 0x4f },
+    { /* RCL_MUL */     docmd_rcl_mul,     "RCL\1",               0x00, 0x94, 0xf2, 0xd3,  4, ARG_VAR,    1, 0x4f },
+    { /* RCL_SUB */     docmd_rcl_sub,     "RCL-",                0x00, 0x93, 0xf2, 0xd2,  4, ARG_VAR,    1, 0x4f },
+    { /* RCL_ADD */     docmd_rcl_add,     "RCL+",                0x00, 0x92, 0xf2, 0xd1,  4, ARG_VAR,    1, 0x4f },
     { /* FIX */         docmd_fix,         "FIX",                 0x20, 0xd4, 0x00, 0x9c,  3, ARG_NUM11,  0, NA_T },
     { /* SCI */         docmd_sci,         "SCI",                 0x20, 0xd5, 0x00, 0x9d,  3, ARG_NUM11,  0, NA_T },
     { /* ENG */         docmd_eng,         "ENG",                 0x20, 0xd6, 0x00, 0x9e,  3, ARG_NUM11,  0, NA_T },
@@ -133,7 +133,7 @@ const command_spec cmd_array[] =
     { /* TO_POL */      docmd_to_pol,      "\17POL",              0x00, 0x00, 0x00, 0x4f,  4, ARG_NONE,  -1, 0x00 },
     { /* IP */          docmd_ip,          "IP",                  0x00, 0x00, 0x00, 0x68,  2, ARG_NONE,   1, 0x05 },
     { /* FP */          docmd_fp,          "FP",                  0x00, 0x00, 0x00, 0x69,  2, ARG_NONE,   1, 0x05 },
-    { /* RND */         docmd_rnd,         "RND",                 0x00, 0x00, 0x00, 0x6e,  3, ARG_NONE,   1, 0x0f },
+    { /* RND */         docmd_rnd,         "RND",                 0x00, 0x00, 0x00, 0x6e,  3, ARG_NONE,   1, 0x4f },
     { /* ABS */         docmd_abs,         "ABS",                 0x00, 0x00, 0x00, 0x61,  3, ARG_NONE,   1, 0x07 },
     { /* SIGN */        docmd_sign,        "SIGN",                0x00, 0x00, 0x00, 0x7a,  4, ARG_NONE,   1, 0x1f },
     { /* MOD */         docmd_mod,         "MOD",                 0x00, 0x00, 0x00, 0x4b,  3, ARG_NONE,   2, 0x01 },
@@ -213,10 +213,10 @@ const command_spec cmd_array[] =
     { /* NEWMAT */      docmd_newmat,      "NEW\315\301\324",     0x00, 0x00, 0xa6, 0xda,  6, ARG_NONE,   2, 0x01 },
     { /* RUP */         docmd_rup,         "R^",                  0x00, 0x00, 0x00, 0x74,  2, ARG_NONE,   0, NA_T },
     { /* REAL_T */      docmd_real_t,      "RE\301L?",            0x00, 0x00, 0xa2, 0x65,  5, ARG_NONE,   1, ALLT },
-    { /* CPX_T */       docmd_cpx_t,       "CPX?",                0x00, 0x00, 0xa2, 0x67,  4, ARG_NONE,   1, ALLT },
-    { /* STR_T */       docmd_str_t,       "STR?",                0x00, 0x00, 0xa2, 0x68,  4, ARG_NONE,   1, ALLT },
-    { /* MAT_T */       docmd_mat_t,       "MAT?",                0x00, 0x00, 0xa2, 0x66,  4, ARG_NONE,   1, ALLT },
-    { /* DIM_T */       docmd_dim_t,       "DIM?",                0x00, 0x00, 0xa6, 0xe7,  4, ARG_NONE,   1, 0x0c },
+    { /* CPX_T */       docmd_cpx_t,       "CPX?",                0x80, 0x00, 0xa2, 0x67,  4, ARG_NONE,   1, ALLT },
+    { /* STR_T */       docmd_str_t,       "STR?",                0x80, 0x00, 0xa2, 0x68,  4, ARG_NONE,   1, ALLT },
+    { /* MAT_T */       docmd_mat_t,       "MAT?",                0x80, 0x00, 0xa2, 0x66,  4, ARG_NONE,   1, ALLT },
+    { /* DIM_T */       docmd_dim_t,       "DIM?",                0x80, 0x00, 0xa6, 0xe7,  4, ARG_NONE,   1, 0x4c },
     { /* ASSIGNa */     NULL,              "AS\323\311GN",        0x40, 0x00, 0x00, 0x00,  6, ARG_NAMED,  0, NA_T },
     { /* ASSIGNb */     NULL,              "",                    0x44, 0x00, 0x00, 0x00,  0, ARG_CKEY,   0, NA_T },
     { /* ASGN01 */      docmd_asgn01,      "",                    0x24, 0x00, 0x00, 0x00,  0, ARG_OTHER,  0, NA_T },
@@ -262,7 +262,7 @@ const command_spec cmd_array[] =
     { /* SIGMAREG */    docmd_sigma_reg,   "\5REG",               0x00, 0xd3, 0x00, 0x99,  4, ARG_NUM99,  0, NA_T },
     { /* SIGMAREG_T */  docmd_sigma_reg_t, "\5R\305G?",           0x00, 0x00, 0xa6, 0x78,  5, ARG_NONE,   0, NA_T },
     { /* CLD */         docmd_cld,         "CLD",                 0x00, 0x00, 0x00, 0x7f,  3, ARG_NONE,   0, NA_T },
-    { /* ACOSH */       docmd_acosh,       "ACOSH",               0x00, 0x00, 0xa0, 0x66,  5, ARG_NONE,   1, 0x0f },
+    { /* ACOSH */       docmd_acosh,       "ACOSH",               0x00, 0x00, 0xa0, 0x66,  5, ARG_NONE,   1, 0x4f },
     { /* ALENG */       docmd_aleng,       "ALEN\307",            0x00, 0x00, 0xa6, 0x41,  5, ARG_NONE,   0, NA_T },
     { /* ALLSIGMA */    docmd_allsigma,    "ALL\5",               0x00, 0x00, 0xa0, 0xae,  4, ARG_NONE,   0, NA_T },
     { /* AND */         docmd_and,         "AND",                 0x00, 0x00, 0xa5, 0x88,  3, ARG_NONE,   2, 0x01 },
@@ -270,8 +270,8 @@ const command_spec cmd_array[] =
     { /* AON */         docmd_aon,         "AON",                 0x00, 0x00, 0x00, 0x8c,  3, ARG_NONE,   0, NA_T },
     { /* AROT */        docmd_arot,        "AROT",                0x00, 0x00, 0xa6, 0x46,  4, ARG_NONE,   1, 0x01 },
     { /* ASHF */        docmd_ashf,        "ASHF",                0x00, 0x00, 0x00, 0x88,  4, ARG_NONE,   0, NA_T },
-    { /* ASINH */       docmd_asinh,       "ASINH",               0x00, 0x00, 0xa0, 0x64,  5, ARG_NONE,   1, 0x0f },
-    { /* ATANH */       docmd_atanh,       "AT\301NH",            0x00, 0x00, 0xa0, 0x65,  5, ARG_NONE,   1, 0x0f },
+    { /* ASINH */       docmd_asinh,       "ASINH",               0x00, 0x00, 0xa0, 0x64,  5, ARG_NONE,   1, 0x4f },
+    { /* ATANH */       docmd_atanh,       "AT\301NH",            0x00, 0x00, 0xa0, 0x65,  5, ARG_NONE,   1, 0x4f },
     { /* ATOX */        docmd_atox,        "ATOX",                0x00, 0x00, 0xa6, 0x47,  4, ARG_NONE,   0, NA_T },
     { /* BASEADD */     docmd_baseadd,     "BASE+",               0x00, 0x00, 0xa0, 0xe6,  5, ARG_NONE,   2, 0x01 },
     { /* BASESUB */     docmd_basesub,     "BASE-",               0x00, 0x00, 0xa0, 0xe7,  5, ARG_NONE,   2, 0x01 },
@@ -283,14 +283,14 @@ const command_spec cmd_array[] =
     { /* BIT_T */       docmd_bit_t,       "BIT?",                0x00, 0x00, 0xa5, 0x8c,  4, ARG_NONE,   2, 0x01 },
     { /* BST */         NULL,              "BST",                 0x40, 0x00, 0x00, 0x00,  3, ARG_NONE,   0, NA_T },
     { /* CORR */        docmd_corr,        "CORR",                0x00, 0x00, 0xa0, 0xa7,  4, ARG_NONE,   0, NA_T },
-    { /* COSH */        docmd_cosh,        "COSH",                0x00, 0x00, 0xa0, 0x62,  4, ARG_NONE,   1, 0x0f },
+    { /* COSH */        docmd_cosh,        "COSH",                0x00, 0x00, 0xa0, 0x62,  4, ARG_NONE,   1, 0x4f },
     { /* CROSS */       docmd_cross,       "CROSS",               0x00, 0x00, 0xa6, 0xca,  5, ARG_NONE,   2, FUNC },
     { /* CUSTOM */      docmd_custom,      "CUST\317\315",        0x00, 0x00, 0xa2, 0x6f,  6, ARG_NONE,   0, NA_T },
     { /* DECM */        docmd_decm,        "DECM",                0x00, 0x00, 0xa0, 0xe3,  4, ARG_NONE,   0, NA_T },
     { /* DELR */        docmd_delr,        "DELR",                0x00, 0x00, 0xa0, 0xab,  4, ARG_NONE,   0, NA_T },
     { /* DET */         docmd_det,         "DET",                 0x00, 0x00, 0xa6, 0xcc,  3, ARG_NONE,   1, 0x0c },
     { /* DIM */         docmd_dim,         "DIM",                 0x00, 0xc4, 0xf2, 0xec,  3, ARG_MAT,    2, 0x01 },
-    { /* DOT */         docmd_dot,         "DOT",                 0x00, 0x00, 0xa6, 0xcb,  3, ARG_NONE,   2, FUNC },
+    { /* DOT */         docmd_dot,         "DOT",                 0x80, 0x00, 0xa6, 0xcb,  3, ARG_NONE,   2, FUNC },
     { /* EDIT */        docmd_edit,        "EDIT",                0x00, 0x00, 0xa6, 0xe1,  4, ARG_NONE,   1, FUNC },
     { /* EDITN */       docmd_editn,       "EDITN",               0x00, 0xc6, 0xf2, 0xef,  5, ARG_MAT,    0, NA_T },
     { /* EXITALL */     docmd_exitall,     "EXITA\314\314",       0x00, 0x00, 0xa2, 0x6c,  7, ARG_NONE,   0, NA_T },
@@ -328,23 +328,23 @@ const command_spec cmd_array[] =
     { /* PWRF */        docmd_pwrf,        "PWRF",                0x00, 0x00, 0xa0, 0xa3,  4, ARG_NONE,   0, NA_T },
     { /* RCLEL */       docmd_rclel,       "RCLEL",               0x00, 0x00, 0xa6, 0xd7,  5, ARG_NONE,   0, NA_T },
     { /* RCLIJ */       docmd_rclij,       "RCLIJ",               0x00, 0x00, 0xa6, 0xd9,  5, ARG_NONE,   0, NA_T },
-    { /* RNRM */        docmd_rnrm,        "RNRM",                0x00, 0x00, 0xa6, 0xed,  4, ARG_NONE,   1, 0x0c },
+    { /* RNRM */        docmd_rnrm,        "RNRM",                0x80, 0x00, 0xa6, 0xed,  4, ARG_NONE,   1, 0x0c },
     { /* ROTXY */       docmd_rotxy,       "ROTXY",               0x00, 0x00, 0xa5, 0x8b,  5, ARG_NONE,   2, 0x01 },
-    { /* RSUM */        docmd_rsum,        "RSUM",                0x00, 0x00, 0xa6, 0xd0,  4, ARG_NONE,   1, 0x0c },
+    { /* RSUM */        docmd_rsum,        "RSUM",                0x80, 0x00, 0xa6, 0xd0,  4, ARG_NONE,   1, 0x4c },
     { /* SWAP_R */      docmd_swap_r,      "R<>R",                0x00, 0x00, 0xa6, 0xd1,  4, ARG_NONE,   2, FUNC },
     { /* SDEV */        docmd_sdev,        "SDEV",                0x00, 0x00, 0x00, 0x7d,  4, ARG_NONE,   0, NA_T },
-    { /* SINH */        docmd_sinh,        "SINH",                0x00, 0x00, 0xa0, 0x61,  4, ARG_NONE,   1, 0x0f },
+    { /* SINH */        docmd_sinh,        "SINH",                0x00, 0x00, 0xa0, 0x61,  4, ARG_NONE,   1, 0x4f },
     { /* SLOPE */       docmd_slope,       "SLOPE",               0x00, 0x00, 0xa0, 0xa4,  5, ARG_NONE,   0, NA_T },
     { /* SOLVE */       docmd_solve,       "SOLVE",               0x00, 0xb7, 0xf2, 0xeb,  5, ARG_RVAR,   1, FUNC },
     { /* STOEL */       docmd_stoel,       "STOEL",               0x00, 0x00, 0xa6, 0xd6,  5, ARG_NONE,   1, FUNC },
     { /* STOIJ */       docmd_stoij,       "STOIJ",               0x00, 0x00, 0xa6, 0xd8,  5, ARG_NONE,   2, FUNC },
     { /* SUM */         docmd_sum,         "SUM",                 0x00, 0x00, 0xa0, 0xa5,  3, ARG_NONE,   0, NA_T },
-    { /* TANH */        docmd_tanh,        "TANH",                0x00, 0x00, 0xa0, 0x63,  4, ARG_NONE,   1, 0x0f },
-    { /* TRANS */       docmd_trans,       "TRANS",               0x00, 0x00, 0xa6, 0xc9,  5, ARG_NONE,   1, 0x0c },
+    { /* TANH */        docmd_tanh,        "TANH",                0x00, 0x00, 0xa0, 0x63,  4, ARG_NONE,   1, 0x4f },
+    { /* TRANS */       docmd_trans,       "TRANS",               0x80, 0x00, 0xa6, 0xc9,  5, ARG_NONE,   1, 0x0c },
     { /* UVEC */        docmd_uvec,        "UVEC",                0x00, 0x00, 0xa6, 0xcd,  4, ARG_NONE,   1, 0x06 },
     { /* WMEAN */       docmd_wmean,       "WM\305\301N",         0x00, 0x00, 0xa0, 0xac,  5, ARG_NONE,   0, NA_T },
     { /* WRAP */        docmd_wrap,        "WRAP",                0x00, 0x00, 0xa6, 0xe2,  4, ARG_NONE,   0, NA_T },
-    { /* X_SWAP */      docmd_x_swap,      "X<>",                 0x00, 0x86, 0x00, 0xce,  3, ARG_VAR,    1, ALLT },
+    { /* X_SWAP */      docmd_x_swap,      "X<>",                 0x80, 0x86, 0x00, 0xce,  3, ARG_VAR,    1, ALLT },
     { /* XOR */         docmd_xor,         "XOR",                 0x00, 0x00, 0xa5, 0x8a,  3, ARG_NONE,   2, 0x01 },
     { /* YINT */        docmd_yint,        "YINT",                0x00, 0x00, 0xa0, 0xa6,  4, ARG_NONE,   0, NA_T },
     { /* TO_DEC */      docmd_to_dec,      "\17DEC",              0x00, 0x00, 0x00, 0x5f,  4, ARG_NONE,   1, 0x01 },
@@ -396,7 +396,7 @@ const command_spec cmd_array[] =
     { /* FPTEST */      docmd_fptest,      "FPT\305ST",           0x00, 0x00, 0xa7, 0xd2,  6, ARG_NONE,   0, NA_T },
 
     /* Programming */
-    { /* LSTO */        docmd_lsto,        "LSTO",                0x00, 0xc7, 0xf2, 0xed,  4, ARG_NAMED,  1, ALLT },
+    { /* LSTO */        docmd_lsto,        "LSTO",                0x80, 0xc7, 0xf2, 0xed,  4, ARG_NAMED,  1, ALLT },
     { /* SST_UP */      NULL,              "SST^",                0x40, 0x00, 0x00, 0x00,  4, ARG_NONE,   0, NA_T },
     { /* SST_RT */      NULL,              "SST\17",              0x40, 0x00, 0x00, 0x00,  4, ARG_NONE,   0, NA_T },
     { /* YMD */         docmd_ymd,         "YMD",                 0x00, 0x00, 0xa7, 0xd5,  3, ARG_NONE,   0, NA_T },
@@ -475,9 +475,9 @@ const command_spec cmd_array[] =
     { /* NSTK */        docmd_nstk,        "NSTK",                0x00, 0x00, 0xa7, 0xe4,  4, ARG_NONE,   0, NA_T },
     { /* LNSTK */       docmd_lnstk,       "LNSTK",               0x00, 0x00, 0xa7, 0xe5,  5, ARG_NONE,   0, NA_T },
     { /* DEPTH */       docmd_depth,       "DEPTH",               0x00, 0x00, 0xa7, 0xe6,  5, ARG_NONE,   0, NA_T },
-    { /* DROP */        docmd_drop,        "DROP",                0x00, 0x00, 0xa2, 0x71,  4, ARG_NONE,   1, ALLT },
+    { /* DROP */        docmd_drop,        "DROP",                0x80, 0x00, 0xa2, 0x71,  4, ARG_NONE,   1, ALLT },
     { /* DROPN */       docmd_dropn,       "DR\317PN",            0x00, 0xf1, 0xf2, 0xa1,  5, ARG_NUM9,   0, NA_T },
-    { /* DUP */         docmd_dup,         "DUP",                 0x00, 0x00, 0xa7, 0xe7,  3, ARG_NONE,   1, ALLT },
+    { /* DUP */         docmd_dup,         "DUP",                 0x80, 0x00, 0xa7, 0xe7,  3, ARG_NONE,   1, ALLT },
     { /* DUPN */        docmd_dupn,        "DUPN",                0x00, 0xf2, 0xf2, 0xa2,  4, ARG_NUM9,   0, NA_T },
     { /* PICK */        docmd_pick,        "PICK",                0x00, 0xf3, 0xf2, 0xa3,  4, ARG_NUM9,   0, NA_T },
     { /* UNPICK */      docmd_unpick,      "UNPICK",              0x00, 0xf4, 0xf2, 0xa4,  6, ARG_NUM9,   0, NA_T },
@@ -507,8 +507,8 @@ const command_spec cmd_array[] =
     { /* DROP_CANCL */  docmd_drop_cancl,  "DROP",                0x04, 0x00, 0x00, 0x00,  4, ARG_NONE,   1, ALLT },
     { /* PRREG */       docmd_prreg,       "PRR\305G",            0x00, 0x00, 0xa7, 0x50,  5, ARG_NONE,   0, NA_T },
     { /* CSLD_T */      docmd_csld_t,      "CSLD?",               0x00, 0x00, 0xa7, 0xdb,  5, ARG_NONE,   0, NA_T },
-    { /* C_LN_1_X */    docmd_c_ln_1_x,    "C.LN1+X",             0x00, 0x00, 0xa6, 0xfe,  7, ARG_NONE,   0, 0x0f },
-    { /* C_E_POW_X_1 */ docmd_c_e_pow_x_1, "C.E^X-1",             0x00, 0x00, 0xa6, 0xff,  7, ARG_NONE,   0, 0x0f },
+    { /* C_LN_1_X */    docmd_c_ln_1_x,    "C.LN1+X",             0x00, 0x00, 0xa6, 0xfe,  7, ARG_NONE,   0, 0x4f },
+    { /* C_E_POW_X_1 */ docmd_c_e_pow_x_1, "C.E^X-1",             0x00, 0x00, 0xa6, 0xff,  7, ARG_NONE,   0, 0x4f },
     { /* GETMI */       docmd_getmi,       "G\305TMI",            0x00, 0x72, 0xf2, 0x65,  5, ARG_M_STK,  2, 0x01 },
     { /* PUTMI */       docmd_putmi,       "PUTMI",               0x00, 0x73, 0xf2, 0x66,  5, ARG_M_STK,  3, 0x13 },
     { /* GETLI */       docmd_getli,       "GETLI",               0x00, 0x74, 0xf2, 0x67,  5, ARG_L_STK,  1, 0x01 },
@@ -525,7 +525,7 @@ const command_spec cmd_array[] =
     { /* APPEND */      docmd_append,      "APPEND",              0x00, 0x00, 0xa7, 0xe9,  6, ARG_NONE,   2, ALLT },
     { /* EXTEND */      docmd_extend,      "EXTEND",              0x00, 0x00, 0xa7, 0xea,  6, ARG_NONE,   2, ALLT },
     { /* SUBSTR */      docmd_substr,      "SUBSTR",              0x00, 0x00, 0xa7, 0xeb,  6, ARG_NONE,   2, FUNC },
-    { /* LENGTH */      docmd_length,      "LENGTH",              0x00, 0x00, 0xa7, 0xec,  6, ARG_NONE,   1, 0x30 },
+    { /* LENGTH */      docmd_length,      "LENGTH",              0x00, 0x00, 0xa7, 0xec,  6, ARG_NONE,   1, 0xb0 },
     { /* HEAD */        docmd_head,        "HEAD",                0x00, 0x03, 0xf2, 0x13,  4, ARG_VAR,    0, NA_T },
     { /* REV */         docmd_rev,         "REV",                 0x00, 0x00, 0xa7, 0xed,  3, ARG_NONE,   1, 0x30 },
     { /* POS */         docmd_pos,         "POS",                 0x00, 0x00, 0xa7, 0xee,  3, ARG_NONE,   2, FUNC },
@@ -534,7 +534,7 @@ const command_spec cmd_array[] =
     { /* NN_TO_S */     docmd_nn_to_s,     "NN\17S",              0x00, 0x00, 0xa7, 0x1d,  4, ARG_NONE,   1, ALLT },
     { /* C_TO_N */      docmd_c_to_n,      "C\17N",               0x00, 0x00, 0xa7, 0xf1,  3, ARG_NONE,   1, 0x10 },
     { /* N_TO_C */      docmd_n_to_c,      "N\17C",               0x00, 0x00, 0xa7, 0xf2,  3, ARG_NONE,   1, 0x01 },
-    { /* LIST_T */      docmd_list_t,      "LIST?",               0x00, 0x00, 0xa7, 0xf3,  5, ARG_NONE,   1, ALLT },
+    { /* LIST_T */      docmd_list_t,      "LIST?",               0x80, 0x00, 0xa7, 0xf3,  5, ARG_NONE,   1, ALLT },
     { /* NEWLIST */     docmd_newlist,     "NEWLIST",             0x00, 0x00, 0xa7, 0xf4,  7, ARG_NONE,   0, NA_T },
     { /* TO_LIST */     docmd_to_list,     "\17LIST",             0x00, 0x00, 0xa6, 0xfc,  5, ARG_NONE,   1, 0x01 },
     { /* FROM_LIST */   docmd_from_list,   "LIST\17",             0x00, 0x00, 0xa6, 0xfd,  5, ARG_NONE,   1, 0x20 },
@@ -556,6 +556,32 @@ const command_spec cmd_array[] =
     /* For Plus42 Compatibility */
     { /* WIDTH */       docmd_width,       "WIDTH",               0x00, 0x00, 0xa2, 0x72,  5, ARG_NONE,   0, NA_T },
     { /* HEIGHT */      docmd_height,      "HEIGHT",              0x00, 0x00, 0xa2, 0x73,  6, ARG_NONE,   0, NA_T },
+
+    /* Sparse matrices */
+    { /* NEWSPM */      docmd_newspm,      "NEWSPM",              0x00, 0x00, 0xa7, 0x76,  6, ARG_NONE,   2, 0x01 },
+    { /* SPARSE */      docmd_sparse,      "SPARSE",              0x80, 0x00, 0xa7, 0x77,  6, ARG_NONE,   1, 0x04 },
+    { /* DENSE */       docmd_dense,       "DENSE",               0x00, 0x00, 0xa7, 0x78,  5, ARG_NONE,   1, 0x40 },
+    { /* CG */          docmd_cg,          "CG",                  0x00, 0x00, 0xa7, 0x79,  2, ARG_NONE,   4, 0x45 },
+    { /* BICGSTB */     docmd_bicgstb,     "BICGSTB",             0x00, 0x00, 0xa7, 0x7a,  7, ARG_NONE,   4, 0x45 },
+    { /* NEWMAP */      docmd_newmap,      "NEWMAP",              0x00, 0x00, 0xa7, 0x7b,  6, ARG_NONE,   0, NA_T },
+    { /* MPUT */        docmd_mput,        "MPUT",                0x00, 0x50, 0xf2, 0x69,  4, ARG_L_STK,  2, ALLT },
+    { /* MGET */        docmd_mget,        "MGET",                0x00, 0x51, 0xf2, 0x6a,  4, ARG_L_STK,  1, 0x11 },
+    { /* MDEL */        docmd_mdel,        "MDEL",                0x00, 0x52, 0xf2, 0x6b,  4, ARG_L_STK,  1, 0x11 },
+    { /* MKEY_T */      docmd_mkey_t,      "MKEY?",               0x00, 0x53, 0xf2, 0x6c,  5, ARG_L_STK,  1, 0x11 },
+    { /* MKEYS */       docmd_mkeys,       "MKEYS",               0x00, 0x00, 0xa7, 0x7c,  5, ARG_NONE,   1, 0x80 },
+    { /* SORT */        docmd_sort,        "SORT",                0x00, 0x00, 0xa7, 0x7d,  4, ARG_NONE,   1, 0x25 },
+    { /* RSORT */       docmd_rsort,       "RSORT",               0x00, 0x00, 0xa7, 0x7e,  5, ARG_NONE,   1, 0x25 },
+    { /* BSRCH */       docmd_bsrch,       "BSRCH",               0x00, 0x54, 0xf2, 0x6d,  5, ARG_M_STK,  1, ALLT },
+    { /* BRACKET */     docmd_bracket,     "BRACKET",             0x00, 0x55, 0xf2, 0x6e,  7, ARG_M_STK,  1, ALLT },
+    { /* INTERP */      docmd_interp,      "INTERP",              0x00, 0x56, 0xf2, 0x6f,  6, ARG_M_STK,  1, 0x01 },
+    { /* LSQ */         docmd_lsq,         "LSQ",                 0x00, 0x00, 0xa7, 0x7f,  3, ARG_NONE,   2, 0x04 },
+    { /* FFT */         docmd_fft,         "FFT",                 0x00, 0x00, 0xa7, 0x80,  3, ARG_NONE,   1, 0x0c },
+    { /* IFFT */        docmd_ifft,        "IFFT",                0x00, 0x00, 0xa7, 0x81,  4, ARG_NONE,   1, 0x0c },
+    { /* EIGEN */       docmd_eigen,       "EIGEN",               0x00, 0x00, 0xa7, 0x82,  5, ARG_NONE,   1, 0x0c },
+    { /* EIGENV */      docmd_eigenv,      "EIGENV",              0x00, 0x00, 0xa7, 0x83,  6, ARG_NONE,   1, 0x0c },
+    { /* PEVAL */       docmd_peval,       "PEVAL",               0x00, 0x00, 0xa7, 0x84,  5, ARG_NONE,   2, 0x0f },
+    { /* PROOT */       docmd_proot,       "PROOT",               0x00, 0x00, 0xa7, 0x85,  5, ARG_NONE,   1, 0x0c },
+    { /* ODE */         docmd_ode,         "ODE",                 0x00, 0x57, 0xf2, 0x70,  3, ARG_PRGM,   3, 0x05 },
 };
 
 /*
@@ -947,5 +973,13 @@ int handle(int cmd, arg_struct *arg) {
                     return ERR_INVALID_TYPE;
         }
     }
+    if ((cs->flags & FLAG_VIEWS) == 0) {
+        // Most functions access matrix elements directly, so any views
+        // among the arguments are turned into ordinary matrices first.
+        int argcount = cs->argcount == -1 ? 2 : cs->argcount;
+        for (int i = 0; i < argcount && i <= sp; i++)
+            if (is_matrix_view(stack[sp - i]) && !disentangle(stack[sp - i]))
+                return ERR_INSUFFICIENT_MEMORY;
+    }
     return cs->handler(arg);
 }
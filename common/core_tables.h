@@ -522,8 +522,41 @@
 /* For Plus42 compatibility */
 #define CMD_WIDTH       473
 #define CMD_HEIGHT      474
+/* Sparse matrices */
+#define CMD_NEWSPM      475
+#define CMD_SPARSE      476
+#define CMD_DENSE       477
+#define CMD_CG          478
+#define CMD_BICGSTB     479
+/* Associative maps */
+#define CMD_NEWMAP      480
+#define CMD_MPUT        481
+#define CMD_MGET        482
+#define CMD_MDEL        483
+#define CMD_MKEY_T      484
+#define CMD_MKEYS       485
+/* Sorting */
+#define CMD_SORT        486
+#define CMD_RSORT       487
+/* Table lookup */
+#define CMD_BSRCH       488
+#define CMD_BRACKET     489
+#define CMD_INTERP      490
+/* Least squares */
+#define CMD_LSQ         491
+/* Fourier transform */
+#define CMD_FFT         492
+#define CMD_IFFT        493
+/* Eigenvalues */
+#define CMD_EIGEN       494
+#define CMD_EIGENV      495
+/* Polynomials */
+#define CMD_PEVAL       496
+#define CMD_PROOT       497
+/* Differential equations */
+#define CMD_ODE         498
 
-#define CMD_SENTINEL    475
+#define CMD_SENTINEL    499
 
 
 /* command_spec.argtype */
@@ -543,8 +576,8 @@
 #define ARG_PRGM     12 /* Alpha label (CATSECT_PGM) */
 #define ARG_RVAR     13 /* Variable (real only) (MVAR, INTEG, SOLVE) */
 #define ARG_MAT      14 /* Variable (matrix only) (EDITN, INDEX) */
-#define ARG_M_STK    15 /* Matrix variable or stack (GETMI, PUTMI) */
-#define ARG_L_STK    16 /* List variable or stack (GETLI, PUTLI) */
+#define ARG_M_STK    15 /* Matrix variable or stack (GETMI, PUTMI, BSRCH) */
+#define ARG_L_STK    16 /* List or map variable or stack (GETLI, PUTLI, MGET, MPUT) */
 #define ARG_XSTR     17 /* Long string (XSTR) */
 #define ARG_OTHER    18 /* Weirdos */
 
@@ -558,6 +591,7 @@
 #define FLAG_NO_SHOW  16  /* Do not show after keytimeout1 */
 #define FLAG_SPECIAL  32  /* hp42s_code flags 0x01 */
 #define FLAG_ILLEGAL  64  /* hp42s_code flags 0x02 */
+#define FLAG_VIEWS   128  /* Accepts matrix views as arguments (TRANS, ...) */
 
 
 /* Builtin cmd arg types */
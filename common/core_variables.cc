@@ -24,41 +24,168 @@
 #include "core_variables.h"
 
 
-// We cache vartype_real, vartype_complex, and vartype_string instances, to
-// cut down on the malloc/free overhead.
+// vartype_real, vartype_complex, vartype_string, and vartype_list instances
+// are allocated from slabs of VARTYPE_SLAB_SIZE objects, and freed objects
+// go onto a per-type free list, to cut down on the malloc/free overhead.
+// Slabs are only returned to the system by clean_vartype_pools(), and only
+// once all of their objects have been freed.
 
-#define POOLSIZE 10
-static vartype_real *realpool[POOLSIZE];
-static vartype_complex *complexpool[POOLSIZE];
-static vartype_string *stringpool[POOLSIZE];
-static int realpool_size = 0;
-static int complexpool_size = 0;
-static int stringpool_size = 0;
+#ifndef VARTYPE_SLAB_SIZE
+#define VARTYPE_SLAB_SIZE 64
+#endif
 
-vartype *new_real(phloat value) {
-    vartype_real *r;
-    if (realpool_size > 0) {
-        r = realpool[--realpool_size];
-    } else {
-        r = (vartype_real *) malloc(sizeof(vartype_real));
-        if (r == NULL)
+struct slab_struct {
+    slab_struct *next;
+};
+
+struct slab_pool {
+    size_t objsize;
+    void *freelist;
+    slab_struct *slabs;
+    vartype_pool_stats stats;
+};
+
+// Objects are rounded up to 16 bytes, so they are aligned as strictly as
+// malloc() would align them.
+#define SLAB_ROUND(n) (((n) + 15) & ~(size_t) 15)
+#define SLAB_HEADER SLAB_ROUND(sizeof(slab_struct))
+
+static slab_pool realpool = { SLAB_ROUND(sizeof(vartype_real)) };
+static slab_pool complexpool = { SLAB_ROUND(sizeof(vartype_complex)) };
+static slab_pool stringpool = { SLAB_ROUND(sizeof(vartype_string)) };
+static slab_pool listpool = { SLAB_ROUND(sizeof(vartype_list)) };
+
+static void *pool_alloc(slab_pool *pool) {
+    if (pool->freelist == NULL) {
+        slab_struct *slab = (slab_struct *)
+                malloc(SLAB_HEADER + VARTYPE_SLAB_SIZE * pool->objsize);
+        if (slab == NULL)
             return NULL;
-        r->type = TYPE_REAL;
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        char *objs = (char *) slab + SLAB_HEADER;
+        for (int i = VARTYPE_SLAB_SIZE - 1; i >= 0; i--) {
+            void **obj = (void **) (objs + i * pool->objsize);
+            *obj = pool->freelist;
+            pool->freelist = obj;
+        }
+        pool->stats.slabs++;
+        pool->stats.free += VARTYPE_SLAB_SIZE;
     }
+    void **obj = (void **) pool->freelist;
+    pool->freelist = *obj;
+    pool->stats.free--;
+    pool->stats.in_use++;
+    pool->stats.allocs++;
+    return obj;
+}
+
+static void pool_free(slab_pool *pool, void *obj) {
+    *(void **) obj = pool->freelist;
+    pool->freelist = obj;
+    pool->stats.free++;
+    pool->stats.in_use--;
+}
+
+static int slab_compar(const void *a, const void *b) {
+    const char *sa = *(const char **) a;
+    const char *sb = *(const char **) b;
+    return sa < sb ? -1 : sa > sb ? 1 : 0;
+}
+
+/* Frees the slabs that have no objects in use. With objects still in use,
+ * this needs to find out which slab each free object belongs to; if the
+ * memory for that isn't available, it just leaves everything alone.
+ */
+static void pool_clean(slab_pool *pool) {
+    slab_struct *slab, *next;
+    if (pool->stats.in_use == 0) {
+        for (slab = pool->slabs; slab != NULL; slab = next) {
+            next = slab->next;
+            free(slab);
+        }
+        pool->slabs = NULL;
+        pool->freelist = NULL;
+        pool->stats.slabs = 0;
+        pool->stats.free = 0;
+        return;
+    }
+    int n = pool->stats.slabs;
+    char **slabs = (char **) malloc(n * sizeof(char *));
+    int *nfree = (int *) malloc(n * sizeof(int));
+    if (slabs == NULL || nfree == NULL) {
+        free(slabs);
+        free(nfree);
+        return;
+    }
+    int i = 0;
+    for (slab = pool->slabs; slab != NULL; slab = slab->next)
+        slabs[i++] = (char *) slab;
+    qsort(slabs, n, sizeof(char *), slab_compar);
+    memset(nfree, 0, n * sizeof(int));
+    // Find the slab containing obj: the last one starting below it
+    #define SLAB_OF(obj) do { \
+        int lo = 0, hi = n - 1; \
+        while (lo < hi) { \
+            int mid = (lo + hi + 1) / 2; \
+            if (slabs[mid] < (char *) (obj)) lo = mid; else hi = mid - 1; \
+        } \
+        i = lo; \
+    } while (0)
+    for (void *obj = pool->freelist; obj != NULL; obj = *(void **) obj) {
+        SLAB_OF(obj);
+        nfree[i]++;
+    }
+    void **tail = &pool->freelist;
+    for (void *obj = pool->freelist; obj != NULL; obj = *(void **) obj) {
+        SLAB_OF(obj);
+        if (nfree[i] != VARTYPE_SLAB_SIZE) {
+            *tail = obj;
+            tail = (void **) obj;
+        }
+    }
+    *tail = NULL;
+    #undef SLAB_OF
+    pool->slabs = NULL;
+    for (i = 0; i < n; i++) {
+        slab = (slab_struct *) slabs[i];
+        if (nfree[i] == VARTYPE_SLAB_SIZE) {
+            free(slab);
+            pool->stats.slabs--;
+            pool->stats.free -= VARTYPE_SLAB_SIZE;
+        } else {
+            slab->next = pool->slabs;
+            pool->slabs = slab;
+        }
+    }
+    free(slabs);
+    free(nfree);
+}
+
+bool get_vartype_pool_stats(int type, vartype_pool_stats *stats) {
+    switch (type) {
+        case TYPE_REAL: *stats = realpool.stats; return true;
+        case TYPE_COMPLEX: *stats = complexpool.stats; return true;
+        case TYPE_STRING: *stats = stringpool.stats; return true;
+        case TYPE_LIST: *stats = listpool.stats; return true;
+        default: return false;
+    }
+}
+
+vartype *new_real(phloat value) {
+    vartype_real *r = (vartype_real *) pool_alloc(&realpool);
+    if (r == NULL)
+        return NULL;
+    r->type = TYPE_REAL;
     r->x = value;
     return (vartype *) r;
 }
 
 vartype *new_complex(phloat re, phloat im) {
-    vartype_complex *c;
-    if (complexpool_size > 0) {
-        c = complexpool[--complexpool_size];
-    } else {
-        c = (vartype_complex *) malloc(sizeof(vartype_complex));
-        if (c == NULL)
-            return NULL;
-        c->type = TYPE_COMPLEX;
-    }
+    vartype_complex *c = (vartype_complex *) pool_alloc(&complexpool);
+    if (c == NULL)
+        return NULL;
+    c->type = TYPE_COMPLEX;
     c->re = re;
     c->im = im;
     return (vartype *) c;
@@ -67,22 +194,17 @@ vartype *new_complex(phloat re, phloat im) {
 vartype *new_string(const char *text, int length) {
     char *dbuf;
     if (length > SSLENV) {
-        dbuf = (char *) malloc(length);
+        dbuf = new_string_text(length);
         if (dbuf == NULL)
             return NULL;
     }
-    vartype_string *s;
-    if (stringpool_size > 0) {
-        s = stringpool[--stringpool_size];
-    } else {
-        s = (vartype_string *) malloc(sizeof(vartype_string));
-        if (s == NULL) {
-            if (length > SSLENV)
-                free(dbuf);
-            return NULL;
-        }
-        s->type = TYPE_STRING;
+    vartype_string *s = (vartype_string *) pool_alloc(&stringpool);
+    if (s == NULL) {
+        if (length > SSLENV)
+            free_string_text(dbuf);
+        return NULL;
     }
+    s->type = TYPE_STRING;
     s->length = length;
     if (length > SSLENV)
         s->t.ptr = dbuf;
@@ -91,6 +213,54 @@ vartype *new_string(const char *text, int length) {
     return (vartype *) s;
 }
 
+char *new_string_text(int4 capacity) {
+    string_data *sd = (string_data *) malloc(sizeof(string_data) + capacity);
+    if (sd == NULL)
+        return NULL;
+    sd->refcount = 1;
+    sd->capacity = capacity;
+    return (char *) (sd + 1);
+}
+
+void free_string_text(char *ptr) {
+    string_data *sd = STRING_DATA(ptr);
+    if (--(sd->refcount) == 0)
+        free(sd);
+}
+
+/* Makes sure the long string s has room for at least 'length' characters,
+ * growing its buffer geometrically so that a string built up by repeated
+ * appends is copied O(log n) times rather than once per append. A shared
+ * buffer is replaced by a private copy. The text and length are left
+ * unchanged, also when the allocation fails.
+ */
+bool reserve_string(vartype_string *s, int4 length) {
+    string_data *sd = STRING_DATA(s->t.ptr);
+    if (length <= sd->capacity && sd->refcount == 1)
+        return true;
+    int4 cap = sd->capacity;
+    if (length > cap) {
+        cap = cap < 0x3fffffff ? cap * 2 : 0x7fffffff;
+        if (cap < length)
+            cap = length;
+    }
+    if (sd->refcount == 1) {
+        sd = (string_data *) realloc(sd, sizeof(string_data) + cap);
+        if (sd == NULL)
+            return false;
+        sd->capacity = cap;
+        s->t.ptr = (char *) (sd + 1);
+    } else {
+        char *text = new_string_text(cap);
+        if (text == NULL)
+            return false;
+        memcpy(text, s->t.ptr, s->length);
+        sd->refcount--;
+        s->t.ptr = text;
+    }
+    return true;
+}
+
 vartype *new_realmatrix(int4 rows, int4 columns) {
     double d_bytes = ((double) rows) * ((double) columns) * sizeof(phloat);
     if (((double) (int4) d_bytes) != d_bytes)
@@ -105,31 +275,135 @@ vartype *new_realmatrix(int4 rows, int4 columns) {
     rm->rows = rows;
     rm->columns = columns;
     sz = rows * columns;
-    rm->array = (realmatrix_data *) malloc(sizeof(realmatrix_data));
+    rm->array = new_realmatrix_data(sz);
     if (rm->array == NULL) {
         free(rm);
         return NULL;
     }
-    rm->array->data = (phloat *) malloc(sz * sizeof(phloat));
-    if (rm->array->data == NULL) {
-        free(rm->array);
-        free(rm);
-        return NULL;
-    }
-    rm->array->is_string = (char *) malloc(sz);
-    if (rm->array->is_string == NULL) {
-        free(rm->array->data);
-        free(rm->array);
-        free(rm);
-        return NULL;
-    }
     for (i = 0; i < sz; i++)
         rm->array->data[i] = 0;
-    memset(rm->array->is_string, 0, sz);
-    rm->array->refcount = 1;
+    rm->offset = rm->rowstride = rm->colstride = 0;
     return (vartype *) rm;
 }
 
+/* Offset of the elements from the start of the block, rounded up so the
+ * elements are aligned at least as strictly as malloc() would align them.
+ */
+#define RMD_HEADER ((sizeof(realmatrix_data) + 15) & ~(size_t) 15)
+
+realmatrix_data *new_realmatrix_data(int4 size) {
+    realmatrix_data *md = (realmatrix_data *)
+                            malloc(RMD_HEADER + size * sizeof(phloat));
+    if (md == NULL)
+        return NULL;
+    md->refcount = 1;
+    md->size = size;
+    md->capacity = size;
+    md->nstrings = 0;
+    md->hash = 0;
+    md->data = (phloat *) ((char *) md + RMD_HEADER);
+    md->is_string = NULL;
+    return md;
+}
+
+/* Changes the element count of an unshared array. Elements beyond the old
+ * size are set to zero; strings beyond the new size are freed. Returns the
+ * (possibly moved) array, or NULL if memory runs out, in which case the
+ * original is left untouched.
+ * The array keeps spare capacity, growing geometrically and only giving
+ * memory back once it is less than a quarter full, so that adding or
+ * removing rows one at a time, as INSR, DELR, and the matrix editor in
+ * GROW mode do, takes amortized constant time per element.
+ */
+realmatrix_data *resize_realmatrix_data(realmatrix_data *md, int4 size) {
+    int4 oldsize = md->size;
+    if (size < oldsize) {
+        if (md->is_string != NULL) {
+            for (int4 i = size; i < oldsize; i++)
+                if (md->is_string[i] != 0)
+                    md->nstrings--;
+            free_long_strings(md->is_string + size, md->data + size, oldsize - size);
+        }
+        md->size = size;
+        if (size >= md->capacity / 4)
+            return md;
+        /* realloc() can fail even when shrinking, but that is easy to
+         * handle by simply hanging onto the existing block.
+         */
+        if (md->is_string != NULL) {
+            char *new_is_string = (char *) realloc(md->is_string, size);
+            if (new_is_string == NULL)
+                return md;
+            md->is_string = new_is_string;
+        }
+        realmatrix_data *new_md = (realmatrix_data *)
+                        realloc(md, RMD_HEADER + size * sizeof(phloat));
+        if (new_md == NULL) {
+            // The string map is smaller now, so the capacity has to match it
+            if (md->is_string != NULL)
+                md->capacity = size;
+            return md;
+        }
+        new_md->data = (phloat *) ((char *) new_md + RMD_HEADER);
+        new_md->capacity = size;
+        return new_md;
+    }
+    if (size > md->capacity) {
+        int4 cap = md->capacity < 4 ? 4
+                : md->capacity < 0x0fffffff ? md->capacity * 2 : size;
+        if (cap < size)
+            cap = size;
+        /* Allocate the new string map before the realloc(), so that we never
+         * have to roll back the realloc() if the map can't be allocated.
+         */
+        char *new_is_string = NULL;
+        if (md->is_string != NULL) {
+            new_is_string = (char *) malloc(cap);
+            if (new_is_string == NULL)
+                return NULL;
+        }
+        realmatrix_data *new_md = (realmatrix_data *)
+                        realloc(md, RMD_HEADER + cap * sizeof(phloat));
+        if (new_md == NULL) {
+            free(new_is_string);
+            return NULL;
+        }
+        new_md->data = (phloat *) ((char *) new_md + RMD_HEADER);
+        if (new_is_string != NULL) {
+            memcpy(new_is_string, new_md->is_string, oldsize);
+            free(new_md->is_string);
+            new_md->is_string = new_is_string;
+        }
+        new_md->capacity = cap;
+        md = new_md;
+    }
+    for (int4 i = oldsize; i < size; i++)
+        md->data[i] = 0;
+    if (md->is_string != NULL)
+        memset(md->is_string + oldsize, 0, size - oldsize);
+    md->size = size;
+    return md;
+}
+
+void free_realmatrix_data(realmatrix_data *md) {
+    if (md->is_string != NULL) {
+        free_long_strings(md->is_string, md->data, md->size);
+        free(md->is_string);
+    }
+    free(md);
+}
+
+/* Makes sure md has a string map, so is_string can be written directly. */
+bool alloc_string_map(realmatrix_data *md) {
+    if (md->is_string != NULL)
+        return true;
+    md->is_string = (char *) malloc(md->capacity);
+    if (md->is_string == NULL)
+        return false;
+    memset(md->is_string, 0, md->capacity);
+    return true;
+}
+
 vartype *new_complexmatrix(int4 rows, int4 columns) {
     double d_bytes = ((double) rows) * ((double) columns) * sizeof(phloat) * 2;
     if (((double) (int4) d_bytes) != d_bytes)
@@ -158,68 +432,147 @@ vartype *new_complexmatrix(int4 rows, int4 columns) {
     for (i = 0; i < sz; i++)
         cm->array->data[i] = 0;
     cm->array->refcount = 1;
+    cm->offset = cm->rowstride = cm->colstride = 0;
     return (vartype *) cm;
 }
 
 vartype *new_list(int4 size) {
-    vartype_list *list = (vartype_list *) malloc(sizeof(vartype_list));
+    vartype_list *list = (vartype_list *) pool_alloc(&listpool);
     if (list == NULL)
         return NULL;
     list->type = TYPE_LIST;
     list->size = size;
     list->array = (list_data *) malloc(sizeof(list_data));
     if (list->array == NULL) {
-        free(list);
+        pool_free(&listpool, list);
         return NULL;
     }
     list->array->data = (vartype **) malloc(size * sizeof(vartype *));
     if (list->array->data == NULL && size != 0) {
         free(list->array);
-        free(list);
+        pool_free(&listpool, list);
         return NULL;
     }
     memset(list->array->data, 0, size * sizeof(vartype *));
     list->array->refcount = 1;
+    list->array->capacity = size;
+    list->array->hash = 0;
     return (vartype *) list;
 }
 
+/* Makes sure the list, which must not be shared, has room for at least
+ * 'size' elements, growing its array geometrically so that adding elements
+ * one at a time takes amortized constant time. The list's size and contents
+ * are left unchanged, also when the allocation fails.
+ */
+bool reserve_list(vartype_list *list, int4 size) {
+    list_data *ld = list->array;
+    if (size <= ld->capacity)
+        return true;
+    int4 cap = ld->capacity < 4 ? 4
+            : ld->capacity < 0x0fffffff ? ld->capacity * 2 : size;
+    if (cap < size)
+        cap = size;
+    vartype **new_data = (vartype **) realloc(ld->data, cap * sizeof(vartype *));
+    if (new_data == NULL)
+        return false;
+    ld->data = new_data;
+    ld->capacity = cap;
+    return true;
+}
+
+vartype *new_sparsematrix(int4 rows, int4 columns, int4 capacity) {
+    double d_bytes = ((double) rows + 1) * sizeof(int4);
+    if (((double) (int4) d_bytes) != d_bytes)
+        return NULL;
+    if (capacity < 1)
+        capacity = 1;
+
+    vartype_sparsematrix *sm = (vartype_sparsematrix *)
+                                        malloc(sizeof(vartype_sparsematrix));
+    if (sm == NULL)
+        return NULL;
+    sm->type = TYPE_SPARSEMATRIX;
+    sm->rows = rows;
+    sm->columns = columns;
+    sm->array = (sparsematrix_data *) malloc(sizeof(sparsematrix_data));
+    if (sm->array == NULL) {
+        free(sm);
+        return NULL;
+    }
+    sm->array->rowptr = (int4 *) malloc((rows + 1) * sizeof(int4));
+    sm->array->colidx = (int4 *) malloc(capacity * sizeof(int4));
+    sm->array->values = (phloat *) malloc(capacity * sizeof(phloat));
+    if (sm->array->rowptr == NULL || sm->array->colidx == NULL
+            || sm->array->values == NULL) {
+        free(sm->array->rowptr);
+        free(sm->array->colidx);
+        free(sm->array->values);
+        free(sm->array);
+        free(sm);
+        return NULL;
+    }
+    memset(sm->array->rowptr, 0, (rows + 1) * sizeof(int4));
+    sm->array->capacity = capacity;
+    sm->array->refcount = 1;
+    return (vartype *) sm;
+}
+
+vartype *new_map(int4 size) {
+    int4 capacity = 8;
+    while (capacity < size * 2) {
+        if (capacity > 0x3fffffff / (int4) sizeof(vartype *))
+            return NULL;
+        capacity <<= 1;
+    }
+    vartype_map *map = (vartype_map *) malloc(sizeof(vartype_map));
+    if (map == NULL)
+        return NULL;
+    map->type = TYPE_MAP;
+    map->array = (map_data *) malloc(sizeof(map_data));
+    if (map->array == NULL) {
+        free(map);
+        return NULL;
+    }
+    map->array->keys = (vartype **) malloc(capacity * sizeof(vartype *));
+    map->array->values = (vartype **) malloc(capacity * sizeof(vartype *));
+    if (map->array->keys == NULL || map->array->values == NULL) {
+        free(map->array->keys);
+        free(map->array->values);
+        free(map->array);
+        free(map);
+        return NULL;
+    }
+    memset(map->array->keys, 0, capacity * sizeof(vartype *));
+    map->array->refcount = 1;
+    map->array->size = 0;
+    map->array->capacity = capacity;
+    return (vartype *) map;
+}
+
 void free_vartype(vartype *v) {
     if (v == NULL)
         return;
     switch (v->type) {
         case TYPE_REAL: {
-            if (realpool_size < POOLSIZE)
-                realpool[realpool_size++] = (vartype_real *) v;
-            else
-                free(v);
+            pool_free(&realpool, v);
             break;
         }
         case TYPE_COMPLEX: {
-            if (complexpool_size < POOLSIZE)
-                complexpool[complexpool_size++] = (vartype_complex *) v;
-            else
-                free(v);
+            pool_free(&complexpool, v);
             break;
         }
         case TYPE_STRING: {
             vartype_string *s = (vartype_string *) v;
             if (s->length > SSLENV)
-                free(s->t.ptr);
-            if (stringpool_size < POOLSIZE)
-                stringpool[stringpool_size++] = s;
-            else
-                free(s);
+                free_string_text(s->t.ptr);
+            pool_free(&stringpool, s);
             break;
         }
         case TYPE_REALMATRIX: {
             vartype_realmatrix *rm = (vartype_realmatrix *) v;
-            if (--(rm->array->refcount) == 0) {
-                int4 sz = rm->rows * rm->columns;
-                free_long_strings(rm->array->is_string, rm->array->data, sz);
-                free(rm->array->data);
-                free(rm->array->is_string);
-                free(rm->array);
-            }
+            if (--(rm->array->refcount) == 0)
+                free_realmatrix_data(rm->array);
             free(rm);
             break;
         }
@@ -240,29 +593,56 @@ void free_vartype(vartype *v) {
                 free(list->array->data);
                 free(list->array);
             }
-            free(list);
+            pool_free(&listpool, list);
+            break;
+        }
+        case TYPE_SPARSEMATRIX: {
+            vartype_sparsematrix *sm = (vartype_sparsematrix *) v;
+            if (--(sm->array->refcount) == 0) {
+                free(sm->array->rowptr);
+                free(sm->array->colidx);
+                free(sm->array->values);
+                free(sm->array);
+            }
+            free(sm);
+            break;
+        }
+        case TYPE_MAP: {
+            vartype_map *map = (vartype_map *) v;
+            if (--(map->array->refcount) == 0) {
+                for (int4 i = 0; i < map->array->capacity; i++) {
+                    if (map->array->keys[i] != NULL) {
+                        free_vartype(map->array->keys[i]);
+                        free_vartype(map->array->values[i]);
+                    }
+                }
+                free(map->array->keys);
+                free(map->array->values);
+                free(map->array);
+            }
+            free(map);
             break;
         }
     }
 }
 
 void clean_vartype_pools() {
-    while (realpool_size > 0)
-        free(realpool[--realpool_size]);
-    while (complexpool_size > 0)
-        free(complexpool[--complexpool_size]);
-    while (stringpool_size > 0)
-        free(stringpool[--stringpool_size]);
+    pool_clean(&realpool);
+    pool_clean(&complexpool);
+    pool_clean(&stringpool);
+    pool_clean(&listpool);
 }
 
 void free_long_strings(char *is_string, phloat *data, int4 n) {
+    if (is_string == NULL)
+        return;
     for (int4 i = 0; i < n; i++)
         if (is_string[i] == 2)
             free(*(void **) &data[i]);
 }
 
 void get_matrix_string(vartype_realmatrix *rm, int i, char **text, int4 *length) {
-    if (rm->array->is_string[i] == 1) {
+    if (rm->array->str(i) == 1) {
         char *t = (char *) &rm->array->data[i];
         *text = t + 1;
         *length = *t;
@@ -280,7 +660,11 @@ void get_matrix_string(const vartype_realmatrix *rm, int i, const char **text, i
 bool put_matrix_string(vartype_realmatrix *rm, int i, const char *text, int4 length) {
     char *ptext;
     int4 plength;
-    if (rm->array->is_string[i] != 0) {
+    if (!alloc_string_map(rm->array))
+        return false;
+    rm->array->hash = 0;
+    bool was_string = rm->array->is_string[i] != 0;
+    if (was_string) {
         get_matrix_string(rm, i, &ptext, &plength);
         if (plength == length) {
             memcpy(ptext, text, length);
@@ -306,9 +690,42 @@ bool put_matrix_string(vartype_realmatrix *rm, int i, const char *text, int4 len
         if (oldptr != NULL)
             free(oldptr);
     }
+    if (!was_string)
+        rm->array->nstrings++;
     return true;
 }
 
+void put_matrix_number(vartype_realmatrix *rm, int i, phloat x) {
+    char *is_string = rm->array->is_string;
+    rm->array->hash = 0;
+    if (is_string != NULL && is_string[i] != 0) {
+        if (is_string[i] == 2)
+            free(*(void **) &rm->array->data[i]);
+        is_string[i] = 0;
+        rm->array->nstrings--;
+    }
+    rm->array->data[i] = x;
+}
+
+/* The 4-level stack drops duplicate T while freeing other cells; when the
+ * cell about to be freed is a real or complex of the same type as the one
+ * being duplicated, it can simply be overwritten instead, which saves an
+ * allocation and a free in the most common case.
+ */
+bool scalar_reusable(const vartype *spare, const vartype *v) {
+    return spare != NULL && spare->type == v->type
+            && (v->type == TYPE_REAL || v->type == TYPE_COMPLEX);
+}
+
+void copy_scalar(vartype *dst, const vartype *src) {
+    if (src->type == TYPE_REAL) {
+        ((vartype_real *) dst)->x = ((vartype_real *) src)->x;
+    } else {
+        ((vartype_complex *) dst)->re = ((vartype_complex *) src)->re;
+        ((vartype_complex *) dst)->im = ((vartype_complex *) src)->im;
+    }
+}
+
 vartype *dup_vartype(const vartype *v) {
     if (v == NULL)
         return NULL;
@@ -343,66 +760,541 @@ vartype *dup_vartype(const vartype *v) {
         }
         case TYPE_STRING: {
             vartype_string *s = (vartype_string *) v;
-            return new_string(s->txt(), s->length);
+            if (s->length <= SSLENV)
+                return new_string(s->txt(), s->length);
+            vartype_string *s2 = (vartype_string *) pool_alloc(&stringpool);
+            if (s2 == NULL)
+                return NULL;
+            *s2 = *s;
+            STRING_DATA(s->t.ptr)->refcount++;
+            return (vartype *) s2;
         }
         case TYPE_LIST: {
             vartype_list *list = (vartype_list *) v;
-            vartype_list *list2 = (vartype_list *) malloc(sizeof(vartype_list));
+            vartype_list *list2 = (vartype_list *) pool_alloc(&listpool);
             if (list2 == NULL)
                 return NULL;
             *list2 = *list;
             list->array->refcount++;
             return (vartype *) list2;
         }
+        case TYPE_SPARSEMATRIX: {
+            vartype_sparsematrix *sm = (vartype_sparsematrix *) v;
+            vartype_sparsematrix *sm2 = (vartype_sparsematrix *)
+                                        malloc(sizeof(vartype_sparsematrix));
+            if (sm2 == NULL)
+                return NULL;
+            *sm2 = *sm;
+            sm->array->refcount++;
+            return (vartype *) sm2;
+        }
+        case TYPE_MAP: {
+            vartype_map *map = (vartype_map *) v;
+            vartype_map *map2 = (vartype_map *) malloc(sizeof(vartype_map));
+            if (map2 == NULL)
+                return NULL;
+            *map2 = *map;
+            map->array->refcount++;
+            return (vartype *) map2;
+        }
         default:
             return NULL;
     }
 }
 
+bool is_matrix_view(const vartype *v) {
+    if (v == NULL)
+        return false;
+    if (v->type == TYPE_REALMATRIX)
+        return ((vartype_realmatrix *) v)->is_view();
+    else if (v->type == TYPE_COMPLEXMATRIX)
+        return ((vartype_complexmatrix *) v)->is_view();
+    else
+        return false;
+}
+
+/* Returns a rows x columns view of m, starting at (row, col), sharing m's
+ * array. The caller is responsible for range checking. Views of views are
+ * composed, so a view never refers to another view.
+ */
+vartype *new_matrix_view(vartype *m, int4 row, int4 col, int4 rows, int4 columns) {
+    if (m->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) m;
+        vartype_realmatrix *v = (vartype_realmatrix *) dup_vartype(m);
+        if (v == NULL)
+            return NULL;
+        if (!rm->is_view()) {
+            v->rowstride = rm->columns;
+            v->colstride = 1;
+        }
+        v->offset = rm->index(row, col);
+        v->rows = rows;
+        v->columns = columns;
+        return (vartype *) v;
+    } else {
+        vartype_complexmatrix *cm = (vartype_complexmatrix *) m;
+        vartype_complexmatrix *v = (vartype_complexmatrix *) dup_vartype(m);
+        if (v == NULL)
+            return NULL;
+        if (!cm->is_view()) {
+            v->rowstride = cm->columns;
+            v->colstride = 1;
+        }
+        v->offset = cm->index(row, col);
+        v->rows = rows;
+        v->columns = columns;
+        return (vartype *) v;
+    }
+}
+
+vartype *new_transpose_view(vartype *m) {
+    if (m->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) m;
+        vartype_realmatrix *v = (vartype_realmatrix *) dup_vartype(m);
+        if (v == NULL)
+            return NULL;
+        if (rm->is_view()) {
+            v->rowstride = rm->colstride;
+            v->colstride = rm->rowstride;
+        } else {
+            v->offset = 0;
+            v->rowstride = 1;
+            v->colstride = rm->columns;
+        }
+        v->rows = rm->columns;
+        v->columns = rm->rows;
+        return (vartype *) v;
+    } else {
+        vartype_complexmatrix *cm = (vartype_complexmatrix *) m;
+        vartype_complexmatrix *v = (vartype_complexmatrix *) dup_vartype(m);
+        if (v == NULL)
+            return NULL;
+        if (cm->is_view()) {
+            v->rowstride = cm->colstride;
+            v->colstride = cm->rowstride;
+        } else {
+            v->offset = 0;
+            v->rowstride = 1;
+            v->colstride = cm->columns;
+        }
+        v->rows = cm->columns;
+        v->columns = cm->rows;
+        return (vartype *) v;
+    }
+}
+
+/* Makes room for at least 'capacity' nonzero elements. The matrix must
+ * not be shared; callers disentangle() first.
+ */
+bool sparse_reserve(vartype_sparsematrix *sm, int4 capacity) {
+    sparsematrix_data *sd = sm->array;
+    if (capacity <= sd->capacity)
+        return true;
+    int4 nc = sd->capacity + sd->capacity / 2;
+    if (nc < capacity)
+        nc = capacity;
+    int4 *ci = (int4 *) realloc(sd->colidx, nc * sizeof(int4));
+    if (ci == NULL)
+        return false;
+    sd->colidx = ci;
+    phloat *vals = (phloat *) realloc((void *) sd->values, nc * sizeof(phloat));
+    if (vals == NULL)
+        return false;
+    sd->values = vals;
+    sd->capacity = nc;
+    return true;
+}
+
+/* Binary search for column j in row i. Returns the position of the element
+ * if it is present, or -(insertion point) - 1 if it isn't.
+ */
+static int4 sparse_find(const vartype_sparsematrix *sm, int4 i, int4 j) {
+    const int4 *colidx = sm->array->colidx;
+    int4 lo = sm->array->rowptr[i];
+    int4 hi = sm->array->rowptr[i + 1] - 1;
+    while (lo <= hi) {
+        int4 mid = (lo + hi) / 2;
+        if (colidx[mid] < j)
+            lo = mid + 1;
+        else if (colidx[mid] > j)
+            hi = mid - 1;
+        else
+            return mid;
+    }
+    return -lo - 1;
+}
+
+phloat sparse_get(const vartype_sparsematrix *sm, int4 i, int4 j) {
+    int4 p = sparse_find(sm, i, j);
+    return p >= 0 ? sm->array->values[p] : 0;
+}
+
+/* Sets element (i, j), inserting or removing it from the nonzero structure
+ * as needed. The matrix must not be shared. Returns false if out of memory.
+ */
+bool sparse_put(vartype_sparsematrix *sm, int4 i, int4 j, phloat x) {
+    sparsematrix_data *sd = sm->array;
+    int4 p = sparse_find(sm, i, j);
+    int4 nnz = sm->nnz();
+    int4 k;
+    if (p >= 0) {
+        if (x != 0) {
+            sd->values[p] = x;
+            return true;
+        }
+        memmove(sd->colidx + p, sd->colidx + p + 1, (nnz - p - 1) * sizeof(int4));
+        memmove((void *) (sd->values + p), (const void *) (sd->values + p + 1), (nnz - p - 1) * sizeof(phloat));
+        for (k = i + 1; k <= sm->rows; k++)
+            sd->rowptr[k]--;
+        return true;
+    }
+    if (x == 0)
+        return true;
+    if (!sparse_reserve(sm, nnz + 1))
+        return false;
+    p = -p - 1;
+    memmove(sd->colidx + p + 1, sd->colidx + p, (nnz - p) * sizeof(int4));
+    memmove((void *) (sd->values + p + 1), (const void *) (sd->values + p), (nnz - p) * sizeof(phloat));
+    sd->colidx[p] = j;
+    sd->values[p] = x;
+    for (k = i + 1; k <= sm->rows; k++)
+        sd->rowptr[k]++;
+    return true;
+}
+
+vartype *sparse_to_dense(const vartype_sparsematrix *sm) {
+    vartype_realmatrix *rm = (vartype_realmatrix *)
+                                new_realmatrix(sm->rows, sm->columns);
+    if (rm == NULL)
+        return NULL;
+    for (int4 i = 0; i < sm->rows; i++) {
+        phloat *row = rm->array->data + i * sm->columns;
+        for (int4 p = sm->array->rowptr[i]; p < sm->array->rowptr[i + 1]; p++)
+            row[sm->array->colidx[p]] = sm->array->values[p];
+    }
+    return (vartype *) rm;
+}
+
+/* The caller is responsible for making sure the matrix contains no strings */
+vartype *dense_to_sparse(const vartype_realmatrix *rm) {
+    int4 i, j, nnz = 0;
+    for (i = 0; i < rm->rows; i++)
+        for (j = 0; j < rm->columns; j++)
+            if (rm->array->data[rm->index(i, j)] != 0)
+                nnz++;
+    vartype_sparsematrix *sm = (vartype_sparsematrix *)
+                                new_sparsematrix(rm->rows, rm->columns, nnz);
+    if (sm == NULL)
+        return NULL;
+    sparsematrix_data *sd = sm->array;
+    nnz = 0;
+    for (i = 0; i < rm->rows; i++) {
+        for (j = 0; j < rm->columns; j++) {
+            phloat x = rm->array->data[rm->index(i, j)];
+            if (x != 0) {
+                sd->colidx[nnz] = j;
+                sd->values[nnz] = x;
+                nnz++;
+            }
+        }
+        sd->rowptr[i + 1] = nnz;
+    }
+    return (vartype *) sm;
+}
+
+/* Map keys are reals and strings. Real keys are hashed by value, through
+ * their double equivalent, so that keys that compare equal, like 0 and -0,
+ * or decimals with different exponents, land in the same slot.
+ */
+bool is_map_key(const vartype *v) {
+    if (v->type == TYPE_STRING)
+        return true;
+    return v->type == TYPE_REAL && !p_isnan(((vartype_real *) v)->x);
+}
+
+/* FNV-1a, used both for map keys and for content_hash(). Numbers are
+ * hashed through their double value, with -0 folded into 0, so that values
+ * that compare equal hash equal even if their representations differ.
+ */
+
+#define HASH_INIT 2166136261u
+
+static uint4 hash_bytes(uint4 h, const void *data, int4 n) {
+    const unsigned char *p = (const unsigned char *) data;
+    for (int4 i = 0; i < n; i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static uint4 hash_phloat(uint4 h, phloat x) {
+    double d = to_double(x);
+    if (d == 0)
+        d = 0;
+    return hash_bytes(h, &d, sizeof(double));
+}
+
+/* Hashes scalars by value. Aggregates only contribute their type: they can
+ * be modified in place while they are elements of a list, e.g. by the
+ * matrix editor, and that must not make the cached hash of the list stale.
+ */
+static uint4 hash_element(uint4 h, const vartype *v) {
+    switch (v->type) {
+        case TYPE_REAL:
+            return hash_phloat(h, ((vartype_real *) v)->x);
+        case TYPE_COMPLEX:
+            h = hash_phloat(h, ((vartype_complex *) v)->re);
+            return hash_phloat(h, ((vartype_complex *) v)->im);
+        case TYPE_STRING: {
+            vartype_string *s = (vartype_string *) v;
+            return hash_bytes(h, s->txt(), s->length);
+        }
+        default:
+            return hash_bytes(h, &v->type, sizeof(int));
+    }
+}
+
+/* Returns a hash of the contents of v that is equal for values that are
+ * vartype_equals(). For lists and real matrices that are not views, it is
+ * computed once and cached in the shared array.
+ */
+uint4 content_hash(const vartype *v) {
+    uint4 h = HASH_INIT;
+    if (v->type == TYPE_LIST) {
+        vartype_list *list = (vartype_list *) v;
+        if (list->array->hash != 0)
+            return list->array->hash;
+        h = hash_bytes(h, &list->size, sizeof(int4));
+        for (int4 i = 0; i < list->size; i++)
+            h = hash_element(h, list->array->data[i]);
+        if (h == 0)
+            h = 1;
+        list->array->hash = h;
+    } else if (v->type == TYPE_REALMATRIX) {
+        vartype_realmatrix *rm = (vartype_realmatrix *) v;
+        if (!rm->is_view() && rm->array->hash != 0)
+            return rm->array->hash;
+        h = hash_bytes(h, &rm->rows, sizeof(int4));
+        h = hash_bytes(h, &rm->columns, sizeof(int4));
+        int4 sz = rm->rows * rm->columns;
+        for (int4 i = 0; i < sz; i++) {
+            int4 n = rm->index(i);
+            if (rm->array->str(n)) {
+                char *text;
+                int4 len;
+                get_matrix_string(rm, n, &text, &len);
+                h = hash_bytes(h, text, len);
+            } else
+                h = hash_phloat(h, rm->array->data[n]);
+        }
+        if (h == 0)
+            h = 1;
+        if (!rm->is_view())
+            rm->array->hash = h;
+    } else
+        h = hash_element(h, v);
+    return h;
+}
+
+static uint4 map_hash(const vartype *key) {
+    return hash_element(HASH_INIT, key);
+}
+
+static bool map_keys_equal(const vartype *k1, const vartype *k2) {
+    if (k1->type != k2->type)
+        return false;
+    if (k1->type == TYPE_REAL)
+        return ((vartype_real *) k1)->x == ((vartype_real *) k2)->x;
+    vartype_string *s1 = (vartype_string *) k1;
+    vartype_string *s2 = (vartype_string *) k2;
+    return string_equals(s1->txt(), s1->length, s2->txt(), s2->length);
+}
+
+/* Returns the slot holding key, or the empty slot where it would go */
+static int4 map_slot(const map_data *md, const vartype *key) {
+    int4 mask = md->capacity - 1;
+    int4 i = map_hash(key) & mask;
+    while (md->keys[i] != NULL && !map_keys_equal(md->keys[i], key))
+        i = (i + 1) & mask;
+    return i;
+}
+
+static bool map_rehash(map_data *md, int4 capacity) {
+    vartype **keys = (vartype **) malloc(capacity * sizeof(vartype *));
+    vartype **values = (vartype **) malloc(capacity * sizeof(vartype *));
+    if (keys == NULL || values == NULL) {
+        free(keys);
+        free(values);
+        return false;
+    }
+    memset(keys, 0, capacity * sizeof(vartype *));
+    vartype **oldkeys = md->keys;
+    vartype **oldvalues = md->values;
+    int4 oldcapacity = md->capacity;
+    md->keys = keys;
+    md->values = values;
+    md->capacity = capacity;
+    for (int4 i = 0; i < oldcapacity; i++) {
+        if (oldkeys[i] != NULL) {
+            int4 j = map_slot(md, oldkeys[i]);
+            keys[j] = oldkeys[i];
+            values[j] = oldvalues[i];
+        }
+    }
+    free(oldkeys);
+    free(oldvalues);
+    return true;
+}
+
+int4 map_find(const vartype_map *map, const vartype *key) {
+    int4 i = map_slot(map->array, key);
+    return map->array->keys[i] == NULL ? -1 : i;
+}
+
+/* Stores value under key, replacing any existing value. On success, the map
+ * takes ownership of key and value; on failure, the caller keeps them. The
+ * map must not be shared; see disentangle().
+ */
+bool map_put(vartype_map *map, vartype *key, vartype *value) {
+    map_data *md = map->array;
+    int4 i = map_slot(md, key);
+    if (md->keys[i] != NULL) {
+        free_vartype(md->values[i]);
+        md->values[i] = value;
+        free_vartype(key);
+        return true;
+    }
+    if ((md->size + 1) * 2 > md->capacity) {
+        if (md->capacity > 0x3fffffff / (int4) sizeof(vartype *)
+                || !map_rehash(md, md->capacity * 2))
+            return false;
+        i = map_slot(md, key);
+    }
+    md->keys[i] = key;
+    md->values[i] = value;
+    md->size++;
+    return true;
+}
+
+/* Removes key and its value from the map, which must not be shared.
+ * Returns false if the key was not present.
+ */
+bool map_remove(vartype_map *map, const vartype *key) {
+    map_data *md = map->array;
+    int4 i = map_find(map, key);
+    if (i == -1)
+        return false;
+    free_vartype(md->keys[i]);
+    free_vartype(md->values[i]);
+    md->keys[i] = NULL;
+    md->size--;
+    /* Close the gap: move later entries of the probe sequence into it,
+     * unless that would put them before their home slot.
+     */
+    int4 mask = md->capacity - 1;
+    int4 j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (md->keys[j] == NULL)
+            break;
+        int4 k = map_hash(md->keys[j]) & mask;
+        if (i <= j ? i < k && k <= j : i < k || k <= j)
+            continue;
+        md->keys[i] = md->keys[j];
+        md->values[i] = md->values[j];
+        md->keys[j] = NULL;
+        i = j;
+    }
+    return true;
+}
+
+/* Copies the elements of rm, in row-major order, into a new unshared array,
+ * duplicating any long strings.
+ */
+static realmatrix_data *copy_realmatrix_data(const vartype_realmatrix *rm) {
+    int4 sz = rm->rows * rm->columns;
+    realmatrix_data *md = new_realmatrix_data(sz);
+    if (md == NULL)
+        return NULL;
+    if (rm->array->is_string != NULL && !alloc_string_map(md)) {
+        free(md);
+        return NULL;
+    }
+    for (int4 n = 0; n < sz; n++) {
+        int4 k = rm->index(n);
+        char s = rm->array->str(k);
+        if (s != 0) {
+            md->is_string[n] = s;
+            md->nstrings++;
+        }
+        if (s == 2) {
+            int4 *sp = *(int4 **) &rm->array->data[k];
+            int4 len = *sp + 4;
+            int4 *dp = (int4 *) malloc(len);
+            if (dp == NULL) {
+                md->size = n;
+                free_realmatrix_data(md);
+                return NULL;
+            }
+            memcpy(dp, sp, len);
+            *(int4 **) &md->data[n] = dp;
+        } else {
+            md->data[n] = rm->array->data[k];
+        }
+    }
+    return md;
+}
+
+static bool materialize_view(vartype_realmatrix *rm) {
+    realmatrix_data *md = copy_realmatrix_data(rm);
+    if (md == NULL)
+        return false;
+    if (--(rm->array->refcount) == 0)
+        free_realmatrix_data(rm->array);
+    rm->array = md;
+    rm->offset = rm->rowstride = rm->colstride = 0;
+    return true;
+}
+
+static bool materialize_view(vartype_complexmatrix *cm) {
+    complexmatrix_data *md = (complexmatrix_data *)
+                                malloc(sizeof(complexmatrix_data));
+    if (md == NULL)
+        return false;
+    md->data = (phloat *) malloc(cm->rows * cm->columns * 2 * sizeof(phloat));
+    if (md->data == NULL) {
+        free(md);
+        return false;
+    }
+    int4 n = 0;
+    for (int4 i = 0; i < cm->rows; i++)
+        for (int4 j = 0; j < cm->columns; j++) {
+            int4 k = cm->index(i, j) * 2;
+            md->data[n++] = cm->array->data[k];
+            md->data[n++] = cm->array->data[k + 1];
+        }
+    md->refcount = 1;
+    if (--(cm->array->refcount) == 0) {
+        free(cm->array->data);
+        free(cm->array);
+    }
+    cm->array = md;
+    cm->offset = cm->rowstride = cm->colstride = 0;
+    return true;
+}
+
 bool disentangle(vartype *v) {
     switch (v->type) {
         case TYPE_REALMATRIX: {
             vartype_realmatrix *rm = (vartype_realmatrix *) v;
-            if (rm->array->refcount == 1)
+            if (rm->is_view())
+                return materialize_view(rm);
+            if (rm->array->refcount == 1) {
+                rm->array->hash = 0;
                 return true;
-            else {
-                realmatrix_data *md = (realmatrix_data *)
-                                        malloc(sizeof(realmatrix_data));
+            } else {
+                realmatrix_data *md = copy_realmatrix_data(rm);
                 if (md == NULL)
                     return false;
-                int4 sz = rm->rows * rm->columns;
-                int4 i;
-                md->data = (phloat *) malloc(sz * sizeof(phloat));
-                if (md->data == NULL) {
-                    free(md);
-                    return false;
-                }
-                md->is_string = (char *) malloc(sz);
-                if (md->is_string == NULL) {
-                    free(md->data);
-                    free(md);
-                    return false;
-                }
-                for (i = 0; i < sz; i++) {
-                    md->is_string[i] = rm->array->is_string[i];
-                    if (md->is_string[i] == 2) {
-                        int4 *sp = *(int4 **) &rm->array->data[i];
-                        int4 len = *sp + 4;
-                        int4 *dp = (int4 *) malloc(len);
-                        if (dp == NULL) {
-                            free_long_strings(md->is_string, md->data, i);
-                            free(md->is_string);
-                            free(md->data);
-                            free(md);
-                            return false;
-                        }
-                        memcpy(dp, sp, len);
-                        *(int4 **) &md->data[i] = dp;
-                    } else {
-                        md->data[i] = rm->array->data[i];
-                    }
-                }
-                md->refcount = 1;
                 rm->array->refcount--;
                 rm->array = md;
                 return true;
@@ -410,6 +1302,8 @@ bool disentangle(vartype *v) {
         }
         case TYPE_COMPLEXMATRIX: {
             vartype_complexmatrix *cm = (vartype_complexmatrix *) v;
+            if (cm->is_view())
+                return materialize_view(cm);
             if (cm->array->refcount == 1)
                 return true;
             else {
@@ -434,9 +1328,10 @@ bool disentangle(vartype *v) {
         }
         case TYPE_LIST: {
             vartype_list *list = (vartype_list *) v;
-            if (list->array->refcount == 1)
+            if (list->array->refcount == 1) {
+                list->array->hash = 0;
                 return true;
-            else {
+            } else {
                 list_data *ld = (list_data *) malloc(sizeof(list_data));
                 if (ld == NULL)
                     return false;
@@ -460,20 +1355,254 @@ bool disentangle(vartype *v) {
                     ld->data[i] = vv;
                 }
                 ld->refcount = 1;
+                ld->capacity = list->size;
+                ld->hash = 0;
                 list->array->refcount--;
                 list->array = ld;
                 return true;
             }
         }
+        case TYPE_SPARSEMATRIX: {
+            vartype_sparsematrix *sm = (vartype_sparsematrix *) v;
+            if (sm->array->refcount == 1)
+                return true;
+            else {
+                sparsematrix_data *sd = (sparsematrix_data *)
+                                            malloc(sizeof(sparsematrix_data));
+                if (sd == NULL)
+                    return false;
+                int4 nnz = sm->nnz();
+                int4 cap = nnz < 1 ? 1 : nnz;
+                sd->rowptr = (int4 *) malloc((sm->rows + 1) * sizeof(int4));
+                sd->colidx = (int4 *) malloc(cap * sizeof(int4));
+                sd->values = (phloat *) malloc(cap * sizeof(phloat));
+                if (sd->rowptr == NULL || sd->colidx == NULL
+                        || sd->values == NULL) {
+                    free(sd->rowptr);
+                    free(sd->colidx);
+                    free(sd->values);
+                    free(sd);
+                    return false;
+                }
+                memcpy(sd->rowptr, sm->array->rowptr, (sm->rows + 1) * sizeof(int4));
+                memcpy(sd->colidx, sm->array->colidx, nnz * sizeof(int4));
+                for (int4 i = 0; i < nnz; i++)
+                    sd->values[i] = sm->array->values[i];
+                sd->capacity = cap;
+                sd->refcount = 1;
+                sm->array->refcount--;
+                sm->array = sd;
+                return true;
+            }
+        }
+        case TYPE_MAP: {
+            vartype_map *map = (vartype_map *) v;
+            if (map->array->refcount == 1)
+                return true;
+            map_data *md = (map_data *) malloc(sizeof(map_data));
+            if (md == NULL)
+                return false;
+            int4 cap = map->array->capacity;
+            md->keys = (vartype **) malloc(cap * sizeof(vartype *));
+            md->values = (vartype **) malloc(cap * sizeof(vartype *));
+            if (md->keys == NULL || md->values == NULL) {
+                nomem:
+                free(md->keys);
+                free(md->values);
+                free(md);
+                return false;
+            }
+            memset(md->keys, 0, cap * sizeof(vartype *));
+            /* Same capacity, so every entry can stay in the same slot */
+            for (int4 i = 0; i < cap; i++) {
+                if (map->array->keys[i] == NULL)
+                    continue;
+                md->keys[i] = dup_vartype(map->array->keys[i]);
+                md->values[i] = dup_vartype(map->array->values[i]);
+                if (md->keys[i] == NULL || md->values[i] == NULL) {
+                    free_vartype(md->keys[i]);
+                    free_vartype(md->values[i]);
+                    for (int4 j = 0; j < i; j++) {
+                        if (md->keys[j] != NULL) {
+                            free_vartype(md->keys[j]);
+                            free_vartype(md->values[j]);
+                        }
+                    }
+                    goto nomem;
+                }
+            }
+            md->size = map->array->size;
+            md->capacity = cap;
+            md->refcount = 1;
+            map->array->refcount--;
+            map->array = md;
+            return true;
+        }
+        case TYPE_STRING: {
+            vartype_string *s = (vartype_string *) v;
+            if (s->length <= SSLENV || STRING_DATA(s->t.ptr)->refcount == 1)
+                return true;
+            char *text = new_string_text(s->length);
+            if (text == NULL)
+                return false;
+            memcpy(text, s->t.ptr, s->length);
+            STRING_DATA(s->t.ptr)->refcount--;
+            s->t.ptr = text;
+            return true;
+        }
         case TYPE_REAL:
         case TYPE_COMPLEX:
-        case TYPE_STRING:
         default:
             return true;
     }
 }
 
+/* Hash index over vars[], mapping each name to the entry lookup_var()
+ * should find: the last one with that name that isn't hidden or private.
+ * Slots hold the vars[] index plus one, with 0 meaning empty. Code that
+ * changes vars[] keeps the index up to date as it goes: var_index_add()
+ * when an entry becomes visible, var_index_remove() before a visible entry
+ * is deleted, and var_index_move() when one is moved to a new position.
+ * Only state loading and purge_all_vars() call invalidate_var_index(),
+ * which makes the next lookup rebuild the whole table. If the table can't be allocated, lookups
+ * fall back to scanning vars[].
+ */
+static int *var_index = NULL;
+static int var_index_size = 0;
+static bool var_index_valid = false;
+
+/* vars[] index of the visible REGS, for recall_regs(); -2 means unknown.
+ * Reset by anything that could change which entry lookup_var() finds.
+ */
+static int regs_varindex = -2;
+
+static unsigned int var_hash(const char *name, int namelength) {
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < namelength; i++)
+        h = (h ^ (unsigned char) name[i]) * 16777619u;
+    return h;
+}
+
+static void var_index_put(int varindex) {
+    var_struct *v = vars + varindex;
+    int mask = var_index_size - 1;
+    int slot = var_hash(v->name, v->length) & mask;
+    while (var_index[slot] != 0) {
+        var_struct *w = vars + var_index[slot] - 1;
+        if (string_equals(w->name, w->length, v->name, v->length))
+            break;
+        slot = (slot + 1) & mask;
+    }
+    var_index[slot] = varindex + 1;
+}
+
+static bool rebuild_var_index() {
+    int size = 16;
+    while (size < vars_count * 2)
+        size <<= 1;
+    if (size != var_index_size) {
+        free(var_index);
+        var_index = (int *) malloc(size * sizeof(int));
+        if (var_index == NULL) {
+            var_index_size = 0;
+            return false;
+        }
+        var_index_size = size;
+    }
+    memset(var_index, 0, size * sizeof(int));
+    for (int i = 0; i < vars_count; i++)
+        if ((vars[i].flags & (VAR_HIDDEN | VAR_PRIVATE)) == 0)
+            var_index_put(i);
+    var_index_valid = true;
+    return true;
+}
+
+/* Returns the slot holding vars[varindex], or -1 if it isn't indexed */
+static int var_index_find(int varindex) {
+    var_struct *v = vars + varindex;
+    int mask = var_index_size - 1;
+    int slot = var_hash(v->name, v->length) & mask;
+    while (var_index[slot] != 0) {
+        if (var_index[slot] == varindex + 1)
+            return slot;
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+void invalidate_var_index() {
+    var_index_valid = false;
+    regs_varindex = -2;
+}
+
+/* Called after vars[varindex] has become visible, either because it was
+ * appended, or because the local that was hiding it went away.
+ */
+void var_index_add(int varindex) {
+    regs_varindex = -2;
+    if (!var_index_valid)
+        return;
+    if (vars_count * 2 > var_index_size)
+        var_index_valid = false;
+    else
+        var_index_put(varindex);
+}
+
+/* Called before the visible variable at vars[varindex] is deleted. The
+ * slot is emptied by moving later entries of the same probe sequence
+ * back, so lookups never need tombstones.
+ */
+void var_index_remove(int varindex) {
+    regs_varindex = -2;
+    if (!var_index_valid)
+        return;
+    int hole = var_index_find(varindex);
+    if (hole == -1)
+        return;
+    int mask = var_index_size - 1;
+    for (int slot = (hole + 1) & mask; var_index[slot] != 0; slot = (slot + 1) & mask) {
+        var_struct *w = vars + var_index[slot] - 1;
+        int home = var_hash(w->name, w->length) & mask;
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            var_index[hole] = var_index[slot];
+            hole = slot;
+        }
+    }
+    var_index[hole] = 0;
+}
+
+/* Called after a visible variable has been moved from vars[from] to
+ * vars[to]. When several entries are moved down, this must be called in
+ * ascending order, so an old index is never mistaken for a new one.
+ */
+void var_index_move(int from, int to) {
+    regs_varindex = -2;
+    if (!var_index_valid)
+        return;
+    var_struct *v = vars + to;
+    int mask = var_index_size - 1;
+    int slot = var_hash(v->name, v->length) & mask;
+    while (var_index[slot] != 0) {
+        if (var_index[slot] == from + 1) {
+            var_index[slot] = to + 1;
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
 int lookup_var(const char *name, int namelength) {
+    if (var_index_valid || rebuild_var_index()) {
+        int mask = var_index_size - 1;
+        int slot = var_hash(name, namelength) & mask;
+        while (var_index[slot] != 0) {
+            int i = var_index[slot] - 1;
+            if (string_equals(vars[i].name, vars[i].length, name, namelength))
+                return i;
+            slot = (slot + 1) & mask;
+        }
+        return -1;
+    }
     int i, j;
     for (i = vars_count - 1; i >= 0; i--) {
         if ((vars[i].flags & (VAR_HIDDEN | VAR_PRIVATE)) != 0)
@@ -497,6 +1626,15 @@ vartype *recall_var(const char *name, int namelength) {
         return vars[varindex].value;
 }
 
+/* Same as recall_var("REGS", 4), but without the lookup in the common
+ * case; the numbered register and statistics commands use this.
+ */
+vartype *recall_regs() {
+    if (regs_varindex == -2)
+        regs_varindex = lookup_var("REGS", 4);
+    return regs_varindex == -1 ? NULL : vars[regs_varindex].value;
+}
+
 bool ensure_var_space(int n) {
     int nc = vars_count + n;
     if (nc > vars_capacity) {
@@ -510,6 +1648,11 @@ bool ensure_var_space(int n) {
 }
 
 int store_var(const char *name, int namelength, vartype *value, bool local) {
+    /* Variables never hold views; INDEX, the matrix editor, DIM, etc.,
+     * all access variables directly, without going through handle().
+     */
+    if (is_matrix_view(value) && !disentangle(value))
+        return ERR_INSUFFICIENT_MEMORY;
     int varindex = lookup_var(name, namelength);
     int i;
     if (varindex == -1) {
@@ -528,6 +1671,9 @@ int store_var(const char *name, int namelength, vartype *value, bool local) {
             vars[varindex].name[i] = name[i];
         vars[varindex].level = local ? get_rtn_level() : -1;
         vars[varindex].flags = 0;
+        if (local)
+            local_vars_count++;
+        var_index_add(varindex);
     } else if (local && vars[varindex].level < get_rtn_level()) {
         /* Create local that hides an existing variable */
         if (vars_count == vars_capacity) {
@@ -545,6 +1691,8 @@ int store_var(const char *name, int namelength, vartype *value, bool local) {
             vars[varindex].name[i] = name[i];
         vars[varindex].level = get_rtn_level();
         vars[varindex].flags = VAR_HIDING;
+        local_vars_count++;
+        var_index_add(varindex);
     } else {
         /* Update existing variable */
         if (matedit_mode == 1 &&
@@ -552,6 +1700,7 @@ int store_var(const char *name, int namelength, vartype *value, bool local) {
                 string_equals(name, namelength, matedit_name, matedit_length)) {
             if (value->type == TYPE_REALMATRIX
                     || value->type == TYPE_COMPLEXMATRIX
+                    || value->type == TYPE_SPARSEMATRIX
                     || value->type == TYPE_LIST) {
                 matedit_i = matedit_j = 0;
             } else {
@@ -596,15 +1745,22 @@ bool purge_var(const char *name, int namelength, bool global, bool local) {
         matedit_stack_depth = 0;
     }
     free_vartype(vars[varindex].value);
+    if (vars[varindex].level != -1)
+        local_vars_count--;
+    var_index_remove(varindex);
     if ((vars[varindex].flags & VAR_HIDING) != 0) {
         for (int i = varindex - 1; i >= 0; i--)
             if ((vars[i].flags & VAR_HIDDEN) != 0 && string_equals(vars[i].name, vars[i].length, name, namelength)) {
                 vars[i].flags &= ~VAR_HIDDEN;
+                var_index_add(i);
                 break;
             }
     }
-    for (int i = varindex; i < vars_count - 1; i++)
+    for (int i = varindex; i < vars_count - 1; i++) {
         vars[i] = vars[i + 1];
+        if ((vars[i].flags & (VAR_HIDDEN | VAR_PRIVATE)) == 0)
+            var_index_move(i + 1, i);
+    }
     vars_count--;
     update_catalog();
     return true;
@@ -615,6 +1771,11 @@ void purge_all_vars() {
     for (i = 0; i < vars_count; i++)
         free_vartype(vars[i].value);
     vars_count = 0;
+    local_vars_count = 0;
+    free(var_index);
+    var_index = NULL;
+    var_index_size = 0;
+    invalidate_var_index();
 }
 
 bool vars_exist(int section) {
@@ -642,6 +1803,7 @@ bool vars_exist(int section) {
                     break;
             case TYPE_REALMATRIX:
             case TYPE_COMPLEXMATRIX:
+            case TYPE_SPARSEMATRIX:
                 if (section == CATSECT_MAT || section == CATSECT_MAT_LIST)
                     return true;
                 else
@@ -651,15 +1813,24 @@ bool vars_exist(int section) {
                     return true;
                 else
                     break;
+            case TYPE_MAP:
+                if (section == CATSECT_LIST)
+                    return true;
+                else
+                    break;
         }
     }
     return false;
 }
 
 bool contains_strings(const vartype_realmatrix *rm) {
+    if (rm->array->nstrings == 0)
+        return false;
+    if (!rm->is_view())
+        return true;
     int4 size = rm->rows * rm->columns;
     for (int4 i = 0; i < size; i++)
-        if (rm->array->is_string[i] != 0)
+        if (rm->array->is_string[rm->index(i)] != 0)
             return true;
     return false;
 }
@@ -678,8 +1849,12 @@ int matrix_copy(vartype *dst, const vartype *src) {
             if (contains_strings(s))
                 return ERR_ALPHA_DATA_IS_INVALID;
             int4 size = s->rows * s->columns;
-            free_long_strings(d->array->is_string, d->array->data, size);
-            memset(d->array->is_string, 0, size);
+            if (d->array->is_string != NULL) {
+                free_long_strings(d->array->is_string, d->array->data, size);
+                free(d->array->is_string);
+                d->array->is_string = NULL;
+                d->array->nstrings = 0;
+            }
             memcpy((void *) d->array->data, (const void *) s->array->data, size * sizeof(phloat));
             return ERR_NONE;
         } else if (dst->type == TYPE_COMPLEXMATRIX) {
@@ -744,9 +1919,13 @@ vartype *recall_and_purge_private_var(const char *name, int namelength) {
     if (varindex == -1)
         return NULL;
     vartype *ret = vars[varindex].value;
-    for (int i = varindex; i < vars_count - 1; i++)
+    for (int i = varindex; i < vars_count - 1; i++) {
         vars[i] = vars[i + 1];
+        if ((vars[i].flags & (VAR_HIDDEN | VAR_PRIVATE)) == 0)
+            var_index_move(i + 1, i);
+    }
     vars_count--;
+    local_vars_count--;
     return ret;
 }
 
@@ -768,6 +1947,7 @@ int store_private_var(const char *name, int namelength, vartype *value) {
             vars[varindex].name[i] = name[i];
         vars[varindex].level = get_rtn_level();
         vars[varindex].flags = VAR_PRIVATE;
+        local_vars_count++;
     } else {
         free_vartype(vars[varindex].value);
     }
@@ -31,6 +31,8 @@
 #define TYPE_COMPLEXMATRIX 4
 #define TYPE_STRING 5
 #define TYPE_LIST 6
+#define TYPE_SPARSEMATRIX 7
+#define TYPE_MAP 8
 
 struct vartype {
     int type;
@@ -49,17 +51,58 @@ struct vartype_complex {
 };
 
 
+/* The descriptor and its elements live in a single block, allocated by
+ * new_realmatrix_data(); data points just past the descriptor. is_string
+ * is a separate block, and is only allocated once a string is stored in
+ * the matrix; while it is NULL, all elements are numbers. Use str() to
+ * read it and put_matrix_number() or put_matrix_string() to change it.
+ * size is the element count, so the last reference can free the array
+ * properly even if that reference is a view; capacity is the number of
+ * elements that data, and is_string if present, have room for, which
+ * resize_realmatrix_data() keeps ahead of size. nstrings is the number of
+ * nonzero entries in is_string; anything that writes is_string directly
+ * must keep it up to date. hash caches content_hash() of the matrices that
+ * use the array without a view, or is 0 if it hasn't been computed yet;
+ * disentangle(), dimension_array_ref(), and put_matrix_number() and
+ * put_matrix_string() clear it, so code that writes data in place, like the
+ * statistics functions updating REGS, must call disentangle() first.
+ */
 struct realmatrix_data {
     int refcount;
+    int4 size;
+    int4 capacity;
+    int4 nstrings;
+    uint4 hash;
     phloat *data;
     char *is_string;
+    char str(int4 i) const {
+        return is_string == NULL ? 0 : is_string[i];
+    }
 };
 
+/* A matrix whose rowstride is nonzero is a view: it shares its array with
+ * another matrix, and element (i, j) lives at
+ * offset + i * rowstride + j * colstride. Views are produced by TRANS and
+ * GETM, and are turned into ordinary dense matrices by disentangle().
+ */
 struct vartype_realmatrix {
     int type;
     int4 rows;
     int4 columns;
     realmatrix_data *array;
+    int4 offset;
+    int4 rowstride;
+    int4 colstride;
+    bool is_view() const {
+        return rowstride != 0;
+    }
+    int4 index(int4 i, int4 j) const {
+        return rowstride == 0 ? i * columns + j
+                              : offset + i * rowstride + j * colstride;
+    }
+    int4 index(int4 n) const {
+        return rowstride == 0 ? n : index(n / columns, n % columns);
+    }
 };
 
 
@@ -68,11 +111,51 @@ struct complexmatrix_data {
     phloat *data;
 };
 
+/* Same view layout as vartype_realmatrix; the index is in complex
+ * elements, so the phloat offset is twice index().
+ */
 struct vartype_complexmatrix {
     int type;
     int4 rows;
     int4 columns;
     complexmatrix_data *array;
+    int4 offset;
+    int4 rowstride;
+    int4 colstride;
+    bool is_view() const {
+        return rowstride != 0;
+    }
+    int4 index(int4 i, int4 j) const {
+        return rowstride == 0 ? i * columns + j
+                              : offset + i * rowstride + j * colstride;
+    }
+    int4 index(int4 n) const {
+        return rowstride == 0 ? n : index(n / columns, n % columns);
+    }
+};
+
+
+/* Sparse real matrix, in compressed sparse row form: the nonzero elements of
+ * row i are at positions rowptr[i] through rowptr[i + 1] - 1 of colidx and
+ * values, in increasing column order. Zeros are never stored, and there are
+ * no strings; rowptr[rows] is the number of nonzero elements.
+ */
+struct sparsematrix_data {
+    int refcount;
+    int4 capacity;
+    int4 *rowptr;
+    int4 *colidx;
+    phloat *values;
+};
+
+struct vartype_sparsematrix {
+    int type;
+    int4 rows;
+    int4 columns;
+    sparsematrix_data *array;
+    int4 nnz() const {
+        return array->rowptr[rows];
+    }
 };
 
 
@@ -81,6 +164,20 @@ struct vartype_complexmatrix {
 /* Maximum short string length in a matrix element */
 #define SSLENM ((int) sizeof(phloat) - 1)
 
+/* The text of a long string lives in a heap block that starts with this
+ * descriptor; t.ptr points just past it. capacity may exceed length, so that
+ * APPEND and EXTEND can grow a string in place; it is never persisted and
+ * plays no part in comparisons. The block is shared between copies made by
+ * dup_vartype(), like matrix data, so anything that modifies a string's text
+ * in place must call disentangle() on it first.
+ */
+struct string_data {
+    int refcount;
+    int4 capacity;
+};
+
+#define STRING_DATA(ptr) (((string_data *) (ptr)) - 1)
+
 struct vartype_string {
     int type;
     int4 length;
@@ -99,8 +196,16 @@ struct vartype_string {
 };
 
 
+/* data has room for capacity elements, of which the owning list uses the
+ * first size; the rest are unused, so appending to a list that isn't shared
+ * needs no reallocation until the spare room runs out. Code that replaces
+ * data must set capacity to match. hash caches content_hash(), like in
+ * realmatrix_data, and is cleared by disentangle() and dimension_array_ref().
+ */
 struct list_data {
     int refcount;
+    int4 capacity;
+    uint4 hash;
     vartype **data;
 };
 
@@ -111,22 +216,83 @@ struct vartype_list {
 };
 
 
+/* Associative map from real or string keys to values of any type, stored as
+ * an open-addressing hash table with linear probing. keys[i] == NULL marks an
+ * empty slot. capacity is a power of two, at least twice size, so probe
+ * sequences stay short; removal shifts later entries of a probe sequence
+ * back, so there are no tombstones. Shared copy-on-write like lists.
+ */
+struct map_data {
+    int refcount;
+    int4 size;
+    int4 capacity;
+    vartype **keys;
+    vartype **values;
+};
+
+struct vartype_map {
+    int type;
+    map_data *array;
+};
+
+
 vartype *new_real(phloat value);
 vartype *new_complex(phloat re, phloat im);
 vartype *new_string(const char *s, int slen);
+char *new_string_text(int4 capacity);
+void free_string_text(char *ptr);
+bool reserve_string(vartype_string *s, int4 length);
+bool reserve_list(vartype_list *list, int4 size);
 vartype *new_realmatrix(int4 rows, int4 columns);
+realmatrix_data *new_realmatrix_data(int4 size);
+realmatrix_data *resize_realmatrix_data(realmatrix_data *md, int4 size);
+void free_realmatrix_data(realmatrix_data *md);
+bool alloc_string_map(realmatrix_data *md);
 vartype *new_complexmatrix(int4 rows, int4 columns);
 vartype *new_list(int4 size);
+vartype *new_sparsematrix(int4 rows, int4 columns, int4 capacity);
+vartype *new_map(int4 size);
 void free_vartype(vartype *v);
 void clean_vartype_pools();
+
+/* Counters for the slab pools new_real(), new_complex(), new_string(), and
+ * new_list() allocate from, for diagnostics. */
+struct vartype_pool_stats {
+    int4 slabs;     // slabs currently allocated
+    int4 in_use;    // objects handed out and not yet freed
+    int4 free;      // objects on the free list
+    int4 allocs;    // total number of allocations
+};
+bool get_vartype_pool_stats(int type, vartype_pool_stats *stats);
 void free_long_strings(char *is_string, phloat *data, int4 n);
 void get_matrix_string(vartype_realmatrix *rm, int4 i, char **text, int4 *length);
 void get_matrix_string(const vartype_realmatrix *rm, int4 i, const char **text, int4 *length);
 bool put_matrix_string(vartype_realmatrix *rm, int4 i, const char *text, int4 length);
+void put_matrix_number(vartype_realmatrix *rm, int4 i, phloat x);
 vartype *dup_vartype(const vartype *v);
+bool scalar_reusable(const vartype *spare, const vartype *v);
+void copy_scalar(vartype *dst, const vartype *src);
 bool disentangle(vartype *v);
+bool is_matrix_view(const vartype *v);
+vartype *new_matrix_view(vartype *m, int4 row, int4 col, int4 rows, int4 columns);
+vartype *new_transpose_view(vartype *m);
+bool sparse_reserve(vartype_sparsematrix *sm, int4 capacity);
+phloat sparse_get(const vartype_sparsematrix *sm, int4 i, int4 j);
+bool sparse_put(vartype_sparsematrix *sm, int4 i, int4 j, phloat x);
+vartype *sparse_to_dense(const vartype_sparsematrix *sm);
+uint4 content_hash(const vartype *v);
+bool is_map_key(const vartype *v);
+int4 map_find(const vartype_map *map, const vartype *key);
+bool map_put(vartype_map *map, vartype *key, vartype *value);
+bool map_remove(vartype_map *map, const vartype *key);
+vartype *dense_to_sparse(const vartype_realmatrix *rm);
 int lookup_var(const char *name, int namelength);
+void invalidate_var_index();
+void var_index_add(int varindex);
+void var_index_remove(int varindex);
+void var_index_move(int from, int to);
 vartype *recall_var(const char *name, int namelength);
+vartype *recall_regs();
 bool ensure_var_space(int n);
 int store_var(const char *name, int namelength, vartype *value, bool local = false);
 bool purge_var(const char *name, int namelength, bool global = true, bool local = true);
@@ -172,6 +172,7 @@ static void exportProgramCB();
 static GtkWidget *make_file_select_dialog(
         const char *title, const char *pattern, bool save, GtkWidget *owner);
 static void importProgramCB();
+static void importSigmaCB();
 static void paperAdvanceCB();
 static void copyPrintAsTextCB();
 static void copyPrintAsImageCB();
@@ -258,6 +259,11 @@ static const char *mainWindowXml =
                         "<property name='label'>Import Programs...</property>"
                       "</object>"
                     "</child>"
+                    "<child>"
+                      "<object class='GtkMenuItem' id='import_sigma_item'>"
+                        "<property name='label'>Import Statistics Data...</property>"
+                      "</object>"
+                    "</child>"
                     "<child>"
                       "<object class='GtkMenuItem' id='export_programs_item'>"
                         "<property name='label'>Export Programs...</property>"
@@ -698,6 +704,8 @@ static void activate(GtkApplication *theApp, gpointer userData) {
     g_signal_connect(G_OBJECT(item), "activate", G_CALLBACK(paperAdvanceCB), NULL);
     item = GTK_MENU_ITEM(gtk_builder_get_object(builder, "import_programs_item"));
     g_signal_connect(G_OBJECT(item), "activate", G_CALLBACK(importProgramCB), NULL);
+    item = GTK_MENU_ITEM(gtk_builder_get_object(builder, "import_sigma_item"));
+    g_signal_connect(G_OBJECT(item), "activate", G_CALLBACK(importSigmaCB), NULL);
     item = GTK_MENU_ITEM(gtk_builder_get_object(builder, "export_programs_item"));
     g_signal_connect(G_OBJECT(item), "activate", G_CALLBACK(exportProgramCB), NULL);
     item = GTK_MENU_ITEM(gtk_builder_get_object(builder, "preferences_item"));
@@ -2204,6 +2212,38 @@ static void importProgramCB() {
     redisplay();
 }
 
+static void importSigmaCB() {
+    static GtkWidget *dialog = NULL;
+
+    if (dialog == NULL)
+        dialog = make_file_select_dialog("Import Statistics Data",
+                "CSV Files (*.csv)\0*.[Cc][Ss][Vv]\0All Files (*.*)\0*\0",
+                false, mainwindow);
+
+    gtk_window_set_role(GTK_WINDOW(dialog), "Free42 Dialog");
+    bool cancelled = gtk_dialog_run(GTK_DIALOG(dialog)) != GTK_RESPONSE_ACCEPT;
+    gtk_widget_hide(dialog);
+    if (cancelled)
+        return;
+
+    char *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+    if (filename == NULL)
+        return;
+
+    char filenamebuf[FILENAMELEN];
+    strncpy(filenamebuf, filename, FILENAMELEN);
+    filenamebuf[FILENAMELEN - 1] = 0;
+    g_free(filename);
+
+    if (strncmp(gtk_file_filter_get_name(
+                    gtk_file_chooser_get_filter(
+                        GTK_FILE_CHOOSER(dialog))), "All", 3) != 0)
+        appendSuffix(filenamebuf, ".csv");
+
+    core_import_sigma(filenamebuf);
+    redisplay();
+}
+
 static void paperAdvanceCB() {
     static const char *bits = "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0";
     shell_print("", 0, bits, 18, 0, 0, 143, 9);